@@ -0,0 +1,68 @@
+/*
+  SafeStringChain.ino
+
+  This example builds a web page from three smaller SafeStrings linked in a SafeStringChain
+  instead of one large SafeString sized for the worst case.
+  The page is printed one segment at a time, without copying the segments together.
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  download and install the SafeString library from Arduino library manager
+  or from www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "SafeStringChain.h"
+
+createSafeStringChain(page, 3);
+cSF(header, 60);
+cSF(body1, 60);
+cSF(body2, 60);
+
+void buildPage(int reading) {
+  page.clear(); // clears all the segments
+  header = F("HTTP/1.1 200 OK\r\nContent-Type: text/html\r\n\r\n"); // can fill a segment directly
+  page.print(F("<html><body><h1>Readings</h1>")); // spills from header into body1
+  for (int i = 0; i < 4; i++) {
+    page.print(F("<p>A")); page.print(i); page.print(F(" = ")); page.print(reading + i * 100); page.print(F("</p>"));
+  }
+  page.print(F("</body></html>"));
+}
+
+void setup() {
+  Serial.begin(9600);    // Open serial communications and wait a few seconds
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+  SafeString::setOutput(Serial); // enable error messages and debug() output to be sent to Serial
+
+  page.addSegment(header);
+  page.addSegment(body1);
+  page.addSegment(body2);
+
+  buildPage(analogRead(A0));
+  Serial.print(F("Page length ")); Serial.print(page.length()); Serial.print(F(" of capacity ")); Serial.println(page.capacity());
+  Serial.println(page); // prints each segment in turn
+
+  // for a non-blocking output, e.g. a WiFiClient, writeTo( ) returns where to continue from
+  size_t idx = 0;
+  while (idx < page.length()) {
+    idx = page.writeTo(Serial, idx);
+  }
+  Serial.println();
+
+  Serial.println(F("Add too much to the page"));
+  for (int i = 0; i < 10; i++) {
+    page.print(F("<p>more</p>"));
+  }
+  if (page.hasError()) {
+    Serial.println(F(" the adds that did not fit were not added"));
+  }
+}
+
+void loop() {
+}
@@ -0,0 +1,125 @@
+/*
+  SafeStringJsonTokenizer.ino
+
+  This example reads JSON config messages a chunk at a time from a SafeStringStream
+  and prints each key and value as it is found, without ever holding the whole message.
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  download and install the SafeString library from Arduino library manager
+  or from www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "SafeStringStream.h"
+#include "SafeStringJsonTokenizer.h"
+
+#define TEST_DATA
+
+#ifdef TEST_DATA
+const uint32_t TESTING_BAUD_RATE = 9600; // how fast to release the data from sfStream to be read by this sketch
+SafeStringStream sfStream;
+cSF(sfTestData, 200);
+#endif
+
+// keys and values upto 20 chars, nested upto 8 deep
+createSafeStringJsonTokenizer(json, 20, 8);
+cSF(sfInput, 16); // only 16 chars of input are held at any one time
+
+Stream *inputPtr = &Serial;
+
+void setup() {
+  Serial.begin(9600);    // Open serial communications and wait a few seconds
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+  SafeString::setOutput(Serial); // enable error messages and debug() output to be sent to Serial
+
+#ifdef TEST_DATA
+  Serial.print("Automated Serial testing at "); Serial.println(TESTING_BAUD_RATE);
+  Serial.println("Comment out #define TEST_DATA to disable test data");
+  sfTestData = F(
+                 "{\"name\":\"pump 1\",\"enabled\":true,\"limits\":[12.5,-3,1e2],\"pid\":{\"kp\":0.8,\"ki\":0.05}}\n"
+                 "{\"name\":\"pump 2\",\"enabled\":false}\n"
+               ); // initialized the test data
+  Serial.println("Test Data:-");
+  Serial.println(sfTestData);
+  Serial.println();
+  inputPtr = &sfStream;
+  sfStream.begin(sfTestData, TESTING_BAUD_RATE); // NOTE: do this last !!! or will miss first few chars of sfTestData
+#else
+  Serial.println(F(" Set Newline in Arduino Monitor and"));
+  Serial.println(F("enter JSON e.g. {\"name\":\"pump 1\",\"enabled\":true}"));
+  Serial.println("Uncomment #define TEST_DATA to use test data");
+#endif
+}
+
+bool afterKey = false; // true if the key has been printed and the value goes on the same line
+
+// indent the next output line unless it follows a key
+void indent(size_t level) {
+  if (afterKey) {
+    afterKey = false;
+    return;
+  }
+  for (size_t i = 0; i < level; i++) {
+    Serial.print("  ");
+  }
+}
+
+void loop() {
+  sfInput.read(*inputPtr); // read what is available, upto the space in sfInput
+  SafeStringJsonEvent ev;
+  while ((ev = json.next(sfInput)) != JSON_NONE) {
+    switch (ev) {
+      case JSON_START_OBJECT:
+        indent(json.getDepth() - 1); Serial.println('{');
+        break;
+      case JSON_END_OBJECT:
+        indent(json.getDepth()); Serial.println('}');
+        break;
+      case JSON_START_ARRAY:
+        indent(json.getDepth() - 1); Serial.println('[');
+        break;
+      case JSON_END_ARRAY:
+        indent(json.getDepth()); Serial.println(']');
+        break;
+      case JSON_KEY:
+        indent(json.getDepth()); Serial.print(json.getValue()); Serial.print(" : ");
+        afterKey = true;
+        break;
+      case JSON_STRING:
+        indent(json.getDepth());
+        Serial.print('"'); Serial.print(json.getValue()); Serial.println('"');
+        break;
+      case JSON_NUMBER: {
+          indent(json.getDepth());
+          double d = 0.0;
+          if (json.getValue().toDouble(d)) {
+            Serial.println(d, 3);
+          } else {
+            Serial.println(json.getValue());
+          }
+        }
+        break;
+      case JSON_TRUE:
+      case JSON_FALSE:
+      case JSON_NULL:
+        indent(json.getDepth());
+        Serial.println((ev == JSON_TRUE) ? "true" : ((ev == JSON_FALSE) ? "false" : "null"));
+        break;
+      case JSON_ERROR:
+        Serial.println(F("Invalid JSON, restarting"));
+        json.reset();
+        sfInput.clear();
+        afterKey = false;
+        break;
+      default:
+        break;
+    }
+  }
+}
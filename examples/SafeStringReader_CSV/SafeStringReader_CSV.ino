@@ -0,0 +1,94 @@
+/*
+  SafeStringReader_CSV.ino
+
+  This example reads CSV records from a SafeStringStream using a SafeStringReader
+  and indexes each record in one pass with SafeStringCSV, so the fields are converted and printed in place without copying them to tokens.
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  download and install the SafeString library from Arduino library manager
+  or from www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "SafeStringReader.h"
+#include "SafeStringStream.h"
+#include "SafeStringCSV.h"
+
+#define TEST_DATA
+
+#ifdef TEST_DATA
+const uint32_t TESTING_BAUD_RATE = 9600; // how fast to release the data from sfStream to be read by this sketch
+SafeStringStream sfStream;
+cSF(sfTestData, 200);
+#endif
+
+createSafeStringReader(sfReader, 80, '\n');
+
+createSafeStringCSV(csv, 4); // index upto 4 fields per record
+
+void setup() {
+  Serial.begin(9600);    // Open serial communications and wait a few seconds
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+  SafeString::setOutput(Serial); // enable error messages and debug() output to be sent to Serial
+
+  sfReader.echoOn();
+#ifdef TEST_DATA
+  Serial.print("Automated Serial testing at "); Serial.println(TESTING_BAUD_RATE);
+  Serial.println("Comment out #define TEST_DATA to disable test data");
+  sfReader.connect(sfStream); // read from test data
+  sfTestData = F(
+                 "1,Lounge,21.5,\"on, heating\"\n"
+                 "2,\"Bed \"\"3\"\"\",19.25,off\n"
+                 "3,Garage,,off\n"
+                 "4,Shed,12.0,off,extra\n"
+                 "5,\"Kitchen,20.0,on\n"
+               ); // initialized the test data
+  sfStream.begin(sfTestData, TESTING_BAUD_RATE); // NOTE: do this last !!! or will miss first few chars of sfTestData
+#else
+  Serial.println(F(" Set Newline in Arduino Monitor and"));
+  Serial.println(F("enter id,room,temperature,state  e.g. 1,Lounge,21.5,on"));
+  Serial.println("Uncomment #define TEST_DATA to use test data");
+  sfReader.connect(Serial);
+#endif
+}
+
+void processRecord() {
+  if (!csv.index(sfReader)) {
+    if (csv.isOverflow()) {
+      Serial.print(F(" record has ")); Serial.print(csv.getRecordFieldCount()); Serial.println(F(" fields, only the first 4 are used"));
+    }
+    if (csv.isMalformed()) {
+      Serial.println(F(" bad quotes, record ignored"));
+      return;
+    }
+  }
+  long id;
+  if (!csv.field(0).toLong(id)) {
+    Serial.print(F(" invalid id:")); Serial.println(csv.field(0));
+    return;
+  }
+  cSF(room, 20);
+  csv.copyField(1, room); // removes the quotes
+  Serial.print(F(" id:")); Serial.print(id);
+  Serial.print(F(" room:")); Serial.print(room);
+  long temp_x100;
+  if (csv.field(2).toFixedPoint(temp_x100, 2)) {
+    Serial.print(F(" temp*100:")); Serial.print(temp_x100);
+  } else {
+    Serial.print(F(" no temp"));
+  }
+  Serial.print(F(" heating:")); Serial.println(csv.field(3).startsWith("on") ? F("yes") : F("no"));
+}
+
+void loop() {
+  if (sfReader.read()) {
+    processRecord();
+  } // else no complete record yet
+}
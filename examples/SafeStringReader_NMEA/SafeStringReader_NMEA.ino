@@ -0,0 +1,143 @@
+/*
+  SafeStringReader_NMEA.ino
+
+  This example reads GPS data from a SafeStringStream continuously using a SafeStringReader
+  and decodes it with SafeStringNMEA, which checks the checksum and converts the fields in place without copying them.
+  Compare with SafeStringReader_GPS.ino which splits each sentence into field SafeStrings using stoken()
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  download and install the SafeString library from Arduino library manager
+  or from www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "SafeStringReader.h"
+#include "SafeStringStream.h"
+#include "SafeStringNMEA.h"
+#include "BufferedOutput.h"
+
+#define TEST_DATA
+
+#ifdef TEST_DATA
+const uint32_t TESTING_BAUD_RATE = 9600; // how fast to release the data from sfStream to be read by this sketch
+SafeStringStream sfStream;
+cSF(sfTestData, 400);
+#endif
+
+createSafeStringReader(sfReader, 82, '\n'); // NMEA sentences are at most 82 chars
+
+createBufferedOutput(output, 100, DROP_UNTIL_EMPTY); // create an extra output buffer
+
+SafeStringNMEA nmea;
+
+void setup() {
+  Serial.begin(9600);    // Open serial communications and wait a few seconds
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+  output.connect(Serial); // connect the output buffer to the Serial, this flushes Serial
+  SafeString::setOutput(output); // enable error messages and debug() output to be sent to output
+
+#ifdef TEST_DATA
+  Serial.print("Automated Serial testing at "); Serial.println(TESTING_BAUD_RATE);
+  Serial.println("Comment out #define TEST_DATA to disable test data");
+  sfReader.connect(sfStream); // read from test data
+  sfTestData = F(
+                 "$GPRMC,194509.000,A,4042.6142,N,07400.4168,W,2.03,221.11,160412,,,A*77\n"
+                 "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48\n"
+                 "$GNGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*68\n"
+                 "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39\n"
+                 "$GPRMC,194509.000,A,4042.6142,N,07400.4168,W,2.03,221.11,160412,,,A*78\n" // bad checksum
+               ); // initialized the test data
+  Serial.println("Test Data:-");
+  Serial.println(sfTestData);
+  Serial.println();
+  sfStream.begin(sfTestData, TESTING_BAUD_RATE); // NOTE: do this last !!! or will miss first few chars of sfTestData
+#else
+  Serial.println();
+  Serial.println(F(" Set Newline in Arduino Monitor and"));
+  Serial.println(F("enter GPS msg $GPxxx,..."));
+  Serial.println(F("e.g. $GPRMC,194509.000,A,4042.6142,N,07400.4168,W,2.03,221.11,160412,,,A*77"));
+  Serial.println("Uncomment #define TEST_DATA to use test data");
+  sfReader.connect(output);
+#endif
+}
+
+void print2digits(Print& out, int num) {
+  if (num <= 9) {
+    out.print('0');
+  }
+  out.print(num);
+}
+
+// prints fixed point number with decimals
+void printFixed(Print& out, long num, int decimals) {
+  if (num < 0) {
+    out.print('-');
+    num = -num;
+  }
+  long scale = 1;
+  for (int i = 0; i < decimals; i++) {
+    scale *= 10;
+  }
+  out.print(num / scale);
+  if (decimals) {
+    out.print('.');
+    long frac = num % scale;
+    for (long s = scale / 10; s > frac && s > 1; s /= 10) {
+      out.print('0'); // leading zeros
+    }
+    out.print(frac);
+  }
+}
+
+void printPosition() {
+  cSF(results, 80);
+  uint8_t hours, minutes, seconds;
+  uint16_t ms;
+  if (nmea.getUTCTime(hours, minutes, seconds, ms)) {
+    print2digits(results, hours); results.concat(':'); print2digits(results, minutes); results.concat(':'); print2digits(results, seconds);
+    results.concat(F("  "));
+  }
+  long lat_e7, lon_e7;
+  if (nmea.getLatitude(lat_e7) && nmea.getLongitude(lon_e7)) {
+    printFixed(results, lat_e7, 7); results.concat(F(", ")); printFixed(results, lon_e7, 7);
+    results.concat(F("  "));
+  }
+  long kmh_x100;
+  if (nmea.getSpeedKmh(kmh_x100)) {
+    printFixed(results, kmh_x100, 2); results.concat(F("km/h  "));
+  }
+  long alt_cm;
+  if (nmea.getAltitude(alt_cm)) {
+    printFixed(results, alt_cm, 2); results.concat(F("m  "));
+  }
+  uint8_t sats;
+  if (nmea.getSatellitesUsed(sats)) {
+    results.concat(sats); results.concat(F(" sats"));
+  }
+  results.newline();
+  output.clearSpace(results.length()); // only clears space in the extra buffer not the Serial tx buffer
+  output.print(F(" > > > ")); output.print(nmea.field(0)); output.print(' '); output.print(results);
+}
+
+void loop() {
+  output.nextByteOut();
+  if (sfReader.read()) {
+    if (nmea.parse(sfReader)) { // checks the checksum and indexes the fields
+      if (nmea.getType() != NMEA_UNKNOWN) {
+        printPosition();
+      } else { // ignore but print the address field
+        output.print(nmea.field(0)); output.println(" ignored");
+      }
+    } else {
+      output.clearSpace(12); // make space for at least the start of this error
+      output.print("bad sentence : "); output.println(sfReader);
+    }
+  } // else token is empty
+}
@@ -0,0 +1,59 @@
+/*
+  SafeStringTable.ino
+
+  This example looks up commands in a packed, sorted SafeStringTable using a binary search
+  Compare with SafeStringWithArraysOfCstrings.ino where each string is padded to the longest length
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  download and install the SafeString library from Arduino library manager
+  or from www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "SafeStringTable.h"
+
+// the strings are separated by \0, only one uint16_t offset per string is added
+createSafeStringTableFromPacked(cmds, 8, "status\0start\0stop\0reset\0set\0sleep\0led on\0led off");
+
+// a table that strings can be added to, upto 6 strings using 60 chars in total
+createSafeStringTable(names, 6, 60);
+
+void setup() {
+  Serial.begin(9600);    // Open serial communications and wait a few seconds
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+  SafeString::setOutput(Serial); // enable error messages and debug() output to be sent to Serial
+
+  cmds.sort(); // only the offsets are sorted, needed for binary search
+  Serial.println(F("Sorted commands"));
+  Serial.print(cmds);
+
+  const char *inputs[] = { "stop", "led on", "go" };
+  for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+    Serial.print(F("indexOf(\"")); Serial.print(inputs[i]); Serial.print(F("\") = ")); Serial.println(cmds.indexOf(inputs[i]));
+  }
+
+  size_t count;
+  int first = cmds.findPrefix("st", count);
+  Serial.print(F("Commands starting with st :"));
+  for (size_t i = 0; i < count; i++) {
+    Serial.print(' '); Serial.print(cmds.get(first + i)); // get() returns a SafeStringView, no copy
+  }
+  Serial.println();
+
+  cSF(sfList, 60);
+  sfList = F("pear,apple,fig,kiwi,banana");
+  names.addList(sfList, ",");
+  names.sort();
+  Serial.print(F("names uses ")); Serial.print(names.blobUsed()); Serial.println(F(" chars for the strings"));
+  Serial.print(names);
+}
+
+void loop() {
+}
@@ -0,0 +1,97 @@
+/*
+  BufferedOutput pacing with allOrNothing tests
+  Checks that while pacing, a print( ) that does not fit in the buffer is dropped completely,
+  even though the stream has room, since paced output is never written directly to the stream
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "BufferedOutput.h"
+
+// collects the output in a SafeString instead of sending it
+class CaptureStream : public Stream {
+  public:
+    CaptureStream(SafeString& _sfOut) : sfOut(_sfOut) { }
+    size_t write(uint8_t c) {
+      if (c == '\r') {
+        sfOut += "\\r"; // show the \r
+      } else if (c == '\n') {
+        sfOut += "\\n"; // and the \n on one line
+      } else {
+        sfOut += (char)c;
+      }
+      return 1;
+    }
+    int availableForWrite() {
+      return 30; // always has room
+    }
+    int available() {
+      return 0;
+    }
+    int read() {
+      return -1;
+    }
+    int peek() {
+      return -1;
+    }
+    void flush() {
+    }
+  private:
+    SafeString& sfOut;
+};
+
+createSafeString(sfCaptured, 100);
+CaptureStream capture(sfCaptured);
+
+void setup() {
+  // Open serial communications and wait a few seconds
+  Serial.begin(9600);
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+
+  Serial.println(F("BufferedOutput pacing with allOrNothing tests"));
+  SafeString::setOutput(Serial); // enable full debugging error msgs
+  Serial.println();
+
+  uint8_t buf[40];
+  BufferedOutput output(sizeof(buf), buf, DROP_IF_FULL); // allOrNothing defaults to true
+  output.connect(capture);
+  BufferedOutputPacing pacing;
+  output.setPacing(pacing, 10, 1); // 10 bytes/sec, only 1 byte can be sent straight away
+  sfCaptured.clear();
+
+  Serial.println(F("print( ) a 27 byte line, it fits in the buffer"));
+  size_t written = output.print("abcdefghijklmnopqrstuvwxy\r\n");
+  Serial.print(F(" expect 27, actual ")); Serial.println(written);
+
+  Serial.println(F("print( ) a 28 byte line, only 9 bytes left in the buffer so all of it is dropped"));
+  written = output.print("ABCDEFGHIJKLMNOPQRSTUVWXYZ\r\n");
+  Serial.print(F(" expect 0, actual ")); Serial.println(written);
+  for (int i = 0; i < 10; i++) {
+    output.nextByteOut();
+  }
+  Serial.println(F(" paced output so far"));
+  Serial.print(F(" expect a")); Serial.println();
+  Serial.print(F(" actual ")); Serial.println(sfCaptured);
+  Serial.println();
+
+  Serial.println(F("wait for all the output to be paced out, about 3secs"));
+  unsigned long start = millis();
+  while ((millis() - start) < 3500) {
+    output.nextByteOut();
+  }
+  Serial.print(F(" expect abcdefghijklmnopqrstuvwxy\\r\\n~~\\r\\n")); Serial.println();
+  Serial.print(F(" actual ")); Serial.println(sfCaptured);
+  Serial.println();
+}
+
+void loop() {
+}
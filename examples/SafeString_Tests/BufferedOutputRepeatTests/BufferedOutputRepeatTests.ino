@@ -0,0 +1,156 @@
+/*
+  BufferedOutput repeated line suppression with deferred records tests
+  Checks that logDeferred( ) records interleaved with repeated lines are sent in order,
+  that a record is never sent past a partly written line that is being held back
+  and that allOrNothing drops the whole print( ), not just the lines that do not fit,
+  also while a part line is held back
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "BufferedOutput.h"
+
+// collects the output in a SafeString instead of sending it
+class CaptureStream : public Stream {
+  public:
+    CaptureStream(SafeString& _sfOut) : sfOut(_sfOut) {
+      room = 64;
+    }
+    size_t write(uint8_t c) {
+      if (c == '\r') {
+        sfOut += "\\r"; // show the \r
+      } else if (c == '\n') {
+        sfOut += "\\n"; // and the \n on one line
+      } else {
+        sfOut += (char)c;
+      }
+      return 1;
+    }
+    int availableForWrite() {
+      return room;
+    }
+    int available() {
+      return 0;
+    }
+    int read() {
+      return -1;
+    }
+    int peek() {
+      return -1;
+    }
+    void flush() {
+    }
+    int room; // set to 0 to hold the output in the BufferedOutput
+  private:
+    SafeString& sfOut;
+};
+
+createSafeString(sfCaptured, 200);
+CaptureStream capture(sfCaptured);
+BufferedOutputRepeats repeats; // the repeat suppression state, used by each test
+
+// the record text is shorter than the record, 4 large args take 25 bytes in the buffer
+void shortFormatter(Print& out, uint8_t formatId, const long args[], uint8_t argCount) {
+  (void)(args); (void)(argCount); // not used
+  out.print('R'); out.print(formatId);
+}
+
+void release(BufferedOutput& output) {
+  for (int i = 0; i < 5; i++) {
+    output.nextByteOut();
+  }
+}
+
+void showResult(const __FlashStringHelper* expected) {
+  Serial.print(F(" expect ")); Serial.println(expected);
+  Serial.print(F(" actual ")); Serial.println(sfCaptured);
+}
+
+void setup() {
+  // Open serial communications and wait a few seconds
+  Serial.begin(9600);
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+
+  Serial.println(F("BufferedOutput repeated lines with deferred records tests"));
+  SafeString::setOutput(Serial); // enable full debugging error msgs
+  Serial.println();
+
+  {
+    uint8_t buf[100];
+    BufferedOutput output(sizeof(buf), buf, DROP_IF_FULL);
+    output.connect(capture);
+    output.setFormatter(shortFormatter);
+    output.setSuppressRepeats(repeats, true);
+    sfCaptured.clear();
+    Serial.println(F("3 repeated lines then logDeferred(1), the summary is sent before the record"));
+    output.println("dup"); output.println("dup"); output.println("dup");
+    output.logDeferred(1, 5);
+    output.println("end");
+    release(output);
+    showResult(F("dup\\r\\nlast line repeated 2 times\\r\\nR1\\r\\nend\\r\\n"));
+    Serial.println();
+  }
+
+  {
+    uint8_t buf[100];
+    BufferedOutput output(sizeof(buf), buf, DROP_IF_FULL);
+    output.connect(capture);
+    output.setFormatter(shortFormatter);
+    output.setSuppressRepeats(repeats, true);
+    sfCaptured.clear();
+    Serial.println(F("line, record, line, record, then part of the next line, nextByteOut() stops at the part line"));
+    output.println("dup"); output.logDeferred(2, 2147483647L, 2147483647L, 2147483647L, 2147483647L);
+    output.println("dup"); output.logDeferred(2, 2147483647L, 2147483647L, 2147483647L, 2147483647L);
+    output.print("dup");
+    release(output);
+    showResult(F("dup\\r\\nR2\\r\\ndup\\r\\nR2\\r\\n"));
+    Serial.println(F("then end the line"));
+    output.println();
+    release(output);
+    showResult(F("dup\\r\\nR2\\r\\ndup\\r\\nR2\\r\\ndup\\r\\n"));
+    Serial.println();
+  }
+
+  {
+    uint8_t buf[30];
+    BufferedOutput output(sizeof(buf), buf, DROP_IF_FULL); // allOrNothing defaults to true
+    output.connect(capture);
+    output.setSuppressRepeats(repeats, true);
+    sfCaptured.clear();
+    Serial.println(F("allOrNothing, a print( ) of two lines that will not both fit is dropped completely"));
+    capture.room = 0;
+    output.println("0123456789");
+    output.print("ab\ncdefghijklmnopqrstuvwxyz\n");
+    capture.room = 64;
+    release(output);
+    showResult(F("0123456789\\r\\n~~\\r\\n"));
+    Serial.println();
+  }
+
+  {
+    uint8_t buf[40];
+    BufferedOutput output(sizeof(buf), buf, DROP_IF_FULL); // allOrNothing defaults to true
+    output.connect(capture);
+    output.setSuppressRepeats(repeats, true);
+    sfCaptured.clear();
+    Serial.println(F("allOrNothing, while part of a line is held back the stream's room is not counted, so a print( ) that does not fit is dropped completely"));
+    output.print("held line part, ");
+    size_t written = output.print("ABCDEFGHIJKLMNOPQRSTUVWXYZ\r\n");
+    Serial.print(F(" print( ) of 28 bytes with 20 bytes left in the buffer, expect 0, actual ")); Serial.println(written);
+    release(output);
+    showResult(F("held line part, ~~\\r\\n"));
+    Serial.println();
+  }
+}
+
+void loop() {
+}
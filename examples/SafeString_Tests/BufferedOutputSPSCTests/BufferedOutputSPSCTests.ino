@@ -0,0 +1,179 @@
+/*
+  BufferedOutput useSPSC() producer/consumer stress test, ESP32 only
+  setup(), on core 1, prints numbered lines as fast as it can while a task on core 0 calls nextByteOut()
+  The consumer's stream checks every line arrives complete and in order,
+  that each gap in the numbering follows a ~~ drop mark
+  and that the lines received plus the lines dropped add up to the lines printed
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "BufferedOutput.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+const long LINE_COUNT = 20000;
+
+// checks the lines as nextByteOut() writes them, only the consumer task calls write( )
+class CheckStream : public Stream {
+  public:
+    CheckStream() {
+      lines = 0; marks = 0; bad = 0; unmarkedGaps = 0; lastLineNo = -1; afterMark = false; lineLen = 0;
+    }
+    size_t write(uint8_t c) {
+      if (c == '\r') {
+        return 1;
+      }
+      if (c != '\n') {
+        if (lineLen < (sizeof(line) - 1)) {
+          line[lineLen++] = (char)c;
+        }
+        return 1;
+      }
+      line[lineLen] = '\0';
+      lineLen = 0;
+      checkLine();
+      return 1;
+    }
+    int availableForWrite() {
+      return 64; // a fast Serial
+    }
+    int available() {
+      return 0;
+    }
+    int read() {
+      return -1;
+    }
+    int peek() {
+      return -1;
+    }
+    void flush() {
+    }
+    volatile long lines; // complete lines in order
+    volatile long marks; // ~~ drop marks
+    volatile long bad; // garbled or out of order lines
+    volatile long unmarkedGaps; // lines missing without a ~~ drop mark in front of them
+    volatile long lastLineNo;
+  private:
+    void checkLine() {
+      if (strcmp(line, "~~") == 0) {
+        marks++;
+        afterMark = true;
+        return;
+      }
+      cSFA(sfLine, line); // wrap the line in a SafeString for the checks
+      long lineNo = -1;
+      int idx = sfLine.indexOf(',');
+      cSF(sfNo, 12);
+      if ((idx > 1) && sfLine.startsWith("L") && (strcmp(line + idx, ",abcdefgh") == 0)) {
+        sfLine.substring(sfNo, 1, idx);
+        sfNo.toLong(lineNo);
+      }
+      if (lineNo <= lastLineNo) {
+        bad++;
+        return;
+      }
+      if ((lineNo != (lastLineNo + 1)) && (!afterMark)) {
+        unmarkedGaps++;
+      }
+      afterMark = false;
+      lastLineNo = lineNo;
+      lines++;
+    }
+    char line[32];
+    size_t lineLen;
+    bool afterMark;
+};
+
+CheckStream checkStream;
+createBufferedOutput(output, 200, DROP_IF_FULL); // allOrNothing defaults to true
+BufferedOutputStats outputStats; // for getBytesDropped()
+
+void consumerTask(void* parameter) {
+  (void)(parameter);
+  for (unsigned long i = 0; ; i++) {
+    output.nextByteOut();
+    if ((i % 1000) == 0) {
+      vTaskDelay(1); // need this to prevent wdt panic, also lets the buffer fill up
+    }
+  }
+}
+
+void setup() {
+  // Open serial communications and wait a few seconds
+  Serial.begin(115200);
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+
+  Serial.println(F("BufferedOutput useSPSC() producer/consumer stress test"));
+  SafeString::setOutput(Serial); // enable full debugging error msgs
+  Serial.println();
+
+  output.connect(checkStream);
+  output.setStats(outputStats);
+  output.useSPSC();
+  xTaskCreatePinnedToCore(consumerTask, "consumer", 4096, NULL, 1, NULL, 0);
+
+  long accepted = 0;
+  long dropped = 0;
+  long partial = 0;
+  unsigned long droppedBytes = 0;
+  cSF(sfLine, 30);
+  for (long i = 0; i < LINE_COUNT; i++) {
+    sfLine = "L"; sfLine += i; sfLine += ",abcdefgh\r\n";
+    size_t n = output.write((const uint8_t*)sfLine.c_str(), sfLine.length()); // one write( ) per line for allOrNothing
+    if (n == sfLine.length()) {
+      accepted++;
+    } else if (n == 0) {
+      dropped++;
+      droppedBytes += sfLine.length();
+    } else {
+      partial++;
+    }
+    if ((i % 64) == 0) {
+      delayMicroseconds(i % 500); // vary the rate so the buffer both fills and empties
+    }
+  }
+  output.flush(); // waits for the consumer to empty the buffer
+
+  Serial.print(F(" lines printed ")); Serial.print(LINE_COUNT);
+  Serial.print(F(", accepted ")); Serial.print(accepted);
+  Serial.print(F(", dropped ")); Serial.print(dropped);
+  Serial.print(F(", partial ")); Serial.println(partial);
+  Serial.print(F(" lines received ")); Serial.print(checkStream.lines);
+  Serial.print(F(", ~~ marks ")); Serial.print(checkStream.marks);
+  Serial.print(F(", bad ")); Serial.print(checkStream.bad);
+  Serial.print(F(", gaps without a ~~ ")); Serial.print(checkStream.unmarkedGaps);
+  Serial.print(F(", last line ")); Serial.println(checkStream.lastLineNo);
+  Serial.print(F(" getBytesDropped() ")); Serial.print(output.getBytesDropped());
+  Serial.print(F(", bytes in the dropped lines ")); Serial.println(droppedBytes);
+  bool ok = (partial == 0) && (checkStream.bad == 0) && (checkStream.unmarkedGaps == 0) &&
+            (checkStream.lines == accepted) && ((accepted + dropped) == LINE_COUNT) &&
+            (output.getBytesDropped() == droppedBytes) && ((dropped == 0) || (checkStream.marks > 0));
+  Serial.println(ok ? F(" passed") : F(" FAILED"));
+}
+
+#else // not ESP32
+
+void setup() {
+  Serial.begin(9600);
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+  Serial.println(F("BufferedOutput useSPSC() producer/consumer stress test needs an ESP32, one core for each side"));
+}
+
+#endif // ARDUINO_ARCH_ESP32
+
+void loop() {
+}
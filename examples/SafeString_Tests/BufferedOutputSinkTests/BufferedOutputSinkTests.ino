@@ -0,0 +1,101 @@
+/*
+  BufferedOutput sink drop mark tests
+  Checks that a slow sink, with no room in its stream, does not write to it
+  and, once there is room, sends one ~~ drop mark for the whole run of dropped lines
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "BufferedOutput.h"
+
+// collects the output in a SafeString instead of sending it
+class CaptureStream : public Stream {
+  public:
+    CaptureStream(SafeString& _sfOut) : sfOut(_sfOut) {
+      room = 64;
+    }
+    size_t write(uint8_t c) {
+      if (c == '\r') {
+        sfOut += "\\r"; // show the \r
+      } else if (c == '\n') {
+        sfOut += "\\n"; // and the \n on one line
+      } else {
+        sfOut += (char)c;
+      }
+      return 1;
+    }
+    int availableForWrite() {
+      return room;
+    }
+    int available() {
+      return 0;
+    }
+    int read() {
+      return -1;
+    }
+    int peek() {
+      return -1;
+    }
+    void flush() {
+    }
+    int room; // set to 0 to hold the output in the BufferedOutput
+  private:
+    SafeString& sfOut;
+};
+
+createSafeString(sfFast, 300);
+CaptureStream fastStream(sfFast);
+createSafeString(sfSlow, 300);
+CaptureStream slowStream(sfSlow);
+
+void setup() {
+  // Open serial communications and wait a few seconds
+  Serial.begin(9600);
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+
+  Serial.println(F("BufferedOutput sink drop mark tests"));
+  SafeString::setOutput(Serial); // enable full debugging error msgs
+  Serial.println();
+
+  uint8_t buf[60];
+  BufferedOutput output(sizeof(buf), buf, DROP_IF_FULL);
+  uint8_t sinkBuf[8]; // not used, a sink shares output's buffer
+  BufferedOutput slowSink(sizeof(sinkBuf), sinkBuf, DROP_IF_FULL);
+  output.connect(fastStream);
+  slowSink.connect(slowStream);
+  BufferedOutputStats sinkStats;
+  slowSink.setStats(sinkStats); // for getDropEvents()
+  output.addSink(slowSink);
+
+  Serial.println(F("20 lines while the slow sink's stream has no room, the fast stream gets them all"));
+  slowStream.room = 0;
+  cSF(sfLine, 20);
+  for (int i = 0; i < 20; i++) {
+    sfLine = "line "; sfLine += i;
+    output.println(sfLine);
+    output.nextByteOut();
+  }
+  Serial.print(F(" slow sink's stream, expect nothing written, actual '")); Serial.print(sfSlow); Serial.println('\'');
+  Serial.print(F(" slow sink's getDropEvents() expect 14, actual ")); Serial.println(slowSink.getDropEvents());
+
+  Serial.println(F("then give the slow sink's stream room, one ~~ for all the dropped lines"));
+  slowStream.room = 64;
+  for (int i = 0; i < 20; i++) {
+    output.nextByteOut();
+  }
+  Serial.print(F(" expect ~~\\r\\nline 14\\r\\nline 15\\r\\nline 16\\r\\nline 17\\r\\nline 18\\r\\nline 19\\r\\n")); Serial.println();
+  Serial.print(F(" actual ")); Serial.println(sfSlow);
+  Serial.println();
+}
+
+void loop() {
+}
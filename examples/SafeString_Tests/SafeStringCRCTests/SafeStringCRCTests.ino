@@ -0,0 +1,165 @@
+/*
+  SafeStringCRC tests
+  Checks the CRC-8, CRC-16/CCITT-FALSE, CRC-16/MODBUS and CRC-32 check values for "123456789"
+  and that the slicing-by-4 update( ) gives the same CRC as adding one byte at a time and as a bit by bit calculation
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "SafeStringCRC.h"
+
+createSafeString(sfCheck, 10, "123456789");
+uint8_t data[67]; // not a multiple of 4, so the slicing leaves a tail
+
+void checkCRC(const __FlashStringHelper* msg, uint32_t expected, uint32_t actual) {
+  Serial.print(msg); Serial.print(F(" expect 0x")); Serial.print(expected, HEX);
+  Serial.print(F(", actual 0x")); Serial.print(actual, HEX);
+  Serial.println((expected == actual) ? F("") : F("  <<<< FAILED"));
+}
+
+// bit by bit reference calculations, no tables
+uint8_t bitwiseCRC8(const uint8_t *p, size_t len) {
+  uint8_t crc = 0x00;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= p[i];
+    for (int b = 0; b < 8; b++) {
+      crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+uint16_t bitwiseCRC16CCITT(const uint8_t *p, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= ((uint16_t)p[i]) << 8;
+    for (int b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+uint16_t bitwiseCRC16Modbus(const uint8_t *p, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= p[i];
+    for (int b = 0; b < 8; b++) {
+      crc = (crc & 1) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+    }
+  }
+  return crc;
+}
+
+uint32_t bitwiseCRC32(const uint8_t *p, size_t len) {
+  uint32_t crc = 0xFFFFFFFFUL;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= p[i];
+    for (int b = 0; b < 8; b++) {
+      crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320UL) : (crc >> 1);
+    }
+  }
+  return crc ^ 0xFFFFFFFFUL;
+}
+
+// adds data[start..end) one byte at a time, update(uint8_t) never uses the slicing
+void addBytes(SafeStringCRC& crc, size_t start, size_t end) {
+  for (size_t i = start; i < end; i++) {
+    crc.update(data[i]);
+  }
+}
+
+void setup() {
+  // Open serial communications and wait a few seconds
+  Serial.begin(9600);
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+
+  Serial.println(F("SafeStringCRC tests"));
+#ifdef SAFE_STRING_CRC_SLICING
+  Serial.println(F(" SAFE_STRING_CRC_SLICING is defined, update( ) of 4 or more bytes uses slicing-by-4 for CRC-16/MODBUS and CRC-32"));
+#else
+  Serial.println(F(" SAFE_STRING_CRC_SLICING is not defined, all the updates are bytewise"));
+#endif
+  SafeString::setOutput(Serial); // enable full debugging error msgs
+  Serial.println();
+
+  Serial.println(F("check values for \"123456789\""));
+  checkCRC(F(" SafeStringCRC8::calc(sfCheck)"), 0xF4, SafeStringCRC8::calc(sfCheck));
+  checkCRC(F(" SafeStringCRC16CCITT::calc(sfCheck)"), 0x29B1, SafeStringCRC16CCITT::calc(sfCheck));
+  checkCRC(F(" SafeStringCRC16Modbus::calc(sfCheck)"), 0x4B37, SafeStringCRC16Modbus::calc(sfCheck));
+  checkCRC(F(" SafeStringCRC32::calc(sfCheck)"), 0xCBF43926UL, SafeStringCRC32::calc(sfCheck));
+  Serial.println();
+
+  Serial.println(F("no input"));
+  checkCRC(F(" SafeStringCRC8 getCRC()"), 0x00, SafeStringCRC8().getCRC());
+  checkCRC(F(" SafeStringCRC16CCITT getCRC()"), 0xFFFF, SafeStringCRC16CCITT().getCRC());
+  checkCRC(F(" SafeStringCRC16Modbus getCRC()"), 0xFFFF, SafeStringCRC16Modbus().getCRC());
+  checkCRC(F(" SafeStringCRC32 getCRC()"), 0x00000000UL, SafeStringCRC32().getCRC());
+  Serial.println();
+
+  Serial.println(F("print( ) the check value in pieces, \"1234\" then 56789"));
+  SafeStringCRC32 crc32;
+  crc32.print("1234"); crc32.print(56789);
+  checkCRC(F(" SafeStringCRC32 getCRC()"), 0xCBF43926UL, crc32.getCRC());
+  SafeStringCRC16Modbus modbus;
+  modbus.print("1234"); modbus.print(56789);
+  checkCRC(F(" SafeStringCRC16Modbus getCRC()"), 0x4B37, modbus.getCRC());
+  Serial.println();
+
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = (uint8_t)(i * 37 + 11); // all the table entries get used over the bytes
+  }
+  Serial.println(F("67 bytes, update(data, 67) v one byte at a time v bit by bit"));
+  SafeStringCRC8 crc8;
+  crc8.update(data, sizeof(data));
+  checkCRC(F(" CRC-8 update(data, 67) v bit by bit"), bitwiseCRC8(data, sizeof(data)), crc8.getCRC());
+  SafeStringCRC16CCITT ccitt;
+  ccitt.update(data, sizeof(data));
+  checkCRC(F(" CRC-16/CCITT-FALSE update(data, 67) v bit by bit"), bitwiseCRC16CCITT(data, sizeof(data)), ccitt.getCRC());
+
+  modbus.reset();
+  modbus.update(data, sizeof(data));
+  checkCRC(F(" CRC-16/MODBUS update(data, 67) v bit by bit"), bitwiseCRC16Modbus(data, sizeof(data)), modbus.getCRC());
+  uint16_t modbusSliced = modbus.getCRC();
+  modbus.reset();
+  addBytes(modbus, 0, sizeof(data));
+  checkCRC(F(" CRC-16/MODBUS update(data, 67) v one byte at a time"), modbusSliced, modbus.getCRC());
+
+  crc32.reset();
+  crc32.update(data, sizeof(data));
+  checkCRC(F(" CRC-32 update(data, 67) v bit by bit"), bitwiseCRC32(data, sizeof(data)), crc32.getCRC());
+  uint32_t crc32Sliced = crc32.getCRC();
+  crc32.reset();
+  addBytes(crc32, 0, sizeof(data));
+  checkCRC(F(" CRC-32 update(data, 67) v one byte at a time"), crc32Sliced, crc32.getCRC());
+  Serial.println();
+
+  Serial.println(F("update( ) in pieces of 1 to 7 bytes, so the slicing starts at each alignment and leaves each length of tail"));
+  bool modbusOk = true;
+  bool crc32Ok = true;
+  for (size_t piece = 1; piece <= 7; piece++) {
+    modbus.reset();
+    crc32.reset();
+    for (size_t i = 0; i < sizeof(data); i += piece) {
+      size_t len = ((i + piece) > sizeof(data)) ? (sizeof(data) - i) : piece;
+      modbus.update(data + i, len);
+      crc32.update(data + i, len);
+    }
+    modbusOk = modbusOk && (modbus.getCRC() == modbusSliced);
+    crc32Ok = crc32Ok && (crc32.getCRC() == crc32Sliced);
+  }
+  Serial.print(F(" CRC-16/MODBUS all pieces match, expect true, actual ")); Serial.println(modbusOk ? F("true") : F("false  <<<< FAILED"));
+  Serial.print(F(" CRC-32 all pieces match, expect true, actual ")); Serial.println(crc32Ok ? F("true") : F("false  <<<< FAILED"));
+}
+
+void loop() {
+}
@@ -0,0 +1,85 @@
+/*
+  SafeString F( ) and F_LEN( ) flash strings, assign, concat, prefix, compare and search
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+#include "SafeString.h"
+
+createSafeString(stringOne, 40);
+
+void setup() {
+  // Open serial communications and wait a few seconds
+  Serial.begin(9600);
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+  Serial.println(F("SafeString F( ) and F_LEN( ) flash string methods"));
+  Serial.println(F("SafeString::setOutput(Serial); // verbose == true"));
+  // see the SafeString_ConstructorAndDebugging example for debugging settings
+  SafeString::setOutput(Serial); // enable full debugging error msgs
+  Serial.println();
+
+  Serial.println(F("F_LEN(\"..\") is a F(\"..\") string whose length is worked out by the compiler,"));
+  Serial.println(F("so it is copied or compared in one block without first scanning the flash for its length."));
+  Serial.println();
+
+  stringOne = F_LEN("HTTP/1.1 200 OK");
+  stringOne.debug(F("stringOne = F_LEN(\"HTTP/1.1 200 OK\"); => "));
+  if (stringOne.startsWith(F_LEN("HTTP/1.1"))) {
+    Serial.println(F("stringOne.startsWith(F_LEN(\"HTTP/1.1\")) returned true"));
+  }
+  if (stringOne.startsWith(F("200"), 9)) {
+    Serial.println(F("stringOne.startsWith(F(\"200\"), 9) returned true"));
+  }
+  if (stringOne.endsWith(F_LEN("OK"))) {
+    Serial.println(F("stringOne.endsWith(F_LEN(\"OK\")) returned true"));
+  }
+  Serial.print(F("stringOne.indexOf(F_LEN(\"200\")) returned ")); Serial.println(stringOne.indexOf(F_LEN("200")));
+  if (stringOne == F("HTTP/1.1 200 OK")) {
+    Serial.println(F("stringOne == F(\"HTTP/1.1 200 OK\") returned true"));
+  }
+  if (stringOne != F_LEN("HTTP/1.1 404 Not Found")) {
+    Serial.println(F("stringOne != F_LEN(\"HTTP/1.1 404 Not Found\") returned true"));
+  }
+  Serial.println();
+
+  stringOne = F_LEN("Content-Length");
+  stringOne += F_LEN(": ");
+  stringOne += 42;
+  stringOne -= F_LEN("> ");
+  stringOne.debug(F("stringOne = F_LEN(\"Content-Length\"); stringOne += F_LEN(\": \"); stringOne += 42; stringOne -= F_LEN(\"> \"); => "));
+  Serial.println();
+
+  Serial.println(F("Errors are handled as for F( ) strings, stringOne is left unchanged"));
+  stringOne += F_LEN(" this text is too long to fit in stringOne");
+  stringOne.debug(F("stringOne += F_LEN(\" this text is too long to fit in stringOne\"); => "));
+  Serial.println();
+
+  Serial.println(F("F_LEN( ) strings can also be printed"));
+  Serial.println(F_LEN("Serial.println(F_LEN(\"...\"));"));
+  Serial.println();
+
+  Serial.println(F("Time 1000 x F( ) versus F_LEN( ) assignments"));
+  unsigned long us = micros();
+  for (int i = 0; i < 1000; i++) {
+    stringOne = F("Content-Type: text/html; charset=UTF-8");
+  }
+  us = micros() - us;
+  Serial.print(F(" F( )     ")); Serial.print(us); Serial.println(F("us"));
+  us = micros();
+  for (int i = 0; i < 1000; i++) {
+    stringOne = F_LEN("Content-Type: text/html; charset=UTF-8");
+  }
+  us = micros() - us;
+  Serial.print(F(" F_LEN( ) ")); Serial.print(us); Serial.println(F("us"));
+}
+
+void loop() {
+  // nothing here
+}
@@ -0,0 +1,142 @@
+/*
+  SafeStringGlob tests
+  Checks * ? [a-z] [!abc] and \ in patterns, patterns at the SAFE_STRING_GLOB_MAX_TOKENS (31) element limit
+  and that invalid patterns are rejected by compile( ) and then match nothing
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "SafeStringGlob.h"
+
+createSafeStringGlob(glob, 40); // upto 40 chars, 31 pattern elements
+
+void checkCompile(const char* pattern, bool expected, bool ignoreCase = false) {
+  bool actual = glob.compile(pattern, ignoreCase);
+  Serial.print(F(" compile(\"")); Serial.print(pattern); Serial.print(ignoreCase ? F("\", true)") : F("\")"));
+  Serial.print(F(" expect ")); Serial.print(expected ? F("true") : F("false"));
+  Serial.print(F(", actual ")); Serial.print(actual ? F("true") : F("false"));
+  Serial.println((expected == actual) ? F("") : F("  <<<< FAILED"));
+}
+
+void checkMatch(const char* input, bool expected) {
+  bool actual = glob.match(input);
+  Serial.print(F("   match(\"")); Serial.print(input); Serial.print(F("\")"));
+  Serial.print(F(" expect ")); Serial.print(expected ? F("true") : F("false"));
+  Serial.print(F(", actual ")); Serial.print(actual ? F("true") : F("false"));
+  Serial.println((expected == actual) ? F("") : F("  <<<< FAILED"));
+}
+
+void setup() {
+  // Open serial communications and wait a few seconds
+  Serial.begin(9600);
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+
+  Serial.println(F("SafeStringGlob tests"));
+  SafeString::setOutput(Serial); // enable full debugging error msgs
+  Serial.println();
+
+  Serial.println(F("* matches any run of chars, including none"));
+  checkCompile("*", true);
+  checkMatch("", true);
+  checkMatch("anything", true);
+  checkCompile("a*b", true);
+  checkMatch("ab", true);
+  checkMatch("axxb", true);
+  checkMatch("axxbc", false);
+  checkMatch("xab", false);
+  checkCompile("*.txt", true);
+  checkMatch("log.txt", true);
+  checkMatch("log.txt.bak", false);
+  checkCompile("*a*b*", true);
+  checkMatch("xxaYYbzz", true);
+  checkMatch("xxbYYazz", false);
+  checkCompile("a**b", true);
+  checkMatch("aXb", true);
+  checkMatch("aX", false);
+  Serial.println();
+
+  Serial.println(F("? matches any one char"));
+  checkCompile("a?c", true);
+  checkMatch("abc", true);
+  checkMatch("a?c", true);
+  checkMatch("ac", false);
+  checkMatch("abbc", false);
+  checkCompile("*?", true);
+  checkMatch("", false);
+  checkMatch("x", true);
+  Serial.println();
+
+  Serial.println(F("[a-z] matches one char in the ranges"));
+  checkCompile("[a-z]1", true);
+  checkMatch("q1", true);
+  checkMatch("Q1", false);
+  checkMatch("11", false);
+  checkCompile("[a-z]1", true, true);
+  checkMatch("Q1", true);
+  checkCompile("id[0-9a-f][0-9a-f]", true);
+  checkMatch("id7e", true);
+  checkMatch("id7g", false);
+  checkCompile("[]x]", true);
+  checkMatch("]", true);
+  checkMatch("x", true);
+  checkMatch("y", false);
+  Serial.println();
+
+  Serial.println(F("[!abc] and [^abc] match any one char except a, b or c"));
+  checkCompile("x[!abc]", true);
+  checkMatch("xd", true);
+  checkMatch("xa", false);
+  checkMatch("x", false);
+  checkCompile("x[^abc]", true);
+  checkMatch("xc", false);
+  checkMatch("xz", true);
+  checkCompile("[!a-z]*", true);
+  checkMatch("9lives", true);
+  checkMatch("nine", false);
+  Serial.println();
+
+  Serial.println(F("\\ matches the next char literally"));
+  checkCompile("a\\*", true);
+  checkMatch("a*", true);
+  checkMatch("ab", false);
+  checkCompile("[\\]]", true);
+  checkMatch("]", true);
+  Serial.println();
+
+  Serial.println(F("31 pattern elements, the SAFE_STRING_GLOB_MAX_TOKENS limit"));
+  checkCompile("abcdefghijklmnopqrstuvwxyz01234", true);
+  checkMatch("abcdefghijklmnopqrstuvwxyz01234", true);
+  checkMatch("abcdefghijklmnopqrstuvwxyz01235", false);
+  checkMatch("abcdefghijklmnopqrstuvwxyz0123", false);
+  Serial.println(F(" 30 literals then *, the * is the last element"));
+  checkCompile("abcdefghijklmnopqrstuvwxyz0123*", true);
+  checkMatch("abcdefghijklmnopqrstuvwxyz0123", true);
+  checkMatch("abcdefghijklmnopqrstuvwxyz0123 and more", true);
+  Serial.println(F(" runs of * count as one element"));
+  checkCompile("abcdefghijklmnopqrstuvwxyz0123***", true);
+  checkMatch("abcdefghijklmnopqrstuvwxyz0123xyz", true);
+  Serial.println();
+
+  Serial.println(F("pattern errors, compile( ) returns false and nothing matches"));
+  checkCompile("abcdefghijklmnopqrstuvwxyz012345", false); // 32 elements
+  checkMatch("abcdefghijklmnopqrstuvwxyz012345", false);
+  checkCompile("abc[def", false);
+  checkMatch("abcd", false);
+  checkCompile("abc\\", false);
+  checkMatch("abc", false);
+  checkCompile("0123456789012345678901234567890123456789*", false); // 41 chars, longer than 40
+  checkMatch("0123456789012345678901234567890123456789", false);
+  Serial.print(F(" isValid() expect false, actual ")); Serial.println(glob.isValid() ? F("true  <<<< FAILED") : F("false"));
+}
+
+void loop() {
+}
@@ -0,0 +1,74 @@
+/*
+  SafeStringJsonTokenizer number format tests
+  Checks that numbers following the JSON number format are returned as JSON_NUMBER and that others give JSON_ERROR
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "SafeStringJsonTokenizer.h"
+
+createSafeStringJsonTokenizer(json, 20, 4);
+
+// tokenizes [number] and returns the first number or error event
+void testNumber(const char* number, bool expectValid) {
+  cSF(sfInput, 30);
+  sfInput = "["; sfInput += number; sfInput += "]";
+  Serial.print(' '); Serial.println(sfInput); // before next( ) removes it
+  json.reset();
+  SafeStringJsonEvent ev;
+  while ((ev = json.next(sfInput)) == JSON_START_ARRAY) {
+  }
+  bool valid = (ev == JSON_NUMBER) && (json.getValue() == number);
+  Serial.print(F("   expect ")); Serial.print(expectValid ? F("JSON_NUMBER") : F("JSON_ERROR"));
+  Serial.print(F(", actual ")); Serial.print(valid ? F("JSON_NUMBER") : ((ev == JSON_ERROR) ? F("JSON_ERROR") : F("other")));
+  Serial.println((valid == expectValid) ? F("") : F("  <<<< FAILED"));
+}
+
+void setup() {
+  // Open serial communications and wait a few seconds
+  Serial.begin(9600);
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+
+  Serial.println(F("SafeStringJsonTokenizer number format tests"));
+  SafeString::setOutput(Serial); // enable full debugging error msgs
+  Serial.println();
+
+  testNumber("0", true);
+  testNumber("-0", true);
+  testNumber("123", true);
+  testNumber("-123", true);
+  testNumber("0.5", true);
+  testNumber("-12.25", true);
+  testNumber("1e5", true);
+  testNumber("1E+5", true);
+  testNumber("-2.5e-3", true);
+  testNumber("0e0", true);
+  Serial.println();
+
+  testNumber("-", false);
+  testNumber("--1", false);
+  testNumber("01", false);
+  testNumber("-01", false);
+  testNumber("1.", false);
+  testNumber("1.2.3", false);
+  testNumber(".5", false);
+  testNumber("1e", false);
+  testNumber("1e+", false);
+  testNumber("1e5.0", false);
+  testNumber("1.e5", false);
+  testNumber("1-2", false);
+  testNumber("1e+-2", false);
+  Serial.println();
+}
+
+void loop() {
+}
@@ -0,0 +1,85 @@
+/*
+  SafeStringNMEA length limit tests
+  Checks that sentences upto the 254 char limit are indexed correctly and longer ones are rejected
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "SafeStringNMEA.h"
+
+createSafeString(sentence, 260);
+SafeStringNMEA nmea;
+
+// $GPTXT, then a 'x' field padded to len chars, optionally with a *hh checksum at the end
+void makeSentence(size_t len, bool withChecksum) {
+  sentence = "$GPTXT,";
+  size_t textLen = len - sentence.length() - (withChecksum ? 3 : 0);
+  for (size_t i = 0; i < textLen; i++) {
+    sentence += 'x';
+  }
+  if (withChecksum) {
+    uint8_t sum = 0;
+    for (size_t i = 1; i < sentence.length(); i++) {
+      sum ^= (uint8_t)sentence.charAt(i);
+    }
+    sentence += '*';
+    if (sum < 16) {
+      sentence += '0';
+    }
+    sentence.print(sum, HEX);
+  }
+}
+
+void showResult(bool parsed) {
+  Serial.print(F(" parse returns ")); Serial.print(parsed ? "true" : "false");
+  Serial.print(F(", fields ")); Serial.print(nmea.getFieldCount());
+  Serial.print(F(", field(1).length() ")); Serial.println(nmea.field(1).length());
+}
+
+void setup() {
+  // Open serial communications and wait a few seconds
+  Serial.begin(9600);
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+
+  Serial.println(F("SafeStringNMEA length limit tests"));
+  SafeString::setOutput(Serial); // enable full debugging error msgs
+  Serial.println();
+
+  makeSentence(254, false);
+  Serial.println(F("254 chars, no checksum, nmea.parse(sentence, false) expect true, 2 fields, field(1).length() 247"));
+  showResult(nmea.parse(sentence, false));
+  Serial.println();
+
+  makeSentence(255, false);
+  Serial.println(F("255 chars, no checksum, nmea.parse(sentence, false) expect false, 0 fields, field(1).length() 0"));
+  showResult(nmea.parse(sentence, false));
+  Serial.println();
+
+  makeSentence(254, true);
+  Serial.println(F("254 chars, with checksum, nmea.parse(sentence) expect true, 2 fields, field(1).length() 244"));
+  showResult(nmea.parse(sentence));
+  Serial.println();
+
+  makeSentence(255, true);
+  Serial.println(F("255 chars, with checksum, nmea.parse(sentence) expect false, 0 fields, field(1).length() 0"));
+  showResult(nmea.parse(sentence));
+  Serial.println();
+
+  makeSentence(254, false);
+  sentence += "\r\n";
+  Serial.println(F("254 chars plus \\r\\n, nmea.parse(sentence, false) expect true, 2 fields, field(1).length() 247"));
+  showResult(nmea.parse(sentence, false));
+  Serial.println();
+}
+
+void loop() {
+}
@@ -0,0 +1,113 @@
+/*
+  SafeStringPrefixTrie tests
+  Checks match( ) returns the longest matching prefix and its length, shared leading chars, the empty prefix,
+  replacing an id and the errors when the nodes run out or the id is negative
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+#include "SafeStringPrefixTrie.h"
+
+createSafeStringPrefixTrie(routes, 30);
+createSafeStringPrefixTrie(small, 6); // room for the root and 5 chars
+
+void checkNumber(const __FlashStringHelper* msg, long expected, long actual) {
+  Serial.print(msg); Serial.print(F(" expect ")); Serial.print(expected);
+  Serial.print(F(", actual ")); Serial.print(actual);
+  Serial.println((expected == actual) ? F("") : F("  <<<< FAILED"));
+}
+
+void checkMatch(SafeStringPrefixTrie& trie, const char* input, int expectedId, size_t expectedLen) {
+  size_t matchLen = 99;
+  int id = trie.match(input, strlen(input), matchLen);
+  Serial.print(F(" match(\"")); Serial.print(input); Serial.print(F("\")"));
+  Serial.print(F(" expect id ")); Serial.print(expectedId); Serial.print(F(" len ")); Serial.print(expectedLen);
+  Serial.print(F(", actual id ")); Serial.print(id); Serial.print(F(" len ")); Serial.print(matchLen);
+  Serial.println(((id == expectedId) && (matchLen == expectedLen)) ? F("") : F("  <<<< FAILED"));
+}
+
+void setup() {
+  // Open serial communications and wait a few seconds
+  Serial.begin(9600);
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+
+  Serial.println(F("SafeStringPrefixTrie tests"));
+  SafeString::setOutput(Serial); // enable full debugging error msgs
+  Serial.println();
+
+  Serial.println(F("routes.addAll(\"AT+\\0AT+CSQ\\0$GP\\0/api/v1/\\0/api/v1/led\\0\"), ids 0 to 4"));
+  checkNumber(F(" addAll( ) returns"), 1, routes.addAll("AT+\0AT+CSQ\0$GP\0/api/v1/\0/api/v1/led\0"));
+  checkNumber(F(" nodesUsed(), the root + 3 + 3 + 3 + 8 + 3, shared leading chars are stored once"), 21, routes.nodesUsed());
+  Serial.println();
+
+  Serial.println(F("the longest prefix wins"));
+  checkMatch(routes, "AT+CSQ=?", 1, 6);
+  checkMatch(routes, "AT+CREG?", 0, 3);
+  checkMatch(routes, "AT+CS", 0, 3);
+  checkMatch(routes, "AT+", 0, 3);
+  checkMatch(routes, "$GPGGA,123519", 2, 3);
+  checkMatch(routes, "/api/v1/ledOn", 4, 11);
+  checkMatch(routes, "/api/v1/status", 3, 8);
+  Serial.println(F("no match"));
+  checkMatch(routes, "AT", -1, 0);
+  checkMatch(routes, "at+csq", -1, 0);
+  checkMatch(routes, "/api/v2/led", -1, 0);
+  checkMatch(routes, "", -1, 0);
+  Serial.println();
+
+  Serial.println(F("using matchLen to remove the prefix"));
+  cSF(sfLine, 30);
+  sfLine = "/api/v1/ledOn";
+  size_t matchLen;
+  int id = routes.match(sfLine, matchLen);
+  sfLine.removeBefore(matchLen);
+  checkNumber(F(" match(sfLine, matchLen) id"), 4, id);
+  Serial.print(F(" sfLine.removeBefore(matchLen) expect On, actual ")); Serial.print(sfLine);
+  Serial.println((sfLine == "On") ? F("") : F("  <<<< FAILED"));
+  Serial.println();
+
+  Serial.println(F("routes.add(\"$GP\", 7) replaces the id and uses no more nodes"));
+  checkNumber(F(" add( ) returns"), 1, routes.add("$GP", 7));
+  checkMatch(routes, "$GPRMC", 7, 3);
+  checkNumber(F(" nodesUsed()"), 21, routes.nodesUsed());
+  Serial.println(F("routes.add(\"\", 9) the empty prefix matches any input, with length 0"));
+  routes.add("", 9);
+  checkMatch(routes, "xyz", 9, 0);
+  checkMatch(routes, "", 9, 0);
+  checkMatch(routes, "AT+CSQ", 1, 6);
+  Serial.println(F("routes.clear()"));
+  routes.clear();
+  checkNumber(F(" nodesUsed()"), 1, routes.nodesUsed());
+  checkMatch(routes, "AT+CSQ", -1, 0);
+  Serial.println();
+
+  Serial.println(F("errors, small has 6 nodes"));
+  checkNumber(F(" small.add(\"abc\", 0) returns"), 1, small.add("abc", 0));
+  checkNumber(F(" small.add(\"abd\", 1) returns"), 1, small.add("abd", 1));
+  checkNumber(F(" nodesUsed()"), 5, small.nodesUsed());
+  Serial.println(F(" small.add(\"xyz\", 2) needs 3 more nodes"));
+  checkNumber(F(" returns"), 0, small.add("xyz", 2));
+  checkNumber(F(" hasError()"), 1, small.hasError());
+  checkNumber(F(" nodesUsed() is unchanged"), 5, small.nodesUsed());
+  checkMatch(small, "xyz", -1, 0);
+  checkMatch(small, "abd", 1, 3);
+  Serial.println(F(" small.add(\"ab\", 3) needs no more nodes"));
+  checkNumber(F(" returns"), 1, small.add("ab", 3));
+  checkMatch(small, "abx", 3, 2);
+  Serial.println(F(" small.add(\"a\", -1) the id must be >= 0"));
+  checkNumber(F(" returns"), 0, small.add("a", -1));
+  checkNumber(F(" hasError()"), 1, small.hasError());
+  checkMatch(small, "ax", -1, 0);
+}
+
+void loop() {
+}
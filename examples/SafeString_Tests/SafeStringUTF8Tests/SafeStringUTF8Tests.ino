@@ -0,0 +1,143 @@
+/*
+  SafeString UTF-8 tests
+  Checks isUTF8() rejects invalid sequences, and that utf8Length(), utf8Index(), utf8Substring(), utf8RemoveLast(),
+  utf8KeepLast() and utf8Truncate() work in code points on text mixing 1, 2, 3 and 4 byte code points
+
+  by Matthew Ford
+  Copyright(c)2020 Forward Computing and Control Pty. Ltd.
+  This example code is in the public domain.
+
+  www.forward.com.au/pfod/ArduinoProgramming/SafeString/index.html
+*/
+
+#include "SafeString.h"
+
+// a (1 byte) e acute (2 bytes) euro sign (3 bytes) grinning face emoji (4 bytes) b (1 byte)
+// 11 bytes, 5 code points starting at bytes 0, 1, 3, 6 and 10
+// the strings are split so the \x escapes are not run into the following chars
+const char mixedText[] = "a" "\xC3\xA9" "\xE2\x82\xAC" "\xF0\x9F\x98\x80" "b";
+
+createSafeString(sfText, 30);
+createSafeString(sfResult, 30);
+
+void checkNumber(const __FlashStringHelper* msg, unsigned int expected, unsigned int actual) {
+  Serial.print(msg); Serial.print(F(" expect ")); Serial.print(expected);
+  Serial.print(F(", actual ")); Serial.print(actual);
+  Serial.println((expected == actual) ? F("") : F("  <<<< FAILED"));
+}
+
+// compares the bytes, as the Serial monitor may not show the UTF-8 chars
+void checkText(const __FlashStringHelper* msg, const char* expected, SafeString& actual) {
+  Serial.print(msg); Serial.print(F(" expect length ")); Serial.print(strlen(expected));
+  Serial.print(F(", actual length ")); Serial.print(actual.length());
+  Serial.println(actual.equals(expected) ? F("") : F("  <<<< FAILED"));
+}
+
+void checkValid(const __FlashStringHelper* msg, const char* text, bool expected) {
+  sfText = text;
+  bool actual = sfText.isUTF8();
+  Serial.print(msg); Serial.print(F(" isUTF8() expect ")); Serial.print(expected ? F("true") : F("false"));
+  Serial.print(F(", actual ")); Serial.print(actual ? F("true") : F("false"));
+  Serial.println((expected == actual) ? F("") : F("  <<<< FAILED"));
+}
+
+void setup() {
+  // Open serial communications and wait a few seconds
+  Serial.begin(9600);
+  for (int i = 10; i > 0; i--) {
+    Serial.print(' '); Serial.print(i);
+    delay(500);
+  }
+  Serial.println();
+
+  Serial.println(F("SafeString UTF-8 tests"));
+  SafeString::setOutput(Serial); // enable full debugging error msgs
+  Serial.println();
+
+  Serial.println(F("isUTF8() valid and invalid sequences"));
+  checkValid(F(" plain ASCII, longer than 4 bytes,"), "abcdefghij", true);
+  checkValid(F(" mixed 1 to 4 byte code points,"), mixedText, true);
+  checkValid(F(" U+10FFFF, the largest code point,"), "\xF4\x8F\xBF\xBF", true);
+  checkValid(F(" stray continuation byte,"), "ab" "\x80" "cd", false);
+  checkValid(F(" overlong 2 byte '/',"), "\xC0\xAF", false);
+  checkValid(F(" overlong 3 byte '/',"), "\xE0\x80\xAF", false);
+  checkValid(F(" surrogate U+D800,"), "\xED\xA0\x80", false);
+  checkValid(F(" U+110000, > U+10FFFF,"), "\xF4\x90\x80\x80", false);
+  checkValid(F(" 0xFF byte,"), "abcdefgh" "\xFF", false);
+  checkValid(F(" 2 byte code point missing its last byte,"), "abc" "\xC3", false);
+  checkValid(F(" 4 byte code point missing its last byte,"), "abc" "\xF0\x9F\x98", false);
+  checkValid(F(" 3 byte code point with an ASCII byte inside it,"), "\xE2\x82" "a", false);
+  Serial.println();
+
+  Serial.println(F("utf8Length() and utf8Index() on the mixed text"));
+  sfText = mixedText;
+  checkNumber(F(" length()"), 11, sfText.length());
+  checkNumber(F(" utf8Length()"), 5, sfText.utf8Length());
+  checkNumber(F(" utf8Index(0)"), 0, sfText.utf8Index(0));
+  checkNumber(F(" utf8Index(1)"), 1, sfText.utf8Index(1));
+  checkNumber(F(" utf8Index(2)"), 3, sfText.utf8Index(2));
+  checkNumber(F(" utf8Index(3)"), 6, sfText.utf8Index(3));
+  checkNumber(F(" utf8Index(4)"), 10, sfText.utf8Index(4));
+  checkNumber(F(" utf8Index(5) is length()"), 11, sfText.utf8Index(5));
+  checkNumber(F(" utf8Index(9) is length()"), 11, sfText.utf8Index(9));
+  sfText = "abc" "\xC3";
+  checkNumber(F(" utf8Length() of text ending in half a code point"), 4, sfText.utf8Length());
+  sfText = "a" "\x80\x80" "b";
+  checkNumber(F(" utf8Length() of text with stray continuation bytes"), 2, sfText.utf8Length());
+  Serial.println();
+
+  Serial.println(F("utf8Substring( ) on the mixed text"));
+  sfText = mixedText;
+  sfText.utf8Substring(sfResult, 1, 4);
+  checkText(F(" utf8Substring(result, 1, 4)"), "\xC3\xA9" "\xE2\x82\xAC" "\xF0\x9F\x98\x80", sfResult);
+  sfText.utf8Substring(sfResult, 3);
+  checkText(F(" utf8Substring(result, 3)"), "\xF0\x9F\x98\x80" "b", sfResult);
+  sfText.utf8Substring(sfResult, 5);
+  checkText(F(" utf8Substring(result, 5)"), "", sfResult);
+  Serial.println(F(" utf8Substring(result, 6) is an error"));
+  sfText.utf8Substring(sfResult, 6);
+  checkNumber(F(" hasError()"), 1, sfText.hasError());
+  Serial.println();
+
+  Serial.println(F("utf8RemoveLast( ) and utf8KeepLast( ) on the mixed text"));
+  sfText = mixedText;
+  sfText.utf8RemoveLast(2);
+  checkText(F(" utf8RemoveLast(2)"), "a" "\xC3\xA9" "\xE2\x82\xAC", sfText);
+  sfText = mixedText;
+  sfText.utf8KeepLast(3);
+  checkText(F(" utf8KeepLast(3)"), "\xE2\x82\xAC" "\xF0\x9F\x98\x80" "b", sfText);
+  sfText = mixedText;
+  sfText.utf8KeepLast(0);
+  checkText(F(" utf8KeepLast(0)"), "", sfText);
+  Serial.println(F(" utf8KeepLast(6) is an error and leaves the text unchanged"));
+  sfText = mixedText;
+  sfText.utf8KeepLast(6);
+  checkNumber(F(" hasError()"), 1, sfText.hasError());
+  checkText(F(" text"), mixedText, sfText);
+  Serial.println(F(" utf8RemoveLast(6) is an error and clears the text"));
+  sfText.utf8RemoveLast(6);
+  checkNumber(F(" hasError()"), 1, sfText.hasError());
+  checkText(F(" text"), "", sfText);
+  Serial.println();
+
+  Serial.println(F("utf8Truncate( ) on the mixed text, never splits a code point"));
+  sfText = mixedText;
+  sfText.utf8Truncate(8);
+  checkText(F(" utf8Truncate(8), inside the 4 byte code point"), "a" "\xC3\xA9" "\xE2\x82\xAC", sfText);
+  checkNumber(F(" and is still valid, isUTF8()"), 1, sfText.isUTF8());
+  sfText = mixedText;
+  sfText.utf8Truncate(6);
+  checkText(F(" utf8Truncate(6), at the start of a code point"), "a" "\xC3\xA9" "\xE2\x82\xAC", sfText);
+  sfText = mixedText;
+  sfText.utf8Truncate(2);
+  checkText(F(" utf8Truncate(2), inside the 2 byte code point"), "a", sfText);
+  sfText = mixedText;
+  sfText.utf8Truncate(10);
+  checkText(F(" utf8Truncate(10), before the last ASCII byte"), "a" "\xC3\xA9" "\xE2\x82\xAC" "\xF0\x9F\x98\x80", sfText);
+  sfText = mixedText;
+  sfText.utf8Truncate(20);
+  checkText(F(" utf8Truncate(20), longer than the text"), mixedText, sfText);
+}
+
+void loop() {
+}
@@ -28,7 +28,7 @@
      BufferedInput(size_t _bufferSize, uint8_t *_buf);
 
      buf -- the user allocated buffer to store the bytes, must be at least bufferSize long.  Defaults to an internal 8 char buffer if buf is omitted or NULL
-     bufferSize -- number of bytes to buffer,max bufferSize is limited to 32766. Defaults to an internal 8 char buffer if bufferSize is < 8 or is omitted
+     bufferSize -- number of bytes to buffer,max bufferSize is limited to 32766 on AVR boards, see BufferedRingIndex.h. Defaults to an internal 8 char buffer if bufferSize is < 8 or is omitted
 */
 
 BufferedInput::BufferedInput( size_t _bufferSize, uint8_t _buf[]) {
@@ -38,6 +38,7 @@ BufferedInput::BufferedInput( size_t _bufferSize, uint8_t _buf[]) {
   streamPtr = NULL;
   maxAvail = 0;
   bufUsed = 0;
+  spsc = false;
   if ((_buf == NULL) || (_bufferSize < 8)) {
     // use default
     rb_init(defaultBuffer, sizeof(defaultBuffer));
@@ -64,7 +65,7 @@ int BufferedInput::availableForWrite() {
   if (!streamPtr) {
     return 0;
   }
-  nextByteIn();
+  consumerNextByteIn();
   return 1;
 }
 
@@ -73,7 +74,7 @@ size_t BufferedInput::write(const uint8_t *buffer, size_t size) {
   if (!streamPtr) {
     return 0;
   }
-  nextByteIn();
+  consumerNextByteIn();
   return streamPtr->write(buffer, size);
 }
 
@@ -82,7 +83,7 @@ size_t BufferedInput::write(uint8_t c) {
   if (!streamPtr) {
     return 0;
   }
-  nextByteIn();
+  consumerNextByteIn();
   return streamPtr->write(c);
 }
 
@@ -115,10 +116,21 @@ void BufferedInput::nextByteIn() {
   if (rb_avail < avail) {
     avail = rb_avail;
   }
-  for (int i = 0; i < avail; i++) {
-    char c = streamPtr->read();
-    rb_internalWrite(c); // checked buffer space above rb_availableForWrite() so will not overflow here
-    //    rb_write(c);
+  // read straight into the ring buffer, upto two contiguous blocks, each published once it is read
+  // checked buffer space above rb_availableForWrite() so will not overflow here
+  while (avail > 0) {
+    BufferedRingIndex head = bufferedRingLoad(&rb_buffer_head);
+    size_t pos = rb_pos(head);
+    size_t len = rb_bufSize - pos; // space before the wrap
+    if (len > ((size_t)avail)) {
+      len = avail;
+    }
+    size_t got = streamPtr->readBytes(rb_buf + pos, len); // only asks for bytes available() so does not wait
+    if (got == 0) {
+      break;
+    }
+    bufferedRingStore(&rb_buffer_head, rb_advance(head, got)); // publish after the bytes are written
+    avail -= got;
   }
   if (rb_available() > bufUsed) {
     bufUsed = rb_available();
@@ -129,7 +141,7 @@ int BufferedInput::available() {
   if (!streamPtr) {
     return 0;
   }
-  nextByteIn();
+  consumerNextByteIn();
   return rb_available();
 }
 
@@ -137,7 +149,7 @@ int BufferedInput::read() {
   if (!streamPtr) {
     return -1; // -1
   }
-  nextByteIn();
+  consumerNextByteIn();
   return rb_read();
 }
 
@@ -145,25 +157,115 @@ int BufferedInput::peek() {
   if (!streamPtr) {
     return -1; // -1
   }
-  nextByteIn();
+  consumerNextByteIn();
   return rb_peek();
 }
 
+// copies the buffered bytes in blocks, reads more and waits upto _timeout if there are not enough
+size_t BufferedInput::readBytes(char *buffer, size_t length) {
+  if (!streamPtr) {
+    return 0;
+  }
+  size_t count = 0;
+  unsigned long start = millis();
+  while (count < length) {
+    consumerNextByteIn();
+    size_t n = rb_read((uint8_t*)buffer + count, length - count);
+    if (n != 0) {
+      count += n;
+      start = millis(); // like Stream::timedRead( ), the timeout is for each byte
+    } else if ((millis() - start) >= _timeout) {
+      break;
+    }
+  }
+  return count;
+}
+
+size_t BufferedInput::readBytes(uint8_t *buffer, size_t length) {
+  return readBytes((char*)buffer, length);
+}
+
+size_t BufferedInput::readBytesUntil(char terminator, char *buffer, size_t length) {
+  if (!streamPtr) {
+    return 0;
+  }
+  size_t count = 0;
+  unsigned long start = millis();
+  while (count < length) {
+    consumerNextByteIn();
+    size_t n = rb_available();
+    if (n == 0) {
+      if ((millis() - start) >= _timeout) {
+        break;
+      }
+      continue;
+    }
+    if (n > (length - count)) {
+      n = length - count;
+    }
+    int idx = rb_find(&terminator, 1, n);
+    if (idx >= 0) {
+      count += rb_read((uint8_t*)buffer + count, idx);
+      rb_read(); // remove the terminator
+      break;
+    }
+    count += rb_read((uint8_t*)buffer + count, n);
+    start = millis();
+  }
+  return count;
+}
+
+size_t BufferedInput::readBytesUntil(char terminator, uint8_t *buffer, size_t length) {
+  return readBytesUntil(terminator, (char*)buffer, length);
+}
+
+int BufferedInput::findDelimiter(const char* delimiters) {
+  if ((!streamPtr) || (delimiters == NULL)) {
+    return -1;
+  }
+  consumerNextByteIn();
+  return rb_find(delimiters, strlen(delimiters), rb_available());
+}
+
+int BufferedInput::findDelimiter(char delimiter) {
+  if (!streamPtr) {
+    return -1;
+  }
+  consumerNextByteIn();
+  return rb_find(&delimiter, 1, rb_available());
+}
+
 // this blocks!!
 void BufferedInput::flush() {
   if (!streamPtr) {
     return;
   }
-  nextByteIn();
+  consumerNextByteIn();
   streamPtr->flush();
 }
 
+/**
+    void useSPSC()
+    lock free single producer single consumer mode, nextByteIn() is the producer, read( ) etc are the consumer
+*/
+void BufferedInput::useSPSC() {
+  spsc = true;
+}
+
+// the consumer methods only read from the stream if not in SPSC mode
+void BufferedInput::consumerNextByteIn() {
+  if (!spsc) {
+    nextByteIn();
+  }
+}
+
 //===============  ringBuffer methods ==============
 // write() will silently fail if ringbuffer is full
+// the head and tail are mirror indices, see BufferedRingIndex.h, nextByteIn() only stores the head, read() only stores the tail
 
 /**
    _buf must be at least _size in length
-   _size is limited to 32766
+   _size is limited to BUFFERED_RING_MAX_SIZE, 32766 on AVR boards
    assumes size_t is atleast 16bits as specified by C spec
 */
 void BufferedInput::rb_init(uint8_t* _buf, size_t _size) {
@@ -173,28 +275,44 @@ void BufferedInput::rb_init(uint8_t* _buf, size_t _size) {
     rb_bufSize = 0; // prevents access to a NULL buf
   } else {
     // available etc returns int, check that _size fits in int
-    // limit _size to max int16_t - 1
-    if (_size >= 32766) {
-      _size = 32766; // (2^16/2)-1 minus 1 since uint16_t vars used
+    // limit _size to max int16_t - 1 for uint16_t indices, see BufferedRingIndex.h
+    if (_size >= BUFFERED_RING_MAX_SIZE) {
+      _size = BUFFERED_RING_MAX_SIZE;
     }
     rb_buf = _buf;
-    rb_bufSize = _size; // buffer_count use to detect buffer full
+    rb_bufSize = _size;
   }
 }
 
 void BufferedInput::rb_clear() {
-  rb_buffer_head = 0;
-  rb_buffer_tail = rb_buffer_head;
-  rb_buffer_count = 0;
+  bufferedRingStore(&rb_buffer_head, 0);
+  bufferedRingStore(&rb_buffer_tail, 0);
+}
+
+// number of bytes from idx to laterIdx
+size_t BufferedInput::rb_distance(BufferedRingIndex idx, BufferedRingIndex laterIdx) {
+  if (laterIdx >= idx) {
+    return laterIdx - idx;
+  } // else
+  return ((size_t)laterIdx) + 2 * ((size_t)rb_bufSize) - idx;
+}
+
+// mirror index advanced by n, n <= rb_bufSize
+BufferedRingIndex BufferedInput::rb_advance(BufferedRingIndex idx, size_t n) {
+  size_t newIdx = ((size_t)idx) + n;
+  if (newIdx >= 2 * ((size_t)rb_bufSize)) {
+    newIdx -= 2 * ((size_t)rb_bufSize);
+  }
+  return newIdx;
 }
 
 /*
    This should return size_t,
    but someone stuffed it up in the Arduino libraries
 */
-// defined in BufferedInput.h in BufferedOutputRingBuffer class declaration
-//int BufferedInput::available() { return buffer_count; }
-
+int BufferedInput::rb_available() {
+  return rb_distance(bufferedRingLoad(&rb_buffer_tail), bufferedRingLoad(&rb_buffer_head));
+}
 
 size_t BufferedInput::rb_getSize() {
   return rb_bufSize;
@@ -204,17 +322,16 @@ size_t BufferedInput::rb_getSize() {
    This should return size_t,
    but someone stuffed it up in the Arduino libraries
 */
-// defined in BufferedInput.h in BufferedOutputRingBuffer class declaration
 int BufferedInput::rb_availableForWrite() {
-  return (rb_bufSize - rb_buffer_count);
+  return (rb_bufSize - rb_available());
 }
 
 
 int BufferedInput::rb_peek() {
-  if (rb_buffer_count == 0) {
+  if (rb_available() == 0) {
     return -1;
   } else {
-    return rb_buf[rb_buffer_tail];
+    return rb_buf[rb_pos(bufferedRingLoad(&rb_buffer_tail))];
   }
 }
 
@@ -223,12 +340,11 @@ void BufferedInput::rb_dump(Stream * streamPtr) {
   if (streamPtr == NULL) {
     return;
   }
-  size_t idx = rb_buffer_tail;
-  size_t count = rb_buffer_count;
+  BufferedRingIndex idx = bufferedRingLoad(&rb_buffer_tail);
+  size_t count = rb_available();
   while (count > 0) {
-    unsigned char c = rb_buf[idx];
-    idx = rb_wrapBufferIdx(idx);
-    // if (buffer_count > 0) { checked above
+    unsigned char c = rb_buf[rb_pos(idx)];
+    idx = rb_advance(idx, 1);
     count--;
     //streamPtr->print(" "); streamPtr->print(idx);  streamPtr->print(":");
     streamPtr->print((char)c);
@@ -237,17 +353,67 @@ void BufferedInput::rb_dump(Stream * streamPtr) {
 }
 
 int BufferedInput::rb_read() {
-  if (rb_buffer_count == 0) {
+  if (rb_available() == 0) {
     return -1;
   } else {
-    unsigned char c = rb_buf[rb_buffer_tail];
-    rb_buffer_tail = rb_wrapBufferIdx(rb_buffer_tail);
-    // if (buffer_count > 0) { checked above
-    rb_buffer_count--;
+    BufferedRingIndex tail = bufferedRingLoad(&rb_buffer_tail);
+    unsigned char c = rb_buf[rb_pos(tail)];
+    bufferedRingStore(&rb_buffer_tail, rb_advance(tail, 1)); // release the byte to the producer after reading it
     return c;
   }
 }
 
+// returns number of bytes read, at most two memcpy's
+size_t BufferedInput::rb_read(uint8_t *buffer, size_t size) {
+  size_t avail = rb_available();
+  if (size > avail) {
+    size = avail;
+  }
+  if (size == 0) {
+    return 0;
+  }
+  BufferedRingIndex tail = bufferedRingLoad(&rb_buffer_tail);
+  size_t pos = rb_pos(tail);
+  size_t firstLen = rb_bufSize - pos; // bytes before the wrap
+  if (firstLen > size) {
+    firstLen = size;
+  }
+  memcpy(buffer, rb_buf + pos, firstLen);
+  memcpy(buffer + firstLen, rb_buf, size - firstLen); // wrapped part, if any
+  bufferedRingStore(&rb_buffer_tail, rb_advance(tail, size)); // release the bytes to the producer after reading them
+  return size;
+}
+
+// memchr's each contiguous block for each delimiter, each search stops at the first delimiter found so far
+int BufferedInput::rb_find(const char* delimiters, size_t count, size_t limit) {
+  size_t avail = rb_available();
+  if (limit > avail) {
+    limit = avail;
+  }
+  size_t pos = rb_pos(bufferedRingLoad(&rb_buffer_tail));
+  size_t offset = 0; // of this block from the tail
+  while (offset < limit) {
+    size_t len = rb_bufSize - pos; // bytes before the wrap
+    if (len > (limit - offset)) {
+      len = limit - offset;
+    }
+    const uint8_t *block = rb_buf + pos;
+    const uint8_t *found = NULL;
+    for (size_t i = 0; i < count; i++) {
+      const uint8_t *p = (const uint8_t *)memchr(block, delimiters[i], (found ? found : block + len) - block);
+      if (p) {
+        found = p;
+      }
+    }
+    if (found) {
+      return (int)(offset + (found - block));
+    }
+    offset += len;
+    pos = 0; // the rest, if any, is at the start of rb_buf
+  }
+  return -1;
+}
+
 // char dropped if buffer full
 size_t BufferedInput::rb_write(const uint8_t *_buffer, size_t _size) {
   if (_size > ((size_t)rb_availableForWrite())) { // limit to available space extra are dropped
@@ -262,7 +428,7 @@ size_t BufferedInput::rb_write(const uint8_t *_buffer, size_t _size) {
 // char dropped if buffer full
 size_t BufferedInput::rb_write(uint8_t b) {
   // check for buffer full
-  if (rb_buffer_count >= rb_bufSize) {
+  if (rb_availableForWrite() <= 0) {
     return 0;
   }
   // else
@@ -272,17 +438,7 @@ size_t BufferedInput::rb_write(uint8_t b) {
 
 void BufferedInput::rb_internalWrite(uint8_t b) {
   // check for buffer full done by caller
-  rb_buf[rb_buffer_head] = b;
-  rb_buffer_head = rb_wrapBufferIdx(rb_buffer_head);
-  rb_buffer_count++;
-}
-
-uint16_t BufferedInput::rb_wrapBufferIdx(uint16_t idx) {
-  if (idx >= (rb_bufSize - 1)) {
-    // wrap around
-    idx = 0;
-  } else {
-    idx++;
-  }
-  return idx;
+  BufferedRingIndex head = bufferedRingLoad(&rb_buffer_head);
+  rb_buf[rb_pos(head)] = b;
+  bufferedRingStore(&rb_buffer_head, rb_advance(head, 1)); // publish after the byte is written
 }
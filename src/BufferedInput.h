@@ -37,6 +37,7 @@
 #include <Printable.h>
 
 #include "SafeString.h" // for SSTRING_DEBUG and SafeString::Output and stream support
+#include "BufferedRingIndex.h" // uint16_t indices on AVR, size_t on larger boards
 
 // handle namespace arduino
 #include "SafeStringNameSpaceStart.h"
@@ -65,7 +66,7 @@ class BufferedInput : public Stream {
          BufferedInput(size_t _bufferSize, uint8_t *_buf);
 
          buf -- the user allocated buffer to store the bytes, must be at least bufferSize long.  Defaults to an internal 8 char buffer if buf is omitted or NULL
-         bufferSize -- number of bytes to buffer,max bufferSize is limited to 32766. Defaults to an internal 8 char buffer if bufferSize is < 8 or is omitted
+         bufferSize -- number of bytes to buffer,max bufferSize is limited to 32766 on AVR boards, see BufferedRingIndex.h. Defaults to an internal 8 char buffer if bufferSize is < 8 or is omitted
     */
     BufferedInput(size_t _bufferSize, uint8_t *_buf);
 
@@ -85,12 +86,63 @@ class BufferedInput : public Stream {
     virtual int availableForWrite();
     size_t getSize(); // returns buffer size
 
+    /**
+      size_t readBytes(char *buffer, size_t length)
+      
+      Reads upto length bytes, waiting upto the Stream's setTimeout( ) for each more byte, like Stream::readBytes( ).<br>
+      The buffered bytes are copied in blocks, instead of one read() at a time.
+      
+      @param buffer -- where the bytes are copied to, not '\0' terminated
+      @param length -- the most bytes to read
+      @return the number of bytes read, less than length if it timed out
+      */
+    virtual size_t readBytes(char *buffer, size_t length);
+    virtual size_t readBytes(uint8_t *buffer, size_t length);
+
+    /**
+      size_t readBytesUntil(char terminator, char *buffer, size_t length)
+      
+      Reads upto length bytes, stopping at the terminator, waiting upto the Stream's setTimeout( ) for each more byte, like Stream::readBytesUntil( ).<br>
+      The terminator is removed from the input but is not copied to buffer. The buffered bytes are searched and copied in blocks, instead of one read() at a time.
+      
+      @param terminator -- the byte to stop at
+      @param buffer -- where the bytes are copied to, not '\0' terminated
+      @param length -- the most bytes to read
+      @return the number of bytes copied to buffer, not counting the terminator
+      */
+    virtual size_t readBytesUntil(char terminator, char *buffer, size_t length);
+    virtual size_t readBytesUntil(char terminator, uint8_t *buffer, size_t length);
+
+    /**
+      int findDelimiter(const char* delimiters)
+      
+      Looks for the first of the delimiters in the buffered input, without removing anything, e.g. to check a whole line has arrived before reading it.<br>
+      Unlike Stream::find( ), this does not wait for more input or read any of it.
+      
+      @param delimiters -- the bytes to look for, e.g. "\r\n"
+      @return the number of bytes before the first delimiter, so read(), or readBytes( ) of this many, stops just before it, or -1 if none of the delimiters have been received yet
+      */
+    int findDelimiter(const char* delimiters);
+    int findDelimiter(char delimiter);
+
     // Counts when number of chars dropped due to full inputBuffer
     // count is reset to zero at the end of this call
     int maxStreamAvailable();
     int maxBufferUsed();
 
+    /**
+      void useSPSC()
+      
+      Switches to the lock free single producer single consumer mode, call this in setup() after connect( ).<br>
+      In this mode one core, or a timer ISR, calls nextByteIn() to fill the buffer from the stream while another core reads the buffered input.<br>
+      available(), read(), peek(), write(), availableForWrite() and flush() do not call nextByteIn( ).<br>
+      Bytes are left in the stream, not dropped, if the buffer is full.
+      */
+    void useSPSC();
+
   private:
+    void consumerNextByteIn(); // nextByteIn() unless in SPSC mode
+    bool spsc; // true if useSPSC() called
     Stream* streamPtr;
     int maxAvail;
     int bufUsed;
@@ -99,15 +151,15 @@ class BufferedInput : public Stream {
     // ringBuffer methods
     /**
        _buf must be at least _size in length
-       _size is limited to 32766
+       _size is limited to BUFFERED_RING_MAX_SIZE, 32766 on AVR boards
     */
     void rb_init(uint8_t* _buf, size_t _size);
     // from Stream
-    inline int rb_available() {
-      return rb_buffer_count;
-    }
+    int rb_available();
     int rb_peek();
     int rb_read();
+    size_t rb_read(uint8_t *buffer, size_t size); // returns number of bytes read, at most two memcpy's
+    int rb_find(const char* delimiters, size_t count, size_t limit); // offset of the first delimiter in the first limit bytes, -1 if none
     size_t rb_write(uint8_t b); // does not block, drops bytes if buffer full
     size_t rb_write(const uint8_t *buffer, size_t size); // does not block, drops bytes if buffer full
     int rb_availableForWrite(); // {   return (bufSize - buffer_count); }
@@ -115,11 +167,14 @@ class BufferedInput : public Stream {
     void rb_clear();
     void rb_dump(Stream* streamPtr);
     uint8_t* rb_buf;
-    uint16_t rb_bufSize;
-    uint16_t rb_buffer_head;
-    uint16_t rb_buffer_tail;
-    uint16_t rb_buffer_count;
-    uint16_t rb_wrapBufferIdx(uint16_t idx);
+    BufferedRingIndex rb_bufSize;
+    BufferedRingIndex rb_buffer_head; // mirror index 0 to 2*rb_bufSize-1, only stored by nextByteIn()
+    BufferedRingIndex rb_buffer_tail; // mirror index 0 to 2*rb_bufSize-1, only stored by read()
+    inline size_t rb_pos(BufferedRingIndex idx) { // position in rb_buf of a mirror index
+      return (idx < rb_bufSize) ? idx : (idx - rb_bufSize);
+    }
+    BufferedRingIndex rb_advance(BufferedRingIndex idx, size_t n);
+    size_t rb_distance(BufferedRingIndex idx, BufferedRingIndex laterIdx);
     void rb_internalWrite(uint8_t b);
 };
 
@@ -40,7 +40,7 @@
      BufferedOutput(size_t _bufferSize, uint8_t *_buf, BufferedOutputMode mode, bool allOrNothing = true);
 
      buf -- the user allocated buffer to store the bytes, must be at least bufferSize long.  Defaults to an internal 8 char buffer if buf is omitted or NULL  
-     bufferSize -- number of bytes to buffer,max bufferSize is limited to 32766. Defaults to an internal 8 char buffer if bufferSize is < 8 or is omitted  
+     bufferSize -- number of bytes to buffer,max bufferSize is limited to 32766 on AVR boards, see BufferedRingIndex.h. Defaults to an internal 8 char buffer if bufferSize is < 8 or is omitted  
      mode -- BLOCK_IF_FULL, DROP_UNTIL_EMPTY or DROP_IF_FULL  
              BLOCK_IF_FULL,    like normal print, but with a buffer. Use this to see ALL the output, but will block the loop() when the output buffer fills  
              DROP_UNTIL_EMPTY, when the output buffer is full, drop any more chars until it completely empties.  ~~<CR><NL> is inserted in the output to show chars were dropped.  
@@ -55,13 +55,34 @@
 BufferedOutput::BufferedOutput( size_t _bufferSize, uint8_t _buf[],  BufferedOutputMode _mode, bool _allOrNothing) {
   rb_buf = NULL;
   rb_bufSize = 0; // prevents access to a NULL buf
+  rb_headPtr = &rb_buffer_head;
+  nextSink = NULL;
+  sinkSource = NULL;
+  channelMux = NULL;
+  nextChannel = NULL;
+  muxCurrent = NULL;
+  channelId = 0;
+  channelWeight = 1;
+  muxCredit = 0;
+  sendTimerBytes = 1;
+  streamDropMark = false;
+  sinkSkipLine = false;
   rb_clear();
+  rb_clearToIdx = 0;
+  rb_clearRequests = 0;
+  rb_clearsDone = 0;
+  spsc = false;
+  higherLane = NULL;
+  lowerLane = NULL;
+  lastCharSent = '\n';
+  clearMode = CLEAR_LAST_BYTES;
   serialPtr = NULL;
   streamPtr = NULL; // always non-NULL after connect( )  either set to HardwareSerial OR Stream
   debugOut = NULL;
   txBufferSize = 0;  // if > 0 then serialPtr != NULL, but can have serialPtr != NULL and txBufferSize == 0
   dropMarkWritten = false;
   lastCharWritten = ' ';
+  reservedLen = 0;
   baudRate = 0;
   mode = _mode; // default DROP_IF_FULL if not passed in
   allOrNothingSetting = _allOrNothing;
@@ -75,6 +96,14 @@ BufferedOutput::BufferedOutput( size_t _bufferSize, uint8_t _buf[],  BufferedOut
   }
   us_perByte = 0;
   sendTimerStart = 0;
+  pacing = NULL; // no pacing
+  maxMicrosPerCall = 0; // no limit
+  recordFormatter = NULL; // no deferred records
+  flushWaiting = false;
+  flushTarget = 0;
+  flushCallback = NULL;
+  repeats = NULL; // not suppressing repeats
+  stats = NULL; // no statistics
 }
 
 /**
@@ -237,7 +266,7 @@ void BufferedOutput::protect() {
   }
 }
 
-// clears space in outgoing (write) buffer, by removing last bytes written, until a protected section reached
+// clears space in outgoing (write) buffer, by removing last bytes written, or whole lines see setClearSpaceMode(), until a protected section reached
 //  the Serial Tx buffer is NOT changed
 int BufferedOutput::clearSpace(size_t len) {
   waitForEmpty = false;
@@ -255,19 +284,55 @@ int BufferedOutput::clearSpace(size_t len) {
     return (avail - 8); // have space and avail > 8 because > len+8
   }
   // else len < internalAvailableForWrite() which includes Serial Tx buffer space
+  if (spsc || nextSink) {
+    return (avail - 8); // cannot remove output the consumer, or a sink, may be sending
+  }
   size_t txAvail = internalStreamAvailableForWrite(); // stream available -1 or 0
   if (rb_clearSpace(len - txAvail)) { // allow for space in stream Tx buffer
-    dropMarkWritten = false;
-    writeDropMark();
+    if (repeats) {
+      repeats->lineOk = false; // the current or last line may have been removed
+      repeats->lastValid = false;
+    }
+    flushTarget = bufferedRingLoad(rb_headPtr); // the mark may have been removed, wait for what is left
+    if (clearMode != CLEAR_OLDEST_LINES) { // CLEAR_OLDEST_LINES replaces the lines removed with a drop mark
+      dropMarkWritten = false;
+      writeDropMark();
+    }
   }
   return (internalAvailableForWrite() - 4); // perhaps should be -8??
 }
 
+void BufferedOutput::setClearSpaceMode(BufferedOutputClearMode _clearMode) {
+  clearMode = _clearMode;
+}
+
+unsigned long BufferedOutput::getClearedLines() {
+  return stats ? stats->clearedLines : 0;
+}
+
+unsigned long BufferedOutput::getClearedBytes() {
+  return stats ? stats->clearedBytes : 0;
+}
+
 // only clears the BufferedOutput buffer not any HardwareSerial buffer
 // clears BufferedOutput buffer even if protected with protect()
 void BufferedOutput::clear() {
+  reservedLen = 0; // any reserved space has gone
+  if (spsc) {
+    // the consumer clears the buffer and writes the drop mark on its next nextByteOut()
+    // no space is freed until then, so leave allOrNothing and waitForEmpty unchanged
+    rb_requestClear();
+    return;
+  }
   bool notEmpty = (rb_available() != 0);
   rb_clear();
+  flushTarget = 0; // the output upto the mark has gone
+  if (repeats) {
+    repeats->lineLen = 0;
+    repeats->holding = false;
+    repeats->lastValid = false;
+    repeats->count = 0;
+  }
   if (notEmpty) {
     dropMarkWritten = false;
     if (!dropMarkWritten) {
@@ -318,7 +383,10 @@ int BufferedOutput::internalAvailableForWrite() {
   if (!streamPtr) {
     return 0;
   }
-  int rtn = internalStreamAvailableForWrite();
+  int rtn = 0;
+  if (directWriteAllowed()) { // only count the stream's room if write( ) can use it, not in SPSC mode, paced, etc
+    rtn = internalStreamAvailableForWrite();
+  }
   int ringAvail = rb_availableForWrite();
   if (ringAvail <= 4) {
     ringAvail = 0;
@@ -334,7 +402,7 @@ int BufferedOutput::availableForWrite() {
   if (!streamPtr) {
     return 0;
   }
-  nextByteOut(); // try sending first to free some buffer space
+  producerNextByteOut(); // try sending first to free some buffer space
   if (waitForEmpty) {
     return 0;
   } // else
@@ -358,15 +426,53 @@ size_t BufferedOutput::terminateLastLine() {
 // NOTE: if DROP_UNTIL_EMPTY and allOrNothing == true,
 //      then when buffer, pretend allOrNothing == false so that will get some output
 size_t BufferedOutput::write(const uint8_t *buffer, size_t size) {
+  if (sinkSource) {
+    return sinkSource->write(buffer, size); // a sink has no buffer of its own
+  }
   if (!streamPtr) {
     return 0;
   }
-  nextByteOut(); // sets waitForEmpty false if !DROP_UNTIL_EMPTY
+  if (repeats && (!repeats->busy)) {
+    return repeatWrite(buffer, size);
+  }
+  producerNextByteOut(); // sets waitForEmpty false if !DROP_UNTIL_EMPTY
   if (mode == BLOCK_IF_FULL) { // ignores all or nothing
-    for (size_t i = 0; i < size; i++) {
-      lastCharWritten = buffer[i];
-      write(lastCharWritten); // sets dropMarkWritten = false; and calls nextByteOut each time
+    if (size == 0) {
+      return 0;
+    }
+#ifdef DEBUG
+    bool showDelay = true;
+#endif // DEBUG    
+    dropMarkWritten = false; // something will be written!!
+    lastCharWritten = buffer[size - 1];
+    size_t written = 0;
+    unsigned long blockStart = 0;
+    bool blocked = false;
+    while (written < size) {
+      // copy as much as will fit in one go, then release some
+      written += rb_write(buffer + written, size - written);
+      if ((written < size) && (!blocked)) {
+        blocked = true;
+        blockStart = statsBlockStart(size - written);
+      }
+      if (written < size) {
+        // block here
+#ifdef DEBUG
+        if (showDelay) {
+          showDelay = false; // only show this once per write
+          if (debugOut) {
+            debugOut->print("-1-"); // indicate write( ) is delaying the loop()
+          }
+        }
+#endif // DEBUG    
+        delay(1); // wait 1ms, expect this to call yield() for those boards that need it e.g. ESP8266 and ESP32
+      }
+      nextByteOut(); // try sending to free some buffer space
     }
+    if (blocked) {
+      statsBlockEnd(blockStart);
+    }
+    statsWritten(size);
     return size;
   } // else not BLOCK_IF_FULL
 
@@ -376,6 +482,7 @@ size_t BufferedOutput::write(const uint8_t *buffer, size_t size) {
     if (!dropMarkWritten) {
       writeDropMark();
     }
+    statsDropped(size);
     allOrNothing = allOrNothingSetting; // cleared on clear() and makeSpace, reset to input setting
     return 0;
   }
@@ -386,6 +493,7 @@ size_t BufferedOutput::write(const uint8_t *buffer, size_t size) {
     if (!dropMarkWritten) {
       writeDropMark();
     }
+    statsDropped(size);
     waitForEmpty = true;
     return 0;
   } // else  writing a partial at least
@@ -393,7 +501,7 @@ size_t BufferedOutput::write(const uint8_t *buffer, size_t size) {
   // reduce size to fit
   size_t initSize = size;
   size_t strWriteLen = 0; // nothing written yet
-  if (rb_available() == 0) { // nothing in the ringBuffer
+  if (directWriteAllowed()) {
     size_t avail = internalStreamAvailableForWrite(); // includes -1
     strWriteLen = size; // try to write it all
     if (avail < strWriteLen) { // only write some of it
@@ -402,6 +510,7 @@ size_t BufferedOutput::write(const uint8_t *buffer, size_t size) {
     if (strWriteLen > 0) { // write directly to Serial Tx Buffer
       streamPtr->write(buffer, strWriteLen);
       lastCharWritten = buffer[strWriteLen - 1]; // strWriteLen > 0 here
+      lastCharSent = lastCharWritten;
       dropMarkWritten = false;
       buffer += strWriteLen; // update buffer ptr for what has been written
       size -= strWriteLen;  // reduce size left to be written
@@ -420,44 +529,446 @@ size_t BufferedOutput::write(const uint8_t *buffer, size_t size) {
     if (rbWriteLen > 0) {
       dropMarkWritten = false;
       lastCharWritten = buffer[rbWriteLen - 1];
-    }
-    for (size_t i = 0; i < rbWriteLen; i++) {
-      rb_write(buffer[i]);
+      rb_write(buffer, rbWriteLen);
     }
   } // else all written to Serial Tx buffer and so ringBuffer is empty
 
   size_t rtnLen = rbWriteLen + strWriteLen;
+  statsWritten(rtnLen);
   if (rtnLen < initSize) { // dropped something
     if (!dropMarkWritten) {
       writeDropMark();
     }
+    statsDropped(initSize - rtnLen);
     waitForEmpty = true;
   }
   allOrNothing = allOrNothingSetting; // cleared on clear() and makeSpace, reset to input setting
   return rtnLen;
 }
 
+// applies the same mode and allOrNothing rules as write(buf,size)
+// but only uses the ring buffer, the reserved space is not written directly to the stream
+// if len will not fit before the end of the ring buffer, the end is padded with '\0's, which are not output, and the space at the start is returned
+uint8_t* BufferedOutput::reserve(size_t &len) {
+  reservedLen = 0;
+  if ((!streamPtr) || (len == 0) || (rb_bufSize == 0)) {
+    len = 0;
+    return NULL;
+  }
+  producerNextByteOut(); // sets waitForEmpty false if !DROP_UNTIL_EMPTY
+  repeatBreak();
+  if (mode == BLOCK_IF_FULL) { // ignores all or nothing
+#ifdef DEBUG
+    bool showDelay = true;
+#endif // DEBUG    
+    if (len > rb_bufSize) {
+      len = rb_bufSize;
+    }
+    unsigned long blockStart = 0;
+    bool blocked = false;
+    while (!rb_reserve(len, len)) {
+      // block here
+      if (!blocked) {
+        blocked = true;
+        blockStart = statsBlockStart(len);
+      }
+#ifdef DEBUG
+      if (showDelay) {
+        showDelay = false; // only show this once per reserve
+        if (debugOut) {
+          debugOut->print("-1-"); // indicate reserve( ) is delaying the loop()
+        }
+      }
+#endif // DEBUG    
+      delay(1); // wait 1ms, expect this to call yield() for those boards that need it e.g. ESP8266 and ESP32
+      nextByteOut(); // try sending first to free some buffer space
+    }
+    if (blocked) {
+      statsBlockEnd(blockStart);
+    }
+    dropMarkWritten = false; // something will be written!!
+  } else {
+    // DROP_IF_FULL or DROP_UNTIL_EMPTY
+    size_t btbs = bytesToBeSent(); // DOES NOT call nextByteOut
+    bool dropIt = (waitForEmpty && btbs);
+    if (!dropIt) {
+      size_t rbAvail = 0;
+      if (rb_availableForWrite() > 4) {
+        rbAvail = rb_availableForWrite() - 4; // leave 4 for next write attempt drop mark
+      }
+      if (!rb_reserve(len, rbAvail)) {
+        // len will not fit in one piece
+        if ((btbs != 0) && allOrNothing) {
+          dropIt = true;
+        } else {
+          // partial, just what is left before the end of the ring buffer
+          size_t contiguous = rb_bufSize - rb_pos(bufferedRingLoad(rb_headPtr));
+          len = (contiguous < rbAvail) ? contiguous : rbAvail;
+          dropIt = (len == 0);
+        }
+      }
+    }
+    if (dropIt) {
+      if (!dropMarkWritten) {
+        writeDropMark();
+      }
+      statsDropped(len);
+      waitForEmpty = true;
+      allOrNothing = allOrNothingSetting; // cleared on clear() and makeSpace, reset to input setting
+      len = 0;
+      return NULL;
+    }
+  }
+  reservedLen = len;
+  return rb_buf + rb_pos(bufferedRingLoad(rb_headPtr));
+}
+
+size_t BufferedOutput::commit(size_t used) {
+  if (used > reservedLen) {
+    used = reservedLen; // commit without reserve or too many
+  }
+  reservedLen = 0;
+  if (used == 0) {
+    return 0;
+  }
+  BufferedRingIndex head = bufferedRingLoad(rb_headPtr);
+  lastCharWritten = rb_buf[rb_pos(head) + used - 1];
+  dropMarkWritten = false;
+  bufferedRingStore(&rb_buffer_head, rb_advance(head, used)); // publish
+  statsWritten(used);
+  allOrNothing = allOrNothingSetting; // cleared on clear() and makeSpace, reset to input setting
+  producerNextByteOut(); // start sending it
+  return used;
+}
+
+void BufferedOutput::setFormatter(BufferedOutputFormatter formatter) {
+  recordFormatter = formatter;
+  for (BufferedOutput* sink = nextSink; sink; sink = sink->nextSink) {
+    sink->recordFormatter = formatter;
+  }
+}
+
+size_t BufferedOutput::logDeferred(uint8_t formatId) {
+  return logDeferred(formatId, (const long*)NULL, 0);
+}
+
+size_t BufferedOutput::logDeferred(uint8_t formatId, long arg0) {
+  long args[1] = {arg0};
+  return logDeferred(formatId, args, 1);
+}
+
+size_t BufferedOutput::logDeferred(uint8_t formatId, long arg0, long arg1) {
+  long args[2] = {arg0, arg1};
+  return logDeferred(formatId, args, 2);
+}
+
+size_t BufferedOutput::logDeferred(uint8_t formatId, long arg0, long arg1, long arg2) {
+  long args[3] = {arg0, arg1, arg2};
+  return logDeferred(formatId, args, 3);
+}
+
+size_t BufferedOutput::logDeferred(uint8_t formatId, long arg0, long arg1, long arg2, long arg3) {
+  long args[4] = {arg0, arg1, arg2, arg3};
+  return logDeferred(formatId, args, 4);
+}
+
+// the formatId and each arg are stored in 6 bit groups, low bits first, 0x80 | 6bits with 0x40 also set on the last group
+// so the record bytes, after the mark, are all >= 0x80 and never contain a '\0' protect byte or a \n
+static size_t recordEncode(uint8_t *p, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x40) {
+    p[n++] = 0x80 | (v & 0x3F);
+    v >>= 6;
+  }
+  p[n++] = 0xC0 | v;
+  return n;
+}
+
+// a record is BUFFERED_OUTPUT_RECORD_MARK, the encoded formatId and args, then \r\n, so it is always removed as part of a whole line
+// it is written all or nothing and never directly to the stream
+size_t BufferedOutput::logDeferred(uint8_t formatId, const long args[], uint8_t argCount) {
+  if ((!streamPtr) || (!recordFormatter) || channelMux) {
+    return 0; // records are not formatted on channels, the mux would send the encoded bytes
+  }
+  if (argCount > BUFFERED_OUTPUT_RECORD_MAX_ARGS) {
+    argCount = BUFFERED_OUTPUT_RECORD_MAX_ARGS;
+  }
+  uint8_t record[1 + 2 + 6 * BUFFERED_OUTPUT_RECORD_MAX_ARGS + 2]; // mark, formatId, 32bit args, \r\n
+  size_t len = 0;
+  record[len++] = BUFFERED_OUTPUT_RECORD_MARK;
+  len += recordEncode(record + len, formatId);
+  for (uint8_t i = 0; i < argCount; i++) {
+    int32_t arg = (int32_t)args[i];
+    len += recordEncode(record + len, (((uint32_t)arg) << 1) ^ ((uint32_t)(arg >> 31))); // zigzag, small -ve args are short also
+  }
+  record[len++] = '\r';
+  record[len++] = '\n';
+
+  producerNextByteOut(); // sets waitForEmpty false if !DROP_UNTIL_EMPTY
+  repeatBreak();
+  if (mode == BLOCK_IF_FULL) {
+    if ((len + 4) > rb_bufSize) {
+      statsDropped(len); // can never fit
+      return 0;
+    }
+    unsigned long blockStart = 0;
+    bool blocked = false;
+    while (rb_availableForWrite() < ((int)len)) {
+      if (!blocked) {
+        blocked = true;
+        blockStart = statsBlockStart(len - rb_availableForWrite());
+      }
+      delay(1); // wait 1ms, expect this to call yield() for those boards that need it e.g. ESP8266 and ESP32
+      nextByteOut(); // try sending to free some buffer space
+    }
+    if (blocked) {
+      statsBlockEnd(blockStart);
+    }
+  } else if ((waitForEmpty && bytesToBeSent()) || (rb_availableForWrite() < ((int)(len + 4)))) { // leave 4 for the drop mark
+    if (!dropMarkWritten) {
+      writeDropMark();
+    }
+    statsDropped(len);
+    waitForEmpty = true;
+    allOrNothing = allOrNothingSetting; // cleared on clear() and makeSpace, reset to input setting
+    return 0;
+  }
+  rb_write(record, len);
+  dropMarkWritten = false;
+  lastCharWritten = '\n';
+  statsWritten(len);
+  allOrNothing = allOrNothingSetting; // cleared on clear() and makeSpace, reset to input setting
+  producerNextByteOut(); // start sending it
+  return len;
+}
+
+BufferedOutputRepeats::BufferedOutputRepeats() {
+  busy = false;
+  maxMillis = 0;
+  lineStart = 0;
+  lineLen = 0;
+  lineOk = false;
+  holding = false;
+  hash = 0;
+  lineMillis = 0;
+  lastHash = 0;
+  lastLen = 0;
+  lastValid = false;
+  count = 0;
+  runStart = 0;
+  suppressed = 0;
+}
+
+void BufferedOutput::setSuppressRepeats(BufferedOutputRepeats& _repeats, bool suppress, unsigned long maxMillis) {
+  if (spsc || sinkSource) {
+    return; // the consumer may be sending the line, a sink is not written to
+  }
+  if (repeats && repeats->count) {
+    repeatWriteSummary(false); // for the last run of repeats, before stopping or changing the repeats state
+  }
+  if (!suppress) {
+    repeats = NULL;
+    return;
+  }
+  if (repeats != &_repeats) {
+    _repeats.suppressed = 0;
+  }
+  repeats = &_repeats;
+  repeats->busy = false;
+  repeats->maxMillis = maxMillis;
+  repeats->lineLen = 0;
+  repeats->holding = false;
+  repeats->lastValid = false;
+  repeats->count = 0;
+}
+
+unsigned long BufferedOutput::getRepeatsSuppressed() {
+  return repeats ? repeats->suppressed : 0;
+}
+
+// each line is written by write( ) as usual, and removed again at its \n if it is the same as the last line
+size_t BufferedOutput::repeatWrite(const uint8_t *buffer, size_t size) {
+  bool dropAll = false; // allOrNothing applies to the whole write( ), not to each line
+  if ((mode != BLOCK_IF_FULL) && allOrNothing && (size > 0)) {
+    producerNextByteOut(); // sets waitForEmpty false if !DROP_UNTIL_EMPTY
+    if ((bytesToBeSent() != 0) && (availableForWrite() < ((int)size))) {
+      if (!dropMarkWritten) {
+        writeDropMark();
+      }
+      statsDropped(size);
+      waitForEmpty = true;
+      dropAll = true; // still track the lines so a dropped line is not taken as a repeat
+    }
+  }
+  repeats->busy = true;
+  size_t written = 0;
+  while (size > 0) {
+    const uint8_t *nl = (const uint8_t *)memchr(buffer, '\n', size);
+    size_t len = (nl == NULL) ? size : (size_t)(nl - buffer + 1);
+    if (repeats->lineLen == 0) { // start of a line
+      repeats->lineStart = bufferedRingLoad(rb_headPtr);
+      repeats->lineMillis = millis();
+      repeats->lineOk = true;
+      repeats->holding = true;
+      repeats->hash = 2166136261UL; // FNV-1a
+    }
+    size_t n = dropAll ? 0 : write(buffer, len);
+    if (n < len) {
+      repeats->lineOk = false; // some dropped
+    }
+    for (size_t i = 0; i < len; i++) {
+      repeats->hash = (repeats->hash ^ buffer[i]) * 16777619UL;
+    }
+    repeats->lineLen += len;
+    written += n;
+    buffer += len;
+    size -= len;
+    if (nl) {
+      repeatLineEnd();
+    }
+  }
+  repeats->busy = false;
+  return written;
+}
+
+// true if the current line is still all in the buffer, for this and for each sink
+bool BufferedOutput::repeatLineInBuffer() {
+  if (!repeats->lineOk) {
+    return false;
+  }
+  size_t len = rb_distance(repeats->lineStart, bufferedRingLoad(rb_headPtr));
+  if (len > ((size_t)rb_available())) {
+    return false;
+  }
+  for (BufferedOutput* sink = nextSink; sink; sink = sink->nextSink) {
+    if (len > ((size_t)sink->rb_available())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BufferedOutput::repeatLineEnd() {
+  repeats->holding = false;
+  bool inBuffer = repeatLineInBuffer() && (rb_distance(repeats->lineStart, bufferedRingLoad(rb_headPtr)) == repeats->lineLen); // no drop mark in it
+  if (inBuffer && repeats->lastValid && (repeats->hash == repeats->lastHash) && (repeats->lineLen == repeats->lastLen)) {
+    bufferedRingStore(&rb_buffer_head, repeats->lineStart); // remove the repeat
+    if (repeats->count == 0) {
+      repeats->runStart = millis();
+    }
+    repeats->count++;
+    repeats->suppressed++;
+    repeats->lineLen = 0;
+    repeatCheckTime();
+    return;
+  }
+  if (repeats->count) {
+    repeatWriteSummary(inBuffer); // in front of this line if it is still all in the buffer
+  }
+  repeats->lastHash = repeats->hash;
+  repeats->lastLen = repeats->lineLen;
+  repeats->lastValid = repeats->lineOk;
+  repeats->lineLen = 0;
+}
+
+// the summary is moved in front of the current line if beforeLine, else written after it
+void BufferedOutput::repeatWriteSummary(bool beforeLine) {
+  createSafeString(sfSummary, 40);
+  sfSummary = F("last line repeated ");
+  sfSummary += repeats->count;
+  sfSummary += F(" times\r\n");
+  repeats->count = 0;
+  size_t len = sfSummary.length();
+  if (beforeLine && (rb_availableForWrite() >= ((int)(len + 4)))) { // leave 4 for the drop mark
+    rb_sinksMakeRoom(len);
+    BufferedRingIndex head = bufferedRingLoad(rb_headPtr);
+    for (size_t i = rb_distance(repeats->lineStart, head); i > 0; i--) {
+      BufferedRingIndex from = rb_advance(repeats->lineStart, i - 1);
+      rb_buf[rb_pos(rb_advance(from, len))] = rb_buf[rb_pos(from)];
+    }
+    for (size_t i = 0; i < len; i++) {
+      rb_buf[rb_pos(rb_advance(repeats->lineStart, i))] = sfSummary.charAt(i);
+    }
+    bufferedRingStore(&rb_buffer_head, rb_advance(head, len));
+    repeats->lineStart = rb_advance(repeats->lineStart, len);
+    statsWritten(len);
+    return;
+  }
+  bool wasBusy = repeats->busy;
+  repeats->busy = true; // the summary is not checked
+  write((const uint8_t*)sfSummary.c_str(), len);
+  repeats->busy = wasBusy;
+}
+
+// called by nextByteOut(), and for each repeat, to write the summary at least every maxMillis
+void BufferedOutput::repeatCheckTime() {
+  if ((repeats->count == 0) || (repeats->maxMillis == 0) || ((millis() - repeats->runStart) < repeats->maxMillis)) {
+    return;
+  }
+  if (repeats->lineLen == 0) {
+    repeatWriteSummary(false);
+  } else if ((!repeats->busy) && repeatLineInBuffer()) {
+    repeatWriteSummary(true); // in front of the partly written line
+  } // else wait for the end of the line
+}
+
+// reserve( ) and logDeferred( ) output is not checked, the next line is not compared to the line before it
+void BufferedOutput::repeatBreak() {
+  if (!repeats) {
+    return;
+  }
+  if (repeats->count && (repeats->lineLen == 0)) {
+    repeatWriteSummary(false);
+  }
+  repeats->lineOk = false;
+  repeats->lastValid = false;
+}
+
+// the partly written line is held back so it can still be removed if it turns out to be a repeat
+// it is released when the buffer is full or after BUFFERED_OUTPUT_REPEAT_HOLD_MS
+size_t BufferedOutput::repeatHeld() {
+  BufferedOutput* src = sinkSource ? sinkSource : this;
+  if ((!src->repeats) || (!src->repeats->holding) || (!src->repeats->lineOk)) {
+    return 0;
+  }
+  size_t held = rb_distance(src->repeats->lineStart, bufferedRingLoad(rb_headPtr));
+  if ((held > ((size_t)rb_available())) || (src->rb_availableForWrite() <= 4) ||
+      ((millis() - src->repeats->lineMillis) >= BUFFERED_OUTPUT_REPEAT_HOLD_MS)) {
+    return 0; // already partly sent or released
+  }
+  return held;
+}
+
 size_t BufferedOutput::write(uint8_t c) {
+  if (sinkSource) {
+    return sinkSource->write(c); // a sink has no buffer of its own
+  }
   if (!streamPtr) {
     return 0;
   }
+  if (repeats && (!repeats->busy)) {
+    return repeatWrite(&c, 1);
+  }
 #ifdef DEBUG
   bool showDelay = true;
 #endif // DEBUG    
-  nextByteOut(); // sets waitForEmpty false if !DROP_UNTIL_EMPTY
+  producerNextByteOut(); // sets waitForEmpty false if !DROP_UNTIL_EMPTY
   if (mode != BLOCK_IF_FULL) {
     if ((waitForEmpty) || (rb_availableForWrite() <= 4)) {
       if (!dropMarkWritten) {
         writeDropMark();
       }
+      statsDropped(1);
       allOrNothing = allOrNothingSetting; // cleared on clear() and makeSpace, reset to input setting
       return 0;
     }
     // else have some ringBuffer space
-    if ((rb_available() == 0)) { //(txBufferSize) &&
+    if (directWriteAllowed()) { //(txBufferSize) &&
       if (internalStreamAvailableForWrite()) {
         lastCharWritten = c;
+        lastCharSent = c;
         streamPtr->write(lastCharWritten);
+        statsWritten(1);
         dropMarkWritten = false;
         allOrNothing = allOrNothingSetting; // cleared on clear() and makeSpace, reset to input setting
         return 1;
@@ -467,11 +978,14 @@ size_t BufferedOutput::write(uint8_t c) {
     if (rb_availableForWrite() > 4) { // leave space for next |\r\n
       dropMarkWritten = false;
       lastCharWritten = c;
-      return rb_write(lastCharWritten);
+      rb_write(lastCharWritten);
+      statsWritten(1);
+      return 1;
     } else {
       if (!dropMarkWritten) {
         writeDropMark();
       }
+      statsDropped(1);
       waitForEmpty = true;
       allOrNothing = allOrNothingSetting; // cleared on clear() and makeSpace, reset to input setting
       return 0;
@@ -481,8 +995,11 @@ size_t BufferedOutput::write(uint8_t c) {
     dropMarkWritten = false; // something will be written!!
     if (rb_availableForWrite() != 0) {
       lastCharWritten = c;
-      return rb_write(lastCharWritten);
+      rb_write(lastCharWritten);
+      statsWritten(1);
+      return 1;
     } else { // block here
+      unsigned long blockStart = statsBlockStart(1);
       while (rb_availableForWrite() == 0) {
         // spin
 #ifdef DEBUG
@@ -496,8 +1013,11 @@ size_t BufferedOutput::write(uint8_t c) {
         delay(1); // wait 1ms, expect this to call yield() for those boards that need it e.g. ESP8266 and ESP32
         nextByteOut(); // try sending first to free some buffer space
       }
+      statsBlockEnd(blockStart);
       lastCharWritten = c;
-      return rb_write(lastCharWritten);
+      rb_write(lastCharWritten);
+      statsWritten(1);
+      return 1;
     }
   }
 }
@@ -507,6 +1027,9 @@ size_t BufferedOutput::write(uint8_t c) {
 // nextByteOut(); NOT CALLED HERE don't call this here as may loop
 size_t BufferedOutput::bytesToBeSent() {
   size_t btbs = (size_t)rb_available();
+  if (spsc) {
+    return btbs; // only the consumer accesses the stream
+  }
   if (txBufferSize) { // using Serial Tx buffer
     int avail = internalStreamAvailableForWrite(); // includes -1
     if (txBufferSize < avail) {
@@ -517,8 +1040,53 @@ size_t BufferedOutput::bytesToBeSent() {
   return btbs;
 }
 
+// nothing in the ringBuffer, and not SPSC where only the consumer writes to the stream,
+// and not paced, fanned out, multiplexed or suppressing repeats, which all need the output to go through the ringBuffer
+bool BufferedOutput::directWriteAllowed() {
+  return ((!spsc) && (!pacing) && (!nextSink) && (!channelMux) && (!repeats) && (rb_available() == 0) && laneCanSend());
+}
+
 // NOTE nextByteOut will block if baudRate is set higher then actual i/o baudrate
 void BufferedOutput::nextByteOut() {
+  if (channelMux) {
+    if (channelMux != this) {
+      channelMux->nextByteOut(); // releases all the channels
+    } else {
+      muxNextByteOut();
+    }
+    return;
+  }
+  if (higherLane || lowerLane) {
+    // release the lanes highest priority first
+    BufferedOutput* lane = this;
+    while (lane->higherLane) {
+      lane = lane->higherLane;
+    }
+    for (; lane; lane = lane->lowerLane) {
+      lane->laneNextByteOut();
+    }
+    return;
+  }
+  if (sinkSource) {
+    sinkSource->nextByteOut(); // releases all the sinks
+    return;
+  }
+  laneNextByteOut();
+  for (BufferedOutput* sink = nextSink; sink; sink = sink->nextSink) {
+    sink->laneNextByteOut();
+  }
+  if (nextSink) {
+    flushCheck(); // the sinks have now released their bytes also
+  }
+}
+
+// releases bytes from just this lane
+void BufferedOutput::laneNextByteOut() {
+  laneRelease();
+  flushCheck(); // in the same call that sends the last byte upto the flushAsync( ) mark
+}
+
+void BufferedOutput::laneRelease() {
   if (!streamPtr) {
     SafeString::Output.println();
     SafeString::Output.println(F("BufferedOutput Error: need to call connect(..) first in setup()"));
@@ -527,7 +1095,21 @@ void BufferedOutput::nextByteOut() {
   //  delay(5000);
     return;
   }
-  if (mode != DROP_UNTIL_EMPTY) {
+  if (repeats && (!repeats->busy)) {
+    repeatCheckTime();
+  }
+  while (sinkSkipLine && (rb_available() != 0)) { // skip the rest of the line the sink dropped part of
+    if (rb_read() == '\n') {
+      sinkSkipLine = false;
+    }
+    if (stats) {
+      stats->bytesDropped++;
+    }
+  }
+  statsDrainTime();
+  if (spsc) {
+    rb_processClearRequest(); // in SPSC mode waitForEmpty is handled by the producer, see producerNextByteOut()
+  } else if (mode != DROP_UNTIL_EMPTY) {
     waitForEmpty = false; // always skips a lot of the code below
   }
 
@@ -536,39 +1118,41 @@ void BufferedOutput::nextByteOut() {
     if (txBufferSize != 0) {
       if (serialAvail >= txBufferSize) { // works is txBufferSize == 0 also
         txBufferSize = serialAvail;
-        waitForEmpty = false; // both buffers empty
+        if (!spsc) {
+          waitForEmpty = false; // both buffers empty
+        }
       }
     } else { // no txBuffer
-      waitForEmpty = false; // ringBuffer empty
+      if (!spsc) {
+        waitForEmpty = false; // ringBuffer empty
+      }
       // no txBuffer so using baudrate to release bytes instead of availableForWrite()
       sendTimerStart = micros(); // restart baudrate release timer
+      sendTimerBytes = 1;
     }
     return; // nothing to release
   }
 
   // here have something to release
+  if (!laneCanSend()) {
+    return; // wait for a higher priority lane or for another lane to finish its line
+  }
+  size_t held = repeatHeld();
+  if (held >= ((size_t)rb_available())) {
+    return; // only a partly written line that may be a repeat
+  }
   //  serialAvail set above
   bool serialBytesWritten = false;
   if (txBufferSize != 0) { // common case use internalStreamAvailableForWrite() to throttle output
     // check if space available and fill from ringBuffer  some boards return 0 for availableForWrite
     if (serialAvail > 0) { // have at least 1 space have already adjusted for ESP32 bug in internalStreamAvailableForWrite
-      int toWrite = serialAvail;
-      int rbAvail = rb_available();
-      if (rbAvail < toWrite) { // limit by number of ringBuffer chars
-        toWrite = rbAvail;
-      }
-      serialBytesWritten = (toWrite > 0); //set once here
-      for (int i = 0; i < toWrite; i++) {
-        uint8_t b = (uint8_t)rb_read();
-        if (b) {
-          streamPtr->write(b);
-        }
-        // else  skip protect bytes '\0'
-      }
+      // limit by number of ringBuffer chars, separately as deferred records are formatted to more, or less, text
+      size_t written = writeOut(serialAvail, rb_available() - held); // skips protect bytes '\0'
+      serialBytesWritten = (written > 0); //set once here
     }
     // here have either filled txBuffer OR emptied rb_buffer
     // if serialBytesWritten then wrote to txBuffer
-    if ((!waitForEmpty) || serialBytesWritten || rb_available() ) { // if just wrote somthing or still have something to write then => waitForEmpty unchanged,
+    if (spsc || (!waitForEmpty) || serialBytesWritten || rb_available() ) { // if just wrote somthing or still have something to write then => waitForEmpty unchanged,
       //  also if waitForEmpty false no need to check (wrong mode)
       return; // not empty
     }
@@ -585,27 +1169,67 @@ void BufferedOutput::nextByteOut() {
   } // else no txBuffer release on timer
 
   // txBufferSize == 0 so use timer to throttle output
+  if (pacing) {
+    writeOut(rb_available() - held, rb_available() - held); // limited by the pacing
+    if ((!spsc) && (rb_available() == 0)) {
+      waitForEmpty = false;
+    }
+    return;
+  }
   // sendTimerStart will have been set above
 
   unsigned long us = micros();
   // micros() has 8us resolution on 8Mhz systems, 4us on 16Mhz system
-  // NOTE throw away any excess of (us - sendTimerStart) > us_perByte
+  // NOTE throw away any excess of (us - sendTimerStart) > us_perByte * sendTimerBytes
   // output will be slower then specified
-  if ((us - sendTimerStart) < us_perByte) {
+  if ((us - sendTimerStart) < (us_perByte * sendTimerBytes)) {
     return; // nothing to do not time to release next byte
   }
   // else send next byte
   sendTimerStart = us; //releasing next byte, restart timer
+  sendTimerBytes = 1 + streamWriteDropMark(); // a waiting ~~ is sent with the next byte, so there is one per run of dropped output
+  if (recordFormatter && (rb_peek() == BUFFERED_OUTPUT_RECORD_MARK)) {
+    size_t textLen;
+    statsDrained(rb_writeTo(streamPtr, 1, rb_available() - held, textLen)); // the whole record's text is sent at once
+    if (textLen > 1) {
+      sendTimerBytes += textLen - 1; // so wait for all of it to be sent before releasing the next byte
+    }
+    if ((!spsc) && (rb_available() == 0)) {
+      waitForEmpty = false;
+    }
+    return;
+  }
   uint8_t b = (uint8_t)rb_read();
+  statsDrained(1);
   if (b) {
     streamPtr->write(b);  // may block if set baudRate higher then actual I/O baud rate
+    lastCharSent = b;
   }
   // else skip protect bytes '\0' This also skips this release baud rate interval
-  if (rb_available() == 0) {
+  if ((!spsc) && (rb_available() == 0)) {
     waitForEmpty = false;
   }
 }
 
+// writes a sink's, or SPSC clear()'s, ~~ drop mark, if one is waiting, directly to the stream, returns the bytes written
+// only called when there is room for it
+size_t BufferedOutput::streamWriteDropMark() {
+  if (!streamDropMark) {
+    return 0;
+  }
+  streamDropMark = false;
+  streamPtr->write((const uint8_t*)"~~\r\n", 4);
+  lastCharSent = '\n';
+  return 4;
+}
+
+// for setup calls that cannot be combined, the call is ignored
+void BufferedOutput::setupError(const __FlashStringHelper *msg) {
+  SafeString::Output.println();
+  SafeString::Output.print(F("BufferedOutput Error: ")); SafeString::Output.println(msg);
+  SafeString::Output.println();
+}
+
 // always expect there to be at least 4 spaces available in the ringBuffer when this is called
 void BufferedOutput::writeDropMark() {
   if (rb_availableForWrite() < 4) {
@@ -614,6 +1238,9 @@ void BufferedOutput::writeDropMark() {
     rb_write((const uint8_t*)"~~\r\n", 4); // will truncate if not enough room
   }
   dropMarkWritten = true;
+  if (stats) {
+    stats->dropEvents++;
+  }
 }
 
 
@@ -621,7 +1248,7 @@ int BufferedOutput::available() {
   if (!streamPtr) {
     return 0;
   }
-  nextByteOut();
+  producerNextByteOut();
   return streamPtr->available();
 }
 
@@ -629,7 +1256,7 @@ int BufferedOutput::read() {
   if (!streamPtr) {
     return -1; // -1
   }
-  nextByteOut();
+  producerNextByteOut();
   return streamPtr->read();
 }
 
@@ -637,7 +1264,7 @@ int BufferedOutput::peek() {
   if (!streamPtr) {
     return -1; // -1
   }
-  nextByteOut();
+  producerNextByteOut();
   return streamPtr->peek();
 }
 
@@ -647,67 +1274,728 @@ void BufferedOutput::flush() {
     return;
   }
   while (bytesToBeSent() != 0) {
-    nextByteOut();
+    if (spsc) {
+      delay(1); // wait for the consumer, expect this to call yield() for those boards that need it e.g. ESP8266 and ESP32
+    } else {
+      nextByteOut();
+    }
+  }
+  for (BufferedOutput* sink = nextSink; sink; sink = sink->nextSink) {
+    while (sink->bytesToBeSent() != 0) {
+      nextByteOut();
+    }
   }
+  flushCheck();
 }
 
-//===============  ringBuffer methods ==============
-// write() will silently fail if ringbuffer is full
+void BufferedOutput::flushAsync(BufferedOutputFlushCallback callback) {
+  flushTarget = bufferedRingLoad(rb_headPtr);
+  flushCallback = spsc ? NULL : callback; // in SPSC mode nextByteOut() is called by the consumer
+  flushWaiting = true;
+  flushCheck();
+}
 
-/**
-   _buf must be at least _size in length
-   _size is limited to 32766
-   assumes size_t is atleast 16bits as specified by C spec
-*/
-void BufferedOutput::rb_init(uint8_t* _buf, size_t _size) {
-  rb_clear();
-  if ((_buf == NULL) || (_size == 0)) {
-    rb_buf = _buf;
-    rb_bufSize = 0; // prevents access to a NULL buf
+bool BufferedOutput::isFlushed() {
+  if (!flushWaiting) {
+    return true;
+  }
+  if (spsc) {
+    producerNextByteOut(); // only the producer uses flushWaiting
   } else {
-    // available etc returns int, check that _size fits in int
-    // limit _size to max int16_t - 1
-    if (_size >= 32766) {
-      _size = 32766; // (2^16/2)-1 minus 1 since uint16_t vars used
+    flushCheck();
+  }
+  return !flushWaiting;
+}
+
+// the bytes from the tail to flushTarget are still to be sent, unless the tail has already passed flushTarget
+bool BufferedOutput::flushReached() {
+  size_t left = rb_distance(bufferedRingLoad(&rb_buffer_tail), flushTarget);
+  if ((left != 0) && (left <= ((size_t)rb_available()))) {
+    return false;
+  }
+  for (BufferedOutput* sink = nextSink; sink; sink = sink->nextSink) {
+    left = rb_distance(bufferedRingLoad(&sink->rb_buffer_tail), flushTarget);
+    if ((left != 0) && (left <= ((size_t)sink->rb_available()))) {
+      return false;
     }
-    rb_buf = _buf;
-    rb_bufSize = _size; // buffer_count use to detect buffer full
   }
+  return true;
 }
 
-void BufferedOutput::rb_clear() {
-  rb_buffer_head = 0;
-  rb_buffer_tail = rb_buffer_head;
-  rb_buffer_count = 0;
+// called by each nextByteOut(), not in SPSC mode
+void BufferedOutput::flushCheck() {
+  if ((!flushWaiting) || spsc || (!flushReached())) {
+    return;
+  }
+  flushWaiting = false; // before the callback, which may call flushAsync( ) again
+  if (flushCallback) {
+    flushCallback(*this);
+  }
 }
 
-/*
-   This should return size_t,
-   but someone stuffed it up in the Arduino libraries
-*/
-// defined in BufferedOutput.h in BufferedOutputRingBuffer class declaration
-//int BufferedOutput::available() { return buffer_count; }
+void BufferedOutput::useSPSC() {
+  if (nextSink || sinkSource || higherLane || lowerLane || channelMux) {
+    setupError(F("useSPSC() cannot be used with sinks, lanes or channels"));
+    return;
+  }
+  if (mode == BLOCK_IF_FULL) {
+    mode = DROP_IF_FULL; // the producer never blocks
+  }
+  reservedLen = 0;
+  rb_clearsDone = rb_clearRequests;
+  repeats = NULL; // the consumer may be sending a repeat before it is removed
+  spsc = true;
+}
 
+BufferedOutputStats::BufferedOutputStats() {
+  reset();
+}
 
-size_t BufferedOutput::rb_getSize() {
-  return rb_bufSize;
+void BufferedOutputStats::reset() {
+  bytesWritten = 0;
+  bytesDropped = 0;
+  dropEvents = 0;
+  maxUsed = 0;
+  blockedMicros = 0;
+  maxBlockedMicros = 0;
+  bytesDrained = 0;
+  drainMicros = 0;
+  drainLastMicros = 0;
+  drainBusy = false;
+  burstExcess = 0;
+  maxDemand = 0;
+  clearedLines = 0;
+  clearedBytes = 0;
+}
+
+void BufferedOutput::setStats(BufferedOutputStats& _stats) {
+  stats = &_stats;
+  stats->reset();
+}
+
+void BufferedOutput::resetStats() {
+  if (stats) {
+    stats->reset();
+  }
+  if (repeats) {
+    repeats->suppressed = 0;
+  }
+}
+
+unsigned long BufferedOutput::getBytesWritten() {
+  return stats ? stats->bytesWritten : 0;
+}
+
+unsigned long BufferedOutput::getBytesDropped() {
+  return stats ? stats->bytesDropped : 0;
+}
+
+unsigned long BufferedOutput::getDropEvents() {
+  return stats ? stats->dropEvents : 0;
+}
+
+size_t BufferedOutput::getMaxBufferUsed() {
+  return stats ? stats->maxUsed : 0;
+}
+
+unsigned long BufferedOutput::getBlockedMicros() {
+  return stats ? stats->blockedMicros : 0;
+}
+
+unsigned long BufferedOutput::getMaxBlockedMicros() {
+  return stats ? stats->maxBlockedMicros : 0;
+}
+
+unsigned long BufferedOutput::getDrainRate() {
+  if ((!stats) || (stats->drainMicros == 0)) {
+    return 0;
+  }
+  return (unsigned long)(((float)stats->bytesDrained) * 1000000.0 / ((float)stats->drainMicros));
+}
+
+// the largest burst seen is the most bytes waiting in the buffer plus those dropped or blocked before the buffer next emptied
+// allow 1/8 extra
+size_t BufferedOutput::recommendedBufferSize() {
+  if (!stats) {
+    return 0;
+  }
+  size_t size = stats->maxDemand + stats->maxDemand / 8;
+  if (size < 8) {
+    size = 8;
+  }
+  if (size > (BUFFERED_RING_MAX_SIZE - 4)) {
+    size = BUFFERED_RING_MAX_SIZE - 4; // createBufferedOutput adds 4 for the drop mark
+  }
+  return size;
+}
+
+// a burst ends when the buffer empties
+void BufferedOutput::statsWritten(size_t n) {
+  if (!stats) {
+    return;
+  }
+  stats->bytesWritten += n;
+  size_t used = rb_available();
+  if (used <= n) {
+    stats->burstExcess = 0; // was empty before this write
+  }
+  if (used > stats->maxUsed) {
+    stats->maxUsed = used;
+  }
+  statsDemand(used);
+}
+
+void BufferedOutput::statsDropped(size_t n) {
+  if (!stats) {
+    return;
+  }
+  stats->bytesDropped += n;
+  stats->burstExcess += n;
+  statsDemand(rb_available());
+}
+
+// only called with stats
+void BufferedOutput::statsDemand(size_t used) {
+  if ((used + stats->burstExcess) > stats->maxDemand) {
+    stats->maxDemand = used + stats->burstExcess;
+  }
+}
+
+// waiting is the number of bytes that do not fit
+unsigned long BufferedOutput::statsBlockStart(size_t waiting) {
+  if (stats) {
+    stats->burstExcess += waiting;
+    statsDemand(rb_available());
+  }
+  return micros();
+}
+
+void BufferedOutput::statsBlockEnd(unsigned long blockStart) {
+  if (!stats) {
+    return;
+  }
+  unsigned long us = micros() - blockStart;
+  stats->blockedMicros += us;
+  if (us > stats->maxBlockedMicros) {
+    stats->maxBlockedMicros = us;
+  }
+}
+
+// drain rate, only timed while there is output waiting to be sent
+void BufferedOutput::statsDrainTime() {
+  if (!stats) {
+    return;
+  }
+  bool haveOutput = (rb_available() != 0);
+  if (haveOutput || stats->drainBusy) {
+    unsigned long us = micros();
+    if (stats->drainBusy) {
+      stats->drainMicros += us - stats->drainLastMicros;
+    }
+    stats->drainLastMicros = us;
+    stats->drainBusy = haveOutput;
+  }
+}
+
+void BufferedOutput::statsDrained(size_t n) {
+  if (stats) {
+    stats->bytesDrained += n;
+  }
+}
+
+void BufferedOutput::statsCleared(size_t bytes, size_t lines) {
+  if (stats) {
+    stats->clearedBytes += bytes;
+    stats->clearedLines += lines;
+  }
+}
+
+// the token bucket is implemented as a virtual scheduling, GCRA, timer
+// TAT is when the bucket will next have a token, bytes can be sent upto tolerance us earlier, which gives the burst
+// each byte moves TAT on by 1000000/rate us, the remainder is accumulated in frac so the rate does not drift
+BufferedOutputPacing::BufferedOutputPacing() {
+  rate = 0;
+  intervalUs = 0;
+  intervalRem = 0;
+  tolerance = 0;
+  TAT = 0;
+  frac = 0;
+}
+
+void BufferedOutput::setPacing(BufferedOutputPacing& _pacing, unsigned long bytesPerSec, size_t burstBytes) {
+  if (channelMux && bytesPerSec) {
+    setupError(F("setPacing( ) cannot be used with channels"));
+    return;
+  }
+  if (bytesPerSec == 0) {
+    pacing = NULL; // no pacing
+    return;
+  }
+  if (burstBytes < 1) {
+    burstBytes = 1;
+  }
+  pacing = &_pacing;
+  pacing->rate = bytesPerSec;
+  pacing->intervalUs = 1000000UL / pacing->rate;
+  pacing->intervalRem = 1000000UL % pacing->rate;
+  pacing->tolerance = (burstBytes - 1) * pacing->intervalUs + (unsigned long)(((float)(burstBytes - 1)) * pacing->intervalRem / pacing->rate);
+  pacing->TAT = micros();
+  pacing->frac = 0;
+}
+
+void BufferedOutput::setMaxMicrosPerCall(unsigned long maxMicros) {
+  maxMicrosPerCall = maxMicros;
+}
+
+// returns how many of n bytes the token bucket allows now
+size_t BufferedOutput::paceAllowed(size_t n) {
+  unsigned long us = micros();
+  if (((long)(us - pacing->TAT)) > 0) {
+    pacing->TAT = us; // bucket full, idle time beyond the burst is not saved up
+    pacing->frac = 0;
+  }
+  unsigned long tat = pacing->TAT;
+  unsigned long frac = pacing->frac;
+  size_t count = 0;
+  while ((count < n) && (((long)(us - (tat - pacing->tolerance))) >= 0)) {
+    count++;
+    tat += pacing->intervalUs;
+    frac += pacing->intervalRem;
+    if (frac >= pacing->rate) {
+      frac -= pacing->rate;
+      tat++;
+    }
+  }
+  return count;
+}
+
+// takes n tokens from the bucket
+void BufferedOutput::paceSent(size_t n) {
+  for (; n > 0; n--) {
+    pacing->TAT += pacing->intervalUs;
+    pacing->frac += pacing->intervalRem;
+    if (pacing->frac >= pacing->rate) {
+      pacing->frac -= pacing->rate;
+      pacing->TAT++;
+    }
+  }
+}
+
+// writes upto len bytes from the buffer to the stream, limited by the pacing and the time budget for each nextByteOut()
+// returns the number of bytes removed from the buffer
+size_t BufferedOutput::writeOut(size_t room, size_t limit) {
+  if (pacing) {
+    room = paceAllowed(room);
+  }
+  size_t written = 0; // bytes removed from the buffer
+  size_t sent = 0; // bytes written to the stream, differs from written for '\0's and deferred records
+  size_t markLen = 0;
+  if (streamDropMark) {
+    if (room < 5) {
+      return 0; // wait for room for the ~~ and some output after it, so there is one ~~ per run of dropped output
+    }
+    markLen = streamWriteDropMark();
+    room -= markLen;
+  }
+  if (maxMicrosPerCall == 0) {
+    written = rb_writeTo(streamPtr, room, limit, sent);
+  } else {
+    unsigned long start = micros();
+    while ((sent < room) && (written < limit)) {
+      size_t chunk = room - sent;
+      if (chunk > BUFFERED_OUTPUT_BUDGET_CHUNK) {
+        chunk = BUFFERED_OUTPUT_BUDGET_CHUNK;
+      }
+      size_t chunkSent = 0;
+      size_t chunkWritten = rb_writeTo(streamPtr, chunk, limit - written, chunkSent);
+      if (chunkWritten == 0) {
+        break; // empty or waiting for room for a record's text
+      }
+      written += chunkWritten;
+      sent += chunkSent;
+      if ((micros() - start) >= maxMicrosPerCall) {
+        break; // out of time, at least one chunk is always written
+      }
+    }
+  }
+  if (pacing) {
+    paceSent(sent + markLen);
+  }
+  statsDrained(written);
+  return written;
+}
+
+// lane is connected to the same stream as this BufferedOutput and added below the lowest priority lane
+void BufferedOutput::addLowerPriority(BufferedOutput& lane) {
+  if ((&lane == this) || lane.higherLane || lane.lowerLane) {
+    return; // already a lane
+  }
+  if (spsc || lane.spsc || nextSink || sinkSource || lane.nextSink || lane.sinkSource || channelMux || lane.channelMux) {
+    setupError(F("addLowerPriority( ) cannot be used with useSPSC(), sinks or channels"));
+    return;
+  }
+  BufferedOutput* lowest = this;
+  while (lowest->lowerLane) {
+    lowest = lowest->lowerLane;
+  }
+  lane.serialPtr = serialPtr;
+  lane.streamPtr = streamPtr;
+  lane.debugOut = debugOut;
+  lane.txBufferSize = txBufferSize;
+  lane.baudRate = baudRate;
+  lane.us_perByte = us_perByte;
+  lane.clear();
+  lane.higherLane = lowest;
+  lowest->lowerLane = &lane;
+}
+
+// this BufferedOutput is channel 0, the channels are linked in the order added
+uint8_t BufferedOutput::addChannel(BufferedOutput& channel, uint8_t weight) {
+  if ((&channel == this) || channel.channelMux) {
+    return channel.channelId; // already a channel
+  }
+  if (spsc || channel.spsc || higherLane || lowerLane || channel.higherLane || channel.lowerLane ||
+      nextSink || sinkSource || channel.nextSink || channel.sinkSource || pacing || channel.pacing) {
+    setupError(F("addChannel( ) cannot be used with useSPSC(), lanes, sinks or setPacing( )"));
+    return 0;
+  }
+  if (!channelMux) {
+    channelMux = this;
+    channelId = 0;
+    muxCurrent = this;
+    muxCredit = channelWeight;
+  }
+  BufferedOutput* last = this;
+  while (last->nextChannel) {
+    last = last->nextChannel;
+  }
+  channel.serialPtr = serialPtr;
+  channel.streamPtr = streamPtr;
+  channel.debugOut = debugOut;
+  channel.txBufferSize = txBufferSize;
+  channel.baudRate = baudRate;
+  channel.us_perByte = us_perByte;
+  channel.clear();
+  channel.channelMux = this;
+  channel.channelId = last->channelId + 1;
+  channel.setChannelWeight(weight);
+  last->nextChannel = &channel;
+  return channel.channelId;
+}
+
+void BufferedOutput::setChannelWeight(uint8_t weight) {
+  channelWeight = (weight < 1) ? 1 : weight;
+}
+
+// weighted round robin, each channel sends upto channelWeight frames in its turn
+// a frame is BUFFERED_MUX_FRAME_START, channelId, length 1 to BUFFERED_MUX_MAX_FRAME, then the bytes
+void BufferedOutput::muxNextByteOut() {
+  if (!streamPtr) {
+    laneNextByteOut(); // shows the connect( ) error
+    return;
+  }
+  size_t channelCount = 0;
+  for (BufferedOutput* ch = this; ch; ch = ch->nextChannel) {
+    if ((ch->mode != DROP_UNTIL_EMPTY) || (ch->rb_available() == 0)) {
+      ch->waitForEmpty = false;
+    }
+    if (ch->repeats && (!ch->repeats->busy)) {
+      ch->repeatCheckTime();
+    }
+    ch->flushCheck();
+    channelCount++;
+  }
+  size_t room;
+  if (txBufferSize != 0) {
+    room = internalStreamAvailableForWrite();
+  } else { // release one frame at the baud rate
+    unsigned long us = micros();
+    if ((us - sendTimerStart) < (us_perByte * sendTimerBytes)) {
+      return;
+    }
+    sendTimerStart = us;
+    sendTimerBytes = 0;
+    room = BUFFERED_MUX_MAX_FRAME + 3;
+  }
+  uint8_t frame[BUFFERED_MUX_MAX_FRAME + 3];
+  BufferedOutput* ch = muxCurrent;
+  size_t idle = 0; // channels passed over with nothing to send
+  while (idle <= channelCount) {
+    size_t len = ch->rb_available() - ch->repeatHeld();
+    if ((ch->muxCredit == 0) || (len == 0)) {
+      ch = ch->nextChannel ? ch->nextChannel : this; // next channel's turn
+      ch->muxCredit = ch->channelWeight;
+      idle++;
+      continue;
+    }
+    if (len > BUFFERED_MUX_MAX_FRAME) {
+      len = BUFFERED_MUX_MAX_FRAME;
+    }
+    if (room < (len + 3)) {
+      if (room < (BUFFERED_MUX_MIN_FRAME + 3)) {
+        break; // wait for room, rather than send lots of small frames
+      }
+      len = room - 3;
+    }
+    len = ch->rb_read(frame + 3, len);
+    // remove protect bytes '\0'
+    uint8_t *end = frame + 3 + len;
+    uint8_t *dest = (uint8_t*)memchr(frame + 3, '\0', len);
+    if (dest) {
+      for (uint8_t *src = dest; src < end; src++) {
+        if (*src) {
+          *dest++ = *src;
+        }
+      }
+      len = dest - (frame + 3);
+    }
+    ch->statsDrained(len);
+    idle = 0;
+    if (len == 0) {
+      continue; // only protect bytes
+    }
+    frame[0] = BUFFERED_MUX_FRAME_START;
+    frame[1] = ch->channelId;
+    frame[2] = (uint8_t)len;
+    streamPtr->write(frame, len + 3);
+    ch->lastCharSent = frame[len + 2];
+    ch->muxCredit--;
+    room -= (len + 3);
+    if (txBufferSize == 0) {
+      sendTimerBytes = len + 3;
+      break; // one frame per baud rate interval
+    }
+  }
+  muxCurrent = ch;
+  for (ch = this; ch; ch = ch->nextChannel) {
+    ch->flushCheck(); // in the same call that sends the last byte upto the flushAsync( ) mark
+  }
+}
+
+// the sink shares this BufferedOutput's ring buffer and only has its own read index, rb_buffer_tail
+void BufferedOutput::addSink(BufferedOutput& sink) {
+  if ((&sink == this) || sink.sinkSource || sink.nextSink || (!sink.streamPtr)) {
+    return; // already a sink or not connected
+  }
+  if (spsc || sink.spsc || higherLane || lowerLane || sink.higherLane || sink.lowerLane || sinkSource || channelMux || sink.channelMux) {
+    setupError(F("addSink( ) cannot be used with useSPSC(), lanes or channels"));
+    return;
+  }
+  BufferedOutput* last = this;
+  while (last->nextSink) {
+    last = last->nextSink;
+  }
+  sink.rb_buf = rb_buf;
+  sink.rb_bufSize = rb_bufSize;
+  sink.rb_headPtr = &rb_buffer_head;
+  bufferedRingStore(&sink.rb_buffer_tail, bufferedRingLoad(rb_headPtr)); // starts with the next output
+  sink.recordFormatter = recordFormatter;
+  sink.sinkSource = this;
+  last->nextSink = &sink;
+}
+
+// true if a dropping sink has output to send, they are not included in rb_used()
+bool BufferedOutput::rb_sinksWaiting() {
+  for (BufferedOutput* sink = nextSink; sink; sink = sink->nextSink) {
+    if (sink->rb_available() != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// a lane that has started sending a line keeps the stream until that line is sent, so lines from different lanes are not mixed
+// otherwise a lane can only send when all the higher priority lanes are empty
+bool BufferedOutput::laneMidLine() {
+  return ((lastCharSent != '\n') && (rb_available() != 0));
+}
+
+bool BufferedOutput::laneCanSend() {
+  if ((higherLane == NULL) && (lowerLane == NULL)) {
+    return true; // the usual case
+  }
+  if (laneMidLine()) {
+    return true; // finish this line first
+  }
+  for (BufferedOutput* lane = higherLane; lane; lane = lane->higherLane) {
+    if (lane->rb_available() != 0) {
+      return false;
+    }
+  }
+  for (BufferedOutput* lane = lowerLane; lane; lane = lane->lowerLane) {
+    if (lane->laneMidLine()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// in SPSC mode the producer does not send any output, it only checks if the buffer has emptied
+void BufferedOutput::producerNextByteOut() {
+  if (!spsc) {
+    nextByteOut();
+    return;
+  }
+  if ((mode != DROP_UNTIL_EMPTY) || (rb_available() == 0)) {
+    waitForEmpty = false;
+  }
+  if (flushWaiting && flushReached()) {
+    flushWaiting = false; // checked before more output can wrap the ring indices past flushTarget
+  }
+}
+
+//===============  ringBuffer methods ==============
+// write() will silently fail if ringbuffer is full
+// head and tail are mirror indices, 0 to 2*rb_bufSize-1, see BufferedRingIndex.h
+// only the producer (write side) stores rb_buffer_head and only the consumer (nextByteOut) stores rb_buffer_tail
+
+/**
+   _buf must be at least _size in length
+   _size is limited to BUFFERED_RING_MAX_SIZE, 32766 on AVR boards
+   assumes size_t is atleast 16bits as specified by C spec
+*/
+void BufferedOutput::rb_init(uint8_t* _buf, size_t _size) {
+  rb_clear();
+  if ((_buf == NULL) || (_size == 0)) {
+    rb_buf = _buf;
+    rb_bufSize = 0; // prevents access to a NULL buf
+  } else {
+    // available etc returns int, check that _size fits in int
+    // limit _size to max int16_t - 1 for uint16_t indices, see BufferedRingIndex.h
+    if (_size >= BUFFERED_RING_MAX_SIZE) {
+      _size = BUFFERED_RING_MAX_SIZE;
+    }
+    rb_buf = _buf;
+    rb_bufSize = _size;
+  }
+}
+
+// not used in SPSC mode, where the consumer moves the tail, see rb_requestClear()
+void BufferedOutput::rb_clear() {
+  bufferedRingStore(&rb_buffer_head, 0);
+  bufferedRingStore(&rb_buffer_tail, 0);
+  for (BufferedOutput* sink = nextSink; sink; sink = sink->nextSink) {
+    bufferedRingStore(&sink->rb_buffer_tail, 0);
+  }
+}
+
+// producer side of clear() in SPSC mode, the consumer drops every thing upto the current head on its next nextByteOut()
+void BufferedOutput::rb_requestClear() {
+  bufferedRingStore(&rb_clearToIdx, bufferedRingLoad(rb_headPtr));
+  bufferedRingStore(&rb_clearRequests, bufferedRingLoad(&rb_clearRequests) + 1);
+}
+
+// consumer side of clear() in SPSC mode
+void BufferedOutput::rb_processClearRequest() {
+  BufferedRingIndex requests = bufferedRingLoad(&rb_clearRequests);
+  if (requests == rb_clearsDone) {
+    return;
+  }
+  rb_clearsDone = requests;
+  // only move forward, in case the producer has made another request since rb_clearRequests was read
+  BufferedRingIndex tail = bufferedRingLoad(&rb_buffer_tail);
+  size_t toClear = rb_distance(tail, bufferedRingLoad(&rb_clearToIdx));
+  if ((toClear != 0) && (toClear <= ((size_t)rb_available()))) {
+    rb_skip(toClear);
+    streamDropMark = true; // sent with the next output when there is room
+  }
+}
+
+// number of bytes from idx to laterIdx
+size_t BufferedOutput::rb_distance(BufferedRingIndex idx, BufferedRingIndex laterIdx) {
+  if (laterIdx >= idx) {
+    return laterIdx - idx;
+  } // else
+  return ((size_t)laterIdx) + 2 * ((size_t)rb_bufSize) - idx;
+}
+
+// mirror index advanced by n, n <= rb_bufSize
+BufferedRingIndex BufferedOutput::rb_advance(BufferedRingIndex idx, size_t n) {
+  size_t newIdx = ((size_t)idx) + n;
+  if (newIdx >= 2 * ((size_t)rb_bufSize)) {
+    newIdx -= 2 * ((size_t)rb_bufSize);
+  }
+  return newIdx;
+}
+
+/*
+   This should return size_t,
+   but someone stuffed it up in the Arduino libraries
+*/
+int BufferedOutput::rb_available() {
+  return rb_distance(bufferedRingLoad(&rb_buffer_tail), bufferedRingLoad(rb_headPtr));
+}
+
+size_t BufferedOutput::rb_getSize() {
+  return rb_bufSize;
 }
 
 /*
    This should return size_t,
    but someone stuffed it up in the Arduino libraries
 */
-// defined in BufferedOutput.h in BufferedOutputRingBuffer class declaration
 int BufferedOutput::rb_availableForWrite() {
-  return (rb_bufSize - rb_buffer_count);
+  return (rb_bufSize - rb_used());
+}
+
+// the most bytes waiting to be sent by this BufferedOutput or by any sink that keeps all its output
+int BufferedOutput::rb_used() {
+  int used = rb_available();
+  for (BufferedOutput* sink = nextSink; sink; sink = sink->nextSink) {
+    if (sink->mode == BLOCK_IF_FULL) {
+      int sinkUsed = sink->rb_available();
+      if (sinkUsed > used) {
+        used = sinkUsed;
+      }
+    }
+  }
+  return used;
+}
+
+// called before len bytes are added, moves on any dropping sink that would have its unsent output written over
+void BufferedOutput::rb_sinksMakeRoom(size_t len) {
+  for (BufferedOutput* sink = nextSink; sink; sink = sink->nextSink) {
+    if (sink->mode == BLOCK_IF_FULL) {
+      continue; // included in rb_availableForWrite()
+    }
+    size_t sinkUsed = sink->rb_available();
+    if ((sinkUsed + len) > rb_bufSize) {
+      sink->sinkSkip(sinkUsed + len - rb_bufSize);
+    }
+  }
+}
+
+// skips at least len bytes, and then upto the start of the next line, and sends a drop mark
+// DROP_UNTIL_EMPTY skips all the output waiting
+void BufferedOutput::sinkSkip(size_t len) {
+  size_t count = rb_available();
+  if ((len > count) || (mode == DROP_UNTIL_EMPTY)) {
+    len = count;
+  }
+  count -= len;
+  BufferedRingIndex idx = rb_advance(bufferedRingLoad(&rb_buffer_tail), len);
+  while ((count > 0) && (rb_buf[rb_pos(rb_prev(idx))] != '\n')) {
+    idx = rb_advance(idx, 1);
+    count--;
+    len++;
+  }
+  bufferedRingStore(&rb_buffer_tail, idx);
+  if ((count == 0) && (rb_buf[rb_pos(rb_prev(idx))] != '\n')) {
+    sinkSkipLine = true; // the rest of this line has not been written yet
+  }
+  streamDropMark = true;
+  if (stats) {
+    stats->bytesDropped += len;
+    stats->dropEvents++;
+  }
 }
 
 
 int BufferedOutput::rb_peek() {
-  if (rb_buffer_count == 0) {
+  if (rb_available() == 0) {
     return -1;
   } else {
-    return rb_buf[rb_buffer_tail];
+    return rb_buf[rb_pos(bufferedRingLoad(&rb_buffer_tail))];
   }
 }
 
@@ -716,75 +2004,294 @@ void BufferedOutput::rb_dump(Stream * streamPtr) {
   if (streamPtr == NULL) {
     return;
   }
-  size_t idx = rb_buffer_tail;
-  size_t count = rb_buffer_count;
+  BufferedRingIndex idx = bufferedRingLoad(&rb_buffer_tail);
+  size_t count = rb_available();
   while (count > 0) {
-    unsigned char c = rb_buf[idx];
-    idx = rb_wrapBufferIdx(idx);
-    // if (buffer_count > 0) { checked above
+    unsigned char c = rb_buf[rb_pos(idx)];
+    idx = rb_advance(idx, 1);
     count--;
-    //streamPtr->print(" "); streamPtr->print(idx);  streamPtr->print(":");
     streamPtr->print((char)c);
   }
   streamPtr->println("-");
 }
 
 int BufferedOutput::rb_read() {
-  if (rb_buffer_count == 0) {
+  if (rb_available() == 0) {
     return -1;
   } else {
-    unsigned char c = rb_buf[rb_buffer_tail];
-    rb_buffer_tail = rb_wrapBufferIdx(rb_buffer_tail);
-    // if (buffer_count > 0) { checked above
-    rb_buffer_count--;
+    BufferedRingIndex tail = bufferedRingLoad(&rb_buffer_tail);
+    unsigned char c = rb_buf[rb_pos(tail)];
+    bufferedRingStore(&rb_buffer_tail, rb_advance(tail, 1));
     return c;
   }
 }
 
+// copies in at most two memcpy's, upto the end of rb_buf and then from the start
 size_t BufferedOutput::rb_write(const uint8_t *_buffer, size_t _size) {
   if (_size > ((size_t)rb_availableForWrite())) {
     _size = rb_availableForWrite();
   }
-  for (size_t i = 0; i < _size; i++) {
-    rb_internalWrite(_buffer[i]);
+  if (_size == 0) {
+    return 0;
+  }
+  rb_sinksMakeRoom(_size);
+  BufferedRingIndex head = bufferedRingLoad(rb_headPtr);
+  size_t pos = rb_pos(head);
+  size_t firstLen = rb_bufSize - pos; // space before the wrap
+  if (firstLen > _size) {
+    firstLen = _size;
   }
+  memcpy(rb_buf + pos, _buffer, firstLen);
+  memcpy(rb_buf, _buffer + firstLen, _size - firstLen); // wrapped part, if any
+  bufferedRingStore(&rb_buffer_head, rb_advance(head, _size)); // publish after the bytes are written
   return _size;
 }
 
+// copies in at most two memcpy's, returns number of bytes read
+size_t BufferedOutput::rb_read(uint8_t *_buffer, size_t _size) {
+  size_t count = rb_available();
+  if (_size > count) {
+    _size = count;
+  }
+  if (_size == 0) {
+    return 0;
+  }
+  size_t pos = rb_pos(bufferedRingLoad(&rb_buffer_tail));
+  size_t firstLen = rb_bufSize - pos; // bytes before the wrap
+  if (firstLen > _size) {
+    firstLen = _size;
+  }
+  memcpy(_buffer, rb_buf + pos, firstLen);
+  memcpy(_buffer + firstLen, rb_buf, _size - firstLen); // wrapped part, if any
+  rb_skip(_size);
+  return _size;
+}
+
+// makes len contiguous bytes available at rb_buffer_head, using at most maxUsed bytes of free space
+// pads the end of rb_buf with '\0's if len will not fit before the end, returns false if no room
+bool BufferedOutput::rb_reserve(size_t len, size_t maxUsed) {
+  if ((!spsc) && (rb_available() == 0) && (!rb_sinksWaiting())) {
+    rb_clear(); // empty so start from the beginning
+  }
+  if (maxUsed > ((size_t)rb_availableForWrite())) {
+    maxUsed = rb_availableForWrite();
+  }
+  BufferedRingIndex head = bufferedRingLoad(rb_headPtr);
+  size_t contiguous = rb_bufSize - rb_pos(head);
+  if (contiguous >= len) {
+    if (len > maxUsed) {
+      return false;
+    }
+    rb_sinksMakeRoom(len);
+    return true;
+  }
+  // else need to wrap to the start
+  if ((contiguous + len) > maxUsed) {
+    return false;
+  }
+  rb_sinksMakeRoom(contiguous + len);
+  memset(rb_buf + rb_pos(head), '\0', contiguous); // '\0's are skipped on output
+  bufferedRingStore(&rb_buffer_head, rb_advance(head, contiguous));
+  return true;
+}
+
+// removes len bytes, len <= rb_available() checked by caller
+void BufferedOutput::rb_skip(size_t len) {
+  bufferedRingStore(&rb_buffer_tail, rb_advance(bufferedRingLoad(&rb_buffer_tail), len));
+}
+
+// removes bytes and writes upto len bytes to the stream with one write(buf,n) per contiguous run
+// protect bytes '\0' are removed but not written and split the runs
+// deferred records are formatted and their text written, see rb_writeRecordTo() for when a record is started
+// returns number of bytes removed, including the '\0's, sent is set to the number of bytes written to the stream
+size_t BufferedOutput::rb_writeTo(Stream* streamPtr, size_t room, size_t limit, size_t &sent) {
+  size_t count = rb_available();
+  if (limit > count) {
+    limit = count;
+  }
+  sent = 0;
+  size_t rtn = 0;
+  while ((room > 0) && (rtn < limit)) {
+    size_t pos = rb_pos(bufferedRingLoad(&rb_buffer_tail));
+    if (recordFormatter && (rb_buf[pos] == BUFFERED_OUTPUT_RECORD_MARK)) {
+      // the whole record is before limit, logDeferred( ) ends any held repeat line so one never starts inside a record
+      size_t textLen = 0;
+      size_t removed = rb_writeRecordTo(streamPtr, room, (rtn == 0), textLen);
+      if (removed == 0) {
+        break; // wait for room for the text
+      }
+      rtn += removed;
+      sent += textLen;
+      room = (textLen < room) ? (room - textLen) : 0;
+      continue;
+    }
+    const uint8_t *segStart = rb_buf + pos;
+    size_t segLen = rb_bufSize - pos; // contiguous bytes before the wrap
+    if (segLen > (limit - rtn)) {
+      segLen = limit - rtn;
+    }
+    if (segLen > room) {
+      segLen = room;
+    }
+    size_t skipLen = 0;
+    const uint8_t *protectPtr = (const uint8_t *)memchr(segStart, '\0', segLen);
+    if (protectPtr) {
+      segLen = protectPtr - segStart; // write upto the '\0'
+      skipLen = 1; // and skip it
+    }
+    if (recordFormatter) {
+      const uint8_t *markPtr = (const uint8_t *)memchr(segStart, BUFFERED_OUTPUT_RECORD_MARK, segLen);
+      if (markPtr) {
+        segLen = markPtr - segStart; // write upto the record
+        skipLen = 0;
+      }
+    }
+    if (segLen) {
+      streamPtr->write(segStart, segLen);
+      lastCharSent = segStart[segLen - 1];
+    }
+    rb_skip(segLen + skipLen);
+    room -= (segLen + skipLen);
+    rtn += segLen + skipLen;
+    sent += segLen;
+  }
+  return rtn;
+}
+
+// collects the formatter's text for one deferred record, text past the end of buf is dropped
+class BufferedRecordText : public Print {
+  public:
+    BufferedRecordText(uint8_t *_buf, size_t _size) {
+      buf = _buf;
+      size = _size;
+      len = 0;
+    }
+    size_t write(uint8_t b) {
+      if (len >= size) {
+        return 0;
+      }
+      buf[len++] = b;
+      return 1;
+    }
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+};
+
+// formats the record at the tail and writes its text, the \r\n after it is sent as normal output
+// the text length is not known until it is formatted, so to format each record only once, a record is only started
+// if room is at least BUFFERED_OUTPUT_RECORD_TEXT_SIZE, or if force and the stream's Tx buffer is empty
+// returns the number of bytes removed, 0 if waiting for room
+size_t BufferedOutput::rb_writeRecordTo(Stream* streamPtr, size_t room, bool force, size_t &textLen) {
+  textLen = 0;
+  if ((room < BUFFERED_OUTPUT_RECORD_TEXT_SIZE) &&
+      (!(force && ((txBufferSize == 0) || (internalStreamAvailableForWrite() >= txBufferSize))))) {
+    return 0; // wait for more room
+  }
+  BufferedRingIndex idx = rb_advance(bufferedRingLoad(&rb_buffer_tail), 1); // skip the mark
+  size_t count = rb_available() - 1;
+  size_t recordLen = 1;
+  long args[BUFFERED_OUTPUT_RECORD_MAX_ARGS + 1]; // formatId then args
+  uint8_t n = 0;
+  uint32_t v = 0;
+  uint8_t shift = 0;
+  while (count > 0) {
+    uint8_t b = rb_buf[rb_pos(idx)];
+    if (b < 0x80) {
+      break; // end of record
+    }
+    if (shift < 32) {
+      v |= ((uint32_t)(b & 0x3F)) << shift;
+    }
+    shift += 6;
+    if (b & 0x40) { // last group
+      if (n == 0) {
+        args[n++] = (long)v; // formatId
+      } else if (n <= BUFFERED_OUTPUT_RECORD_MAX_ARGS) {
+        args[n++] = (long)((int32_t)((v >> 1) ^ (0 - (v & 1)))); // undo zigzag
+      }
+      v = 0;
+      shift = 0;
+    }
+    idx = rb_advance(idx, 1);
+    count--;
+    recordLen++;
+  }
+  uint8_t text[BUFFERED_OUTPUT_RECORD_TEXT_SIZE];
+  BufferedRecordText recordText(text, sizeof(text));
+  if (n > 0) {
+    recordFormatter(recordText, (uint8_t)args[0], args + 1, n - 1);
+  }
+  textLen = recordText.len;
+  if (textLen) {
+    streamPtr->write(text, textLen);
+    lastCharSent = text[textLen - 1];
+  }
+  rb_skip(recordLen);
+  return recordLen;
+}
+
+// CLEAR_LAST_BYTES may stop part way through a deferred record, if so the rest of the record is removed also
+// returns the index of the mark if idx is inside or just after a record's encoded bytes, else idx
+BufferedRingIndex BufferedOutput::rb_recordStart(BufferedRingIndex idx) {
+  if (!recordFormatter) {
+    return idx;
+  }
+  size_t count = rb_distance(bufferedRingLoad(&rb_buffer_tail), idx); // bytes before idx
+  BufferedRingIndex i = idx;
+  while (count > 0) {
+    i = rb_prev(i);
+    count--;
+    uint8_t b = rb_buf[rb_pos(i)];
+    if (b == BUFFERED_OUTPUT_RECORD_MARK) {
+      return i; // also remove a mark left on its own, so following output is not read as a record
+    }
+    if (b < 0x80) {
+      break;
+    }
+  }
+  return idx;
+}
+
 size_t BufferedOutput::rb_write(uint8_t b) {
   // check for buffer full
-  if (rb_buffer_count >= rb_bufSize) {
+  if (rb_availableForWrite() <= 0) {
     return 0;
   }
   // else
+  rb_sinksMakeRoom(1);
   rb_internalWrite(b);
   return 1;
 }
 
 void BufferedOutput::rb_internalWrite(uint8_t b) {
   // check for buffer full done by caller
-  rb_buf[rb_buffer_head] = b;
-  rb_buffer_head = rb_wrapBufferIdx(rb_buffer_head);
-  rb_buffer_count++;
-}
-
-uint16_t BufferedOutput::rb_wrapBufferIdx(uint16_t idx) {
-  if (idx >= (rb_bufSize - 1)) {
-    // wrap around
-    idx = 0;
-  } else {
-    idx++;
-  }
-  return idx;
+  BufferedRingIndex head = bufferedRingLoad(rb_headPtr);
+  rb_buf[rb_pos(head)] = b;
+  bufferedRingStore(&rb_buffer_head, rb_advance(head, 1));
 }
 
 // clears space in outgoing (write) buffer, by removing last bytes written,  if len == 0 clear whole buffer, Serial Tx buffer is NOT changed
 // returns true if some output dropped
+// not used in SPSC mode since the consumer may be reading the last bytes written
 bool BufferedOutput::rb_clearSpace(size_t len) {
   if (len == 0) {
     return false; // nothing dropped
   }
+  if (clearMode != CLEAR_LAST_BYTES) {
+    int avail = rb_availableForWrite();
+    if (((long)len) <= avail) {
+      return false;
+    }
+    if (clearMode == CLEAR_LAST_LINES) {
+      return rb_clearLastLines(len - (size_t)(avail));
+    } // else
+    return rb_clearOldestLines(len - (size_t)(avail));
+  }
   if (len >= rb_bufSize) {
+    if (stats) {
+      statsCleared(rb_available(), rb_countNewLines(bufferedRingLoad(&rb_buffer_tail), rb_available()));
+    }
     rb_clear();
     return true;
   }
@@ -795,39 +2302,162 @@ bool BufferedOutput::rb_clearSpace(size_t len) {
   }
   // else avail < len
   size_t tobedropped = len - (size_t)(avail);
-  // for (; tobedropped > 0; tobedropped--) {
-  //    rb_unWrite(); // this stops unWriting at first '\0'
-  //  }
+  BufferedRingIndex head = bufferedRingLoad(rb_headPtr);
+  BufferedRingIndex oldHead = head;
+  size_t count = rb_available();
+  size_t lines = 0;
   for (; tobedropped > 0; tobedropped--) {
-    if (rb_buffer_count == 0) {
-      return true; // empty
+    if (count == 0) {
+      break; // empty
     }
     // else
-    size_t head = rb_buffer_head - 1; // will wrap to very large number if idx == 0
-    if (head > rb_bufSize) { // actually (head > (rb_bufSize-1) but ESP8266 complains about this so just assume head will be very big
-      head = (rb_bufSize - 1);
-    }
-    if (!rb_buf[head]) { // true if == '\0' else false
-      return true; // stop at '\0'
+    BufferedRingIndex prevHead = (head == 0) ? (2 * rb_bufSize - 1) : (head - 1);
+    if (!rb_buf[rb_pos(prevHead)]) { // true if == '\0' else false
+      break; // stop at '\0'
     }
     // else update for this unWrite
-    rb_buffer_head = head;
-    rb_buffer_count--;
+    if (rb_buf[rb_pos(prevHead)] == '\n') {
+      lines++;
+    }
+    head = prevHead;
+    count--;
   }
+  BufferedRingIndex recordStart = rb_recordStart(head);
+  statsCleared(rb_distance(recordStart, oldHead), lines);
+  bufferedRingStore(&rb_buffer_head, recordStart);
   return true;
 }
 
+// removes whole lines from the end of the buffer, the last line may be incomplete
+// stops at a '\0' protect mark and never removes the rest of a line that has been partly sent
+bool BufferedOutput::rb_clearLastLines(size_t tobedropped) {
+  BufferedRingIndex tail = bufferedRingLoad(&rb_buffer_tail);
+  BufferedRingIndex head = bufferedRingLoad(rb_headPtr);
+  BufferedRingIndex idx = head;
+  BufferedRingIndex cut = head; // drop from here to head
+  size_t dropped = 0;
+  size_t lines = 0;
+  size_t linesAtCut = 0;
+  while (idx != tail) {
+    BufferedRingIndex prev = rb_prev(idx);
+    uint8_t c = rb_buf[rb_pos(prev)];
+    if (c == '\0') {
+      break; // protected
+    }
+    if (c == '\n') {
+      lines++;
+    }
+    idx = prev;
+    dropped++;
+    if (rb_isLineStart(idx)) {
+      cut = idx;
+      linesAtCut = lines;
+      if (dropped >= tobedropped) {
+        break;
+      }
+    }
+  }
+  if (cut == head) {
+    return false; // nothing dropped
+  }
+  statsCleared(rb_distance(cut, head), linesAtCut);
+  lastCharWritten = '\n'; // buffer now ends at the start of a line
+  bufferedRingStore(&rb_buffer_head, cut);
+  return true;
+}
+
+// removes whole lines from the start of the buffer, after any '\0' protect mark and after any line that has been partly sent
+// the lines removed are replaced by a ~~ drop mark
+bool BufferedOutput::rb_clearOldestLines(size_t tobedropped) {
+  BufferedRingIndex tail = bufferedRingLoad(&rb_buffer_tail);
+  size_t count = rb_available();
+  // find the first byte after the last '\0'
+  size_t startOffset = 0;
+  BufferedRingIndex idx = tail;
+  for (size_t i = 0; i < count; i++) {
+    if (!rb_buf[rb_pos(idx)]) {
+      startOffset = i + 1;
+    }
+    idx = rb_advance(idx, 1);
+  }
+  idx = rb_advance(tail, startOffset);
+  bool atLineStart = rb_isLineStart(idx);
+  // drop whole lines until have room for tobedropped and the drop mark
+  size_t endOffset = startOffset;
+  size_t lines = 0;
+  for (size_t i = startOffset; i < count; i++) {
+    uint8_t c = rb_buf[rb_pos(idx)];
+    idx = rb_advance(idx, 1);
+    if (c != '\n') {
+      continue;
+    }
+    if (!atLineStart) { // keep the rest of a partly sent or protected line
+      atLineStart = true;
+      startOffset = i + 1;
+      endOffset = startOffset;
+      continue;
+    }
+    endOffset = i + 1;
+    lines++;
+    if ((endOffset - startOffset) >= (tobedropped + 4)) {
+      break;
+    }
+  }
+  size_t dropped = endOffset - startOffset;
+  if (dropped <= 4) {
+    return false; // no space gained after adding the drop mark
+  }
+  // move the bytes kept in front of the dropped lines up against the drop mark, last byte first
+  size_t shift = dropped - 4;
+  for (size_t i = startOffset; i > 0; i--) {
+    rb_buf[rb_pos(rb_advance(tail, i - 1 + shift))] = rb_buf[rb_pos(rb_advance(tail, i - 1))];
+  }
+  const char *dropMark = "~~\r\n";
+  for (size_t i = 0; i < 4; i++) {
+    rb_buf[rb_pos(rb_advance(tail, endOffset - 4 + i))] = dropMark[i];
+  }
+  statsCleared(dropped, lines);
+  bufferedRingStore(&rb_buffer_tail, rb_advance(tail, shift));
+  return true;
+}
+
+// true if idx is at the start of a line, i.e. the last byte before it, ignoring '\0's, is '\n' or has been sent and was '\n'
+bool BufferedOutput::rb_isLineStart(BufferedRingIndex idx) {
+  BufferedRingIndex tail = bufferedRingLoad(&rb_buffer_tail);
+  while (idx != tail) {
+    idx = rb_prev(idx);
+    uint8_t c = rb_buf[rb_pos(idx)];
+    if (c) {
+      return (c == '\n');
+    }
+  }
+  return (lastCharSent == '\n');
+}
+
+size_t BufferedOutput::rb_countNewLines(BufferedRingIndex idx, size_t len) {
+  size_t lines = 0;
+  for (; len > 0; len--) {
+    if (rb_buf[rb_pos(idx)] == '\n') {
+      lines++;
+    }
+    idx = rb_advance(idx, 1);
+  }
+  return lines;
+}
+
+BufferedRingIndex BufferedOutput::rb_prev(BufferedRingIndex idx) {
+  return (idx == 0) ? (2 * rb_bufSize - 1) : (idx - 1);
+}
+
 // returns true is last byte still in ringBuffer is '\0' else false
 bool BufferedOutput::rb_lastBufferedByteProtect() {
-  if (rb_buffer_count == 0) {
+  if (rb_available() == 0) {
     return true; // empty so no need to write another one here as nothing to protect
   }
   // else
-  size_t head = rb_buffer_head - 1; // will wrap to very large number if idx == 0
-  if (head > rb_bufSize) { // actually (head > (rb_bufSize-1) but ESP8266 complains about this so just assume head will be very big
-    head = (rb_bufSize - 1);
-  }
-  return (!rb_buf[head]);  // true if == '\0' else false
+  BufferedRingIndex head = bufferedRingLoad(rb_headPtr);
+  BufferedRingIndex prevHead = (head == 0) ? (2 * rb_bufSize - 1) : (head - 1);
+  return (!rb_buf[rb_pos(prevHead)]);  // true if == '\0' else false
 }
 
 
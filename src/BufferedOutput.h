@@ -36,6 +36,7 @@
 #include <Print.h>
 #include <Printable.h>
 #include "SafeString.h"  // for Output and #define SSTRING_DEBUG and stream support
+#include "BufferedRingIndex.h" // uint16_t indices on AVR, size_t on larger boards
 
 // handle namespace arduino
 #include "SafeStringNameSpaceStart.h"
@@ -43,6 +44,113 @@
 #define createBufferedOutput(name, size, ...) uint8_t name ## _OUTPUT_BUFFER[(size)+4]; BufferedOutput name(sizeof(name ## _OUTPUT_BUFFER),name ## _OUTPUT_BUFFER,  __VA_ARGS__ ); // add 4 for dropMark
 
 typedef enum {BLOCK_IF_FULL, DROP_UNTIL_EMPTY, DROP_IF_FULL } BufferedOutputMode;
+// bytes written to the stream between checks of the setMaxMicrosPerCall( ) time limit
+#ifndef BUFFERED_OUTPUT_BUDGET_CHUNK
+#define BUFFERED_OUTPUT_BUDGET_CHUNK 16
+#endif
+
+// deferred records, see logDeferred( )
+#ifndef BUFFERED_OUTPUT_RECORD_MARK
+#define BUFFERED_OUTPUT_RECORD_MARK 0x01
+#endif
+#ifndef BUFFERED_OUTPUT_RECORD_MAX_ARGS
+#define BUFFERED_OUTPUT_RECORD_MAX_ARGS 4
+#endif
+// the longest time nextByteOut() holds back a partly written line, when suppressing repeats, before sending it anyway
+#ifndef BUFFERED_OUTPUT_REPEAT_HOLD_MS
+#define BUFFERED_OUTPUT_REPEAT_HOLD_MS 20
+#endif
+// stack space used by nextByteOut() to format a record, longer text is truncated
+#ifndef BUFFERED_OUTPUT_RECORD_TEXT_SIZE
+#define BUFFERED_OUTPUT_RECORD_TEXT_SIZE 64
+#endif
+typedef void (*BufferedOutputFormatter)(Print& out, uint8_t formatId, const long args[], uint8_t argCount);
+
+class BufferedOutput;
+// see flushAsync( )
+typedef void (*BufferedOutputFlushCallback)(BufferedOutput& output);
+
+// channel frames, see addChannel( ) and SafeStringDemux
+#define BUFFERED_MUX_FRAME_START 0x1E
+#ifndef BUFFERED_MUX_MAX_FRAME
+#define BUFFERED_MUX_MAX_FRAME 32
+#endif
+#define BUFFERED_MUX_MIN_FRAME 8
+
+typedef enum {CLEAR_LAST_BYTES, CLEAR_LAST_LINES, CLEAR_OLDEST_LINES } BufferedOutputClearMode;
+
+/**
+  BufferedOutputStats holds the output statistics counters, see BufferedOutput::setStats( )<br>
+  The counters are only kept, and only take up RAM, if one of these is attached to the BufferedOutput.<br>
+  e.g.<br>
+  <code>
+  BufferedOutputStats outputStats;<br>
+  ...<br>
+  output.setStats(outputStats);
+  </code>
+*/
+class BufferedOutputStats {
+  public:
+    BufferedOutputStats();
+  private:
+    friend class BufferedOutput;
+    void reset();
+    unsigned long bytesWritten;
+    unsigned long bytesDropped;
+    unsigned long dropEvents;
+    size_t maxUsed;
+    unsigned long blockedMicros;
+    unsigned long maxBlockedMicros;
+    unsigned long bytesDrained; // sent from the buffer while timing the drain rate
+    unsigned long drainMicros;
+    unsigned long drainLastMicros;
+    bool drainBusy; // had output waiting at the last nextByteOut()
+    size_t burstExcess; // bytes dropped or blocked since the buffer was last empty
+    size_t maxDemand; // largest buffer used plus burstExcess
+    unsigned long clearedLines; // complete lines removed by clearSpace()
+    unsigned long clearedBytes; // bytes removed by clearSpace()
+};
+
+/**
+  BufferedOutputPacing holds the token bucket used by BufferedOutput::setPacing( )
+*/
+class BufferedOutputPacing {
+  public:
+    BufferedOutputPacing();
+  private:
+    friend class BufferedOutput;
+    unsigned long rate; // bytes per sec
+    unsigned long intervalUs; // 1000000 / rate
+    unsigned long intervalRem; // 1000000 % rate
+    unsigned long tolerance; // us, allows burstBytes
+    unsigned long TAT; // micros() when the next byte is due
+    unsigned long frac; // accumulated intervalRem, < rate
+};
+
+/**
+  BufferedOutputRepeats holds the last line's hash and the count of repeats for BufferedOutput::setSuppressRepeats( )
+*/
+class BufferedOutputRepeats {
+  public:
+    BufferedOutputRepeats();
+  private:
+    friend class BufferedOutput;
+    bool busy; // in repeatWrite( )
+    unsigned long maxMillis; // 0 for no time limit
+    BufferedRingIndex lineStart; // head when the current line started
+    size_t lineLen; // bytes of the current line written so far, 0 at the start of a line
+    bool lineOk; // all of the current line was written and none of it cleared
+    bool holding; // from the start of a line until its \n, nextByteOut() holds it back
+    uint32_t hash; // FNV-1a of the current line so far
+    unsigned long lineMillis; // when the current line started
+    uint32_t lastHash;
+    size_t lastLen;
+    bool lastValid; // the last line was written in full
+    unsigned long count; // repeats removed since the last summary
+    unsigned long runStart; // millis() of the first repeat since the last summary
+    unsigned long suppressed; // total repeats removed, reset by resetStats( )
+};
+
 /**************
   To create a BufferedOutput use the macro **createBufferedOutput**  see the detailed description. NOTE: Any '\0' chars added by <b>write(0)</b> calls, are filtered out of the final output.
     
@@ -82,7 +190,7 @@ class BufferedOutput : public Stream {
          BufferedOutput(size_t _bufferSize, uint8_t *_buf, BufferedOutputMode mode, bool allOrNothing = true);  
            
          @param buf -- the user allocated buffer to store the bytes, must be at least bufferSize long.  Defaults to an internal 8 char buffer if buf is omitted or NULL  
-         @param bufferSize -- number of bytes to buffer,max bufferSize is limited to 32766. Defaults to an internal 8 char buffer if bufferSize is < 8 or is omitted  
+         @param bufferSize -- number of bytes to buffer,max bufferSize is limited to 32766 on AVR boards, see BufferedRingIndex.h. Defaults to an internal 8 char buffer if bufferSize is < 8 or is omitted  
          @param mode -- BLOCK_IF_FULL, DROP_UNTIL_EMPTY or DROP_IF_FULL  
                  BLOCK_IF_FULL,    like normal print, but with a buffer. Use this to see ALL the output, but will block the loop() when the output buffer fills  
                  DROP_UNTIL_EMPTY, when the output buffer is full, drop any more chars until it completely empties.  ~~<CR><NL> is inserted in the output to show chars were dropped.  
@@ -139,11 +247,40 @@ class BufferedOutput : public Stream {
      This blocks until the buffer empties
      **/
     virtual void flush(); 
+
+    /**
+      void flushAsync(BufferedOutputFlushCallback callback = NULL)
+      
+      Marks the output written so far and returns immediately. nextByteOut() releases the output as usual and,
+      once all of it, upto the mark, has been written to the stream, calls callback, from the same nextByteOut() call, and isFlushed() returns true.<br>
+      Unlike flush(), this does not wait for the stream's Tx buffer, call the stream's flush() from the callback if needed, e.g. before changing the baud rate.<br>
+      If nothing is waiting, callback is called before flushAsync( ) returns. A later flushAsync( ) replaces the mark and the callback.
+      Output removed by clear() or clearSpace( ) counts as flushed. Sinks are included, as for flush().<br>
+      In SPSC mode callback is not used, the producer polls isFlushed().<br>
+      e.g.<br>
+      <code>
+      void flushed(BufferedOutput& out) {<br>
+      &nbsp;&nbsp;readyToSleep = true;<br>
+      }<br>
+      ...<br>
+      output.flushAsync(flushed);<br>
+      </code>
+      
+      @param callback -- called once when the output upto the mark has been written to the stream, default NULL to just use isFlushed()
+      */
+    void flushAsync(BufferedOutputFlushCallback callback = NULL);
+    /**
+      bool isFlushed()
+      
+      @return true if all the output upto the last flushAsync( ) mark has been written to the stream, or flushAsync( ) has not been called
+      */
+    bool isFlushed();
     
     /**
     int availableForWrite()
     
     @return bytes available to write.  Includes the space available in the buffer plus the Serial Tx space available.
+    The Serial Tx space is only included when print( ) can write directly to it, i.e. the buffer is empty and not using pacing, sinks, channels, lanes, repeat suppression or SPSC.
     */
     virtual int availableForWrite();
     /**
@@ -164,6 +301,197 @@ class BufferedOutput : public Stream {
     @param len -- number of bytes to make available for write.
      **/
     int clearSpace(size_t len); 
+
+    /**
+      void setClearSpaceMode(BufferedOutputClearMode clearMode)
+      
+      Sets what clearSpace( ) removes. A line is the output upto and including a \\n<br>
+      <b>CLEAR_LAST_BYTES</b>, the default, removes the last bytes written. This can cut a line in half before the ~~ drop mark.<br>
+      <b>CLEAR_LAST_LINES</b> removes whole lines, newest first, followed by a ~~ drop mark.<br>
+      <b>CLEAR_OLDEST_LINES</b> removes whole lines, oldest first, and replaces them with a ~~ drop mark, so the latest output is kept.<br>
+      The line modes never remove the rest of a line that has already been partly sent, and like CLEAR_LAST_BYTES, do not remove output before a protect( ) mark.
+      Print whole lines, ending with \\n, when using the line modes.
+      
+      @param clearMode -- CLEAR_LAST_BYTES, CLEAR_LAST_LINES or CLEAR_OLDEST_LINES
+      */
+    void setClearSpaceMode(BufferedOutputClearMode clearMode);
+
+    /**
+      unsigned long getClearedLines()
+      
+      @return the total number of complete lines removed by clearSpace( ), 0 if no setStats( )
+      */
+    unsigned long getClearedLines();
+
+    /**
+      unsigned long getClearedBytes()
+      
+      @return the total number of bytes removed by clearSpace( ), 0 if no setStats( )
+      */
+    unsigned long getClearedBytes();
+
+    /**
+      void setStats(BufferedOutputStats& stats)
+
+      Keeps the output statistics in stats, call this in setup(). Without it the statistics below all return 0, which saves their RAM.<br>
+      Call this before addSink( ) or addChannel( ), each sink and channel keeps its own statistics if it is given a BufferedOutputStats.
+
+      @param stats -- the counters, these are reset
+      */
+    void setStats(BufferedOutputStats& stats);
+
+    /**
+      Output statistics, use these to choose the buffer size and mode, see setStats( ).<br>
+      The counts are totals since setStats( ) or resetStats( ) was called.<br>
+      e.g.<br>
+      <code>
+      BufferedOutputStats outputStats;<br>
+      ...<br>
+      output.setStats(outputStats); // in setup()<br>
+      ...<br>
+      Serial.print(F("dropped ")); Serial.print(output.getBytesDropped()); Serial.print(F(" bytes in ")); Serial.print(output.getDropEvents()); Serial.println(F(" drops"));<br>
+      Serial.print(F("try createBufferedOutput(output, ")); Serial.print(output.recommendedBufferSize()); Serial.println(F(", ...)"));<br>
+      </code>
+      */
+    void resetStats();
+    /**
+      @return the number of bytes accepted for output, by write( ), print( ) and commit( )
+      */
+    unsigned long getBytesWritten();
+    /**
+      @return the number of bytes dropped because the buffer was full, or was emptying in DROP_UNTIL_EMPTY mode.
+      Includes the len of reserve( ) calls that returned NULL. Does not include the bytes removed by clearSpace( ) or clear( )
+      */
+    unsigned long getBytesDropped();
+    /**
+      @return the number of times output was dropped, each marked by ~~ in the output
+      */
+    unsigned long getDropEvents();
+    /**
+      @return the most bytes waiting in the buffer, the high-water mark
+      */
+    size_t getMaxBufferUsed();
+    /**
+      @return the total micro seconds write( ), print( ) and reserve( ) have delayed the loop() in BLOCK_IF_FULL mode.
+      This wraps around after about 71 minutes of blocking
+      */
+    unsigned long getBlockedMicros();
+    /**
+      @return the longest single delay in BLOCK_IF_FULL mode, in micro seconds
+      */
+    unsigned long getMaxBlockedMicros();
+    /**
+      @return the bytes per second sent from the buffer, only timed while there was output waiting in the buffer.
+      If this is less than the average rate output is printed at, no buffer size will be enough.
+      */
+    unsigned long getDrainRate();
+    /**
+      @return a suggested size for createBufferedOutput( ) to hold the largest burst of output seen without dropping or blocking, with 1/8 extra.
+      A burst is the output printed from when the buffer was empty until it empties again.
+      This can be smaller than the current size if the buffer has never filled.
+      */
+    size_t recommendedBufferSize();
+
+    /**
+      void setPacing(BufferedOutputPacing& pacing, unsigned long bytesPerSec, size_t burstBytes = 1)
+      
+      Limits the output to an average of bytesPerSec, e.g. to share a slow radio link, using a token bucket that holds upto burstBytes.<br>
+      After a pause, upto burstBytes are sent at once, then the output is released at bytesPerSec.
+      The rate is exact over time, it does not drift due to rounding of the time per byte.<br>
+      Pacing works with both connect( ) methods, with connect(stream, baudRate) it replaces the baudRate timer.
+      With pacing, nothing is written directly to the stream by print( ), all the output goes through the buffer.
+      Pacing cannot be used with channels, see addChannel( ).<br>
+      e.g. for a 1200 baud radio (8N1, 10 bits per byte) that can take 16 bytes at a time<br>
+      <code>
+      BufferedOutputPacing outputPacing;<br>
+      ...<br>
+      output.setPacing(outputPacing, 120, 16); // in setup()
+      </code>
+      
+      @param pacing -- holds the token bucket, it must stay in scope while the pacing is used
+      @param bytesPerSec -- the average bytes per second, 0 turns pacing off
+      @param burstBytes -- the most bytes sent together after a pause, default 1
+      */
+    void setPacing(BufferedOutputPacing& pacing, unsigned long bytesPerSec, size_t burstBytes = 1);
+
+    /**
+      void setMaxMicrosPerCall(unsigned long maxMicros)
+      
+      Limits how long each nextByteOut() spends writing to the stream, so a large backlog for a slow stream does not delay the loop().<br>
+      The bytes are written in blocks of BUFFERED_OUTPUT_BUDGET_CHUNK (16) and the time is checked after each block. At least one block is written each call.
+      
+      @param maxMicros -- the time limit in micro seconds, 0 (the default) for no limit
+      */
+    void setMaxMicrosPerCall(unsigned long maxMicros);
+
+    /**
+      void setFormatter(BufferedOutputFormatter formatter)
+      
+      Sets the function nextByteOut() calls to turn the records added by logDeferred( ) into text, call this in setup() before using logDeferred( ).<br>
+      The formatter prints the text for one record to out. The \r\n is added after it. Text longer than BUFFERED_OUTPUT_RECORD_TEXT_SIZE (64) is truncated.<br>
+      e.g.<br>
+      <code>
+      void formatLog(Print& out, uint8_t formatId, const long args[], uint8_t argCount) {<br>
+      &nbsp;&nbsp;if (formatId == 1) {<br>
+      &nbsp;&nbsp;&nbsp;&nbsp;out.print(F("temp ")); out.print(args[0] / 10.0, 1); out.print(F(" at ")); out.print(args[1]);<br>
+      &nbsp;&nbsp;}<br>
+      }<br>
+      ...<br>
+      output.setFormatter(formatLog);<br>
+      </code>
+      Once a formatter is set, a BUFFERED_OUTPUT_RECORD_MARK (0x01) byte in the output starts a record, so do not print that byte.
+      
+      @param formatter -- the function to format a record
+      */
+    void setFormatter(BufferedOutputFormatter formatter);
+
+    /**
+      size_t logDeferred(uint8_t formatId, long arg0, ... )
+      
+      Adds a compact binary record, formatId and upto BUFFERED_OUTPUT_RECORD_MAX_ARGS (4) 32bit args, to the output instead of the text.<br>
+      The text is only formatted, by the setFormatter( ) function, when nextByteOut() sends the record, so a record that is dropped costs no formatting.<br>
+      Each record is a line of output and is written all or nothing, using the mode as for write(buf,size). A record is never written directly to the stream.<br>
+      e.g.<br>
+      <code>output.logDeferred(1, tempX10, millis());</code><br>
+      
+      @param formatId -- passed to the formatter to choose the text
+      @param arg0 .. arg3 -- passed to the formatter, unsigned long args can be cast back by the formatter
+      @return the number of bytes added to the buffer, 0 if the record was dropped, no formatter has been set or this is a channel, see addChannel( )
+      */
+    size_t logDeferred(uint8_t formatId);
+    size_t logDeferred(uint8_t formatId, long arg0);
+    size_t logDeferred(uint8_t formatId, long arg0, long arg1);
+    size_t logDeferred(uint8_t formatId, long arg0, long arg1, long arg2);
+    size_t logDeferred(uint8_t formatId, long arg0, long arg1, long arg2, long arg3);
+    size_t logDeferred(uint8_t formatId, const long args[], uint8_t argCount);
+
+    /**
+      void setSuppressRepeats(BufferedOutputRepeats& repeats, bool suppress, unsigned long maxMillis = 1000)
+      
+      Removes lines that are the same as the line before, e.g. the same error printed every loop(), and writes one<br>
+      <code>last line repeated N times</code><br>
+      line when a different line is written, or every maxMillis while the repeats continue.<br>
+      Each line is compared, by its length and a 32bit hash, as its \n is written. Only lines written with write( ) and print( ) are checked.
+      Output from reserve( )/commit( ) and logDeferred( ) ends a run of repeats. allOrNothing still applies to the whole write( )/print( ), not to each line in it.<br>
+      A repeat can only be removed if none of it has been sent yet, so nothing is written directly to the stream and nextByteOut() holds back a partly written line
+      until its \n is written, the buffer is full or BUFFERED_OUTPUT_REPEAT_HOLD_MS (20) has passed. Print each line in one loop() to get the full benefit.<br>
+      Call this on the BufferedOutput that is written to, not on a sink. Not used with useSPSC().<br>
+      e.g.<br>
+      <code>
+      BufferedOutputRepeats outputRepeats;<br>
+      ...<br>
+      output.setSuppressRepeats(outputRepeats, true); // in setup()
+      </code>
+      
+      @param repeats -- holds the last line's hash and the repeat count, it must stay in scope while repeats are suppressed
+      @param suppress -- true to remove repeated lines, false (the default) to send them all
+      @param maxMillis -- the longest time between the repeated line summaries, 0 for only when a different line is written, default 1000
+      */
+    void setSuppressRepeats(BufferedOutputRepeats& repeats, bool suppress, unsigned long maxMillis = 1000);
+    /**
+      @return the number of repeated lines removed by setSuppressRepeats( ), reset by resetStats( ), 0 if repeats are not suppressed
+      */
+    unsigned long getRepeatsSuppressed();
     
     /**
       void protect()
@@ -192,7 +520,221 @@ class BufferedOutput : public Stream {
       */
     size_t terminateLastLine(); // adds a newline if one not already there
 
+    /**
+      uint8_t* reserve(size_t &len)
+      
+      Reserves space inside the buffer so the output can be formatted directly into it, without first formatting into a temporary buffer.<br>
+      Write upto len bytes starting at the returned pointer and then call commit(used) to add them to the output.<br>
+      No other output can be written to this BufferedOutput between reserve( ) and commit( ).<br>
+      Do not write '\0' bytes, they are treated as protect( ) marks and filtered from the output.<br>
+      e.g.<br>
+      <code>
+      size_t len = 20;<br>
+      uint8_t* p = output.reserve(len);<br>
+      if (p) {<br>
+      &nbsp;&nbsp;p[0] = '\0'; // ignore any old bytes in the buffer<br>
+      &nbsp;&nbsp;createSafeStringFromCharPtrWithSize(sfSpan, (char*)p, len); // capacity is len-1 leaving room for SafeString's terminating '\0'<br>
+      &nbsp;&nbsp;sfSpan.print(reading, 3);<br>
+      &nbsp;&nbsp;output.commit(sfSpan.length());<br>
+      }<br>
+      </code>
+      The space returned is always contiguous. If len bytes will not fit before the end of the ring buffer, the end is padded with '\0's
+      and the space at the start of the ring buffer is returned. Like protect( ), the padding stops clearSpace( ) removing earlier output.<br>
+      
+      The mode and allOrNothing settings are applied as for write(buf,len).<br>
+      If allOrNothing is true and len bytes will not fit, or mode is DROP_UNTIL_EMPTY and the buffer is still emptying, NULL is returned and a ~~ drop mark is added.<br>
+      If allOrNothing is false, len may be reduced to the space available. Commit the part written and call reserve( ) again for the rest.
+      If there is no space at all, NULL is returned and a ~~ drop mark is added.<br>
+      In BLOCK_IF_FULL mode, reserve( ) blocks until there is room for len bytes. len is limited to the buffer size.
+      
+      @param len -- the number of bytes wanted, updated to the number of bytes that can be written at the returned pointer, 0 if NULL returned
+      @return pointer to the reserved space, or NULL if no space available
+      */
+    uint8_t* reserve(size_t &len);
+    
+    /**
+      size_t commit(size_t used)
+      
+      Adds the first <i>used</i> bytes of the space returned by the last reserve( ) to the output.
+      
+      @param used -- the number of bytes written, limited to the len returned by reserve( )
+      @return the number of bytes added to the output
+      */
+    size_t commit(size_t used);
+
+    /**
+      void useSPSC()
+      
+      Switches to the lock free single producer single consumer mode, call this in setup() after connect( ).<br>
+      In this mode one core, or an ISR, can print/write to this BufferedOutput while another core calls nextByteOut() to send the output.<br>
+      The producer never blocks and never writes directly to the stream. Only nextByteOut( ) writes to the stream.<br>
+      Output dropped because the buffer is full is still marked with ~~<br>
+      
+      In SPSC mode<br>
+      BLOCK_IF_FULL is changed to DROP_IF_FULL.<br>
+      availableForWrite() returns just the buffer space, the stream's Tx buffer is not checked by the producer.<br>
+      DROP_UNTIL_EMPTY waits for this buffer to empty, it does not wait for the stream's Tx buffer to empty.<br>
+      clear() removes the buffered output on the consumer's next call to nextByteOut(). The ~~ drop mark is sent with the next output, when the stream has room.<br>
+      clearSpace( ) does not remove any output, since the consumer may be sending it.<br>
+      flush() waits for the consumer to empty the buffer, so do not call it from the consumer.<br>
+      The Stream methods, available(), read() and peek(), do not call nextByteOut()<br>
+      useSPSC() cannot be used with sinks, lanes or channels, the call is ignored and an error is printed to SafeString::Output.
+      */
+    void useSPSC();
+
+    /**
+      void addLowerPriority(BufferedOutput& lane)
+      
+      Adds another BufferedOutput as a lower priority lane sharing this BufferedOutput's stream, call this in setup() after connect( ).<br>
+      Each lane has its own buffer size, mode and allOrNothing setting, so debug output can be dropped while alarm messages still get through.<br>
+      Lanes added later have lower priority. A call to nextByteOut() on any of the lanes releases the output from all of them,
+      highest priority first. A lane only sends when all the higher priority lanes are empty.<br>
+      Once a lane starts sending a line it keeps the stream until the rest of that line in its buffer has been sent, so lines from different lanes are not mixed.
+      Print whole lines, ending with \\n, to each lane.<br>
+      e.g.<br>
+      <code>
+      createBufferedOutput(alarmOut, 80, BLOCK_IF_FULL);<br>
+      createBufferedOutput(debugOut, 200, DROP_IF_FULL);<br>
+      // in setup()<br>
+      alarmOut.connect(Serial);<br>
+      alarmOut.addLowerPriority(debugOut);<br>
+      // in loop()<br>
+      alarmOut.nextByteOut(); // releases both lanes<br>
+      </code>
+      Lanes cannot be used with useSPSC(), addSink( ) or addChannel( ), the lane is not added and an error is printed to SafeString::Output.
+      
+      @param lane -- the BufferedOutput to add as the lowest priority lane, it is connected to this BufferedOutput's stream
+      */
+    void addLowerPriority(BufferedOutput& lane);
+
+    /**
+      void addSink(BufferedOutput& sink)
+      
+      Sends a copy of this BufferedOutput's output to another stream as well, call this in setup() after connect( ) on both.<br>
+      The sink shares this BufferedOutput's buffer, it only keeps its own position in it, so each print( ) is only buffered once.<br>
+      Each sink is released at its own rate, set by its own connect( ) and setPacing( ).<br>
+      The sink's mode sets what happens when it falls behind.<br>
+      BLOCK_IF_FULL -- the sink keeps all the output, the buffer space it has not sent yet is not available, so this BufferedOutput's mode then applies to all the output.<br>
+      DROP_IF_FULL or DROP_UNTIL_EMPTY -- the sink does not hold back this BufferedOutput or the other sinks. 
+      If new output would write over output it has not sent yet, the sink sends a ~~ drop mark and skips on to the next line start, DROP_IF_FULL, or skips all the output waiting, DROP_UNTIL_EMPTY.<br>
+      e.g.<br>
+      <code>
+      createBufferedOutput(output, 200, DROP_IF_FULL);<br>
+      createBufferedOutput(radioOut, 0, DROP_IF_FULL); // the sink's own buffer is not used<br>
+      // in setup()<br>
+      output.connect(Serial);<br>
+      radioOut.connect(Serial1, 1200);<br>
+      output.addSink(radioOut);<br>
+      // in loop()<br>
+      output.nextByteOut(); // releases the sinks also<br>
+      output.print( ... ); // is sent to both Serial and Serial1<br>
+      </code>
+      Anything printed to a sink is added to this BufferedOutput. While there are sinks, clearSpace( ) does not remove output, and output is never written directly to the streams.<br>
+      Sinks cannot be used with useSPSC(), addLowerPriority( ) or addChannel( ), the sink is not added and an error is printed to SafeString::Output.
+      
+      @param sink -- the BufferedOutput, already connected to its stream, to add
+      */
+    void addSink(BufferedOutput& sink);
+
+    /**
+      uint8_t addChannel(BufferedOutput& channel, uint8_t weight = 1)
+      
+      Adds another BufferedOutput as a virtual channel sharing this BufferedOutput's stream, call this in setup() after connect( ).<br>
+      This BufferedOutput is channel 0, the channels added are numbered 1, 2, 3 ...<br>
+      All the output, including channel 0's, is then sent in frames of upto BUFFERED_MUX_MAX_FRAME (32) bytes,
+      BUFFERED_MUX_FRAME_START (0x1E), the channel number, the length, then the bytes.
+      Use a SafeStringDemux on the receiving side to separate the channels again.<br>
+      The channels take turns, each sending upto weight frames in its turn, so a busy channel does not hold up the others.
+      A call to nextByteOut() on any of the channels releases the output from all of them.<br>
+      e.g.<br>
+      <code>
+      createBufferedOutput(logOut, 200, DROP_IF_FULL);<br>
+      createBufferedOutput(telemetryOut, 100, DROP_IF_FULL);<br>
+      // in setup()<br>
+      logOut.connect(Serial); // channel 0<br>
+      logOut.addChannel(telemetryOut, 3); // channel 1, gets 3 frames to logOut's 1 when both are busy<br>
+      </code>
+      Channels cannot be used with useSPSC(), addLowerPriority( ), addSink( ) or setPacing( ), the channel is not added, 0 is returned, and an error is printed to SafeString::Output.
+      logDeferred( ) returns 0, and adds nothing, on channels.
+      
+      @param channel -- the BufferedOutput to add as the next channel, it is connected to this BufferedOutput's stream
+      @param weight -- the number of frames it sends in its turn, default 1
+      @return the channel number
+      */
+    uint8_t addChannel(BufferedOutput& channel, uint8_t weight = 1);
+
+    /**
+      void setChannelWeight(uint8_t weight)
+      
+      Sets the number of frames this channel sends in its turn, see addChannel( ).
+      
+      @param weight -- 1 to 255
+      */
+    void setChannelWeight(uint8_t weight);
+
   private:
+    void laneNextByteOut(); // releases bytes from just this lane
+    void laneRelease(); // laneNextByteOut() without the flushCheck()
+    size_t streamWriteDropMark(); // writes the ~~ if streamDropMark, returns its length
+    void setupError(const __FlashStringHelper *msg); // prints msg to SafeString::Output
+    bool laneCanSend(); // false if a higher priority lane has output or another lane is part way through a line
+    bool laneMidLine(); // true if this lane has sent part of a line and has more to send
+    BufferedOutput* higherLane; // NULL if no lanes or this is the highest priority lane
+    BufferedOutput* lowerLane; // NULL if no lanes or this is the lowest priority lane
+    uint8_t lastCharSent; // last byte written to the stream, '\n' at a line end
+    bool directWriteAllowed(); // true if write( ) can write directly to the stream
+    BufferedOutput* channelMux; // channel 0, which does the multiplexing, NULL if no channels
+    BufferedOutput* nextChannel; // NULL if no channels or this is the last channel
+    BufferedOutput* muxCurrent; // channel 0 only, the channel whose turn it is
+    uint8_t channelId;
+    uint8_t channelWeight; // frames sent per turn
+    uint8_t muxCredit; // frames left in this channel's turn
+    void muxNextByteOut();
+    BufferedOutput* nextSink; // next sink sharing this BufferedOutput's ring buffer, NULL if none
+    BufferedOutput* sinkSource; // the BufferedOutput this is a sink of, NULL if not a sink
+    bool streamDropMark; // a sink skipped some output, or an SPSC clear() removed some, send ~~ with the next output when there is room
+    bool sinkSkipLine; // a sink skipped part of a line, skip the rest of it when it is written
+    void sinkSkip(size_t len); // a dropping sink skips len bytes and the rest of that line
+    BufferedOutputClearMode clearMode;
+
+    // pacing and time budget
+    size_t paceAllowed(size_t n);
+    void paceSent(size_t n);
+    size_t writeOut(size_t room, size_t limit); // write upto room bytes to the stream from the first limit bytes of the buffer, paced and time limited
+    BufferedOutputPacing* pacing; // NULL for no pacing
+    unsigned long maxMicrosPerCall; // 0 for no limit
+
+    BufferedOutputFormatter recordFormatter; // NULL if logDeferred( ) not used
+
+    // flushAsync( )
+    bool flushReached(); // the tail of this, and of each sink, has passed flushTarget
+    void flushCheck(); // calls the callback when flushReached()
+    bool flushWaiting;
+    BufferedRingIndex flushTarget; // head when flushAsync( ) was called
+    BufferedOutputFlushCallback flushCallback; // NULL if none or SPSC
+
+    // repeated line suppression
+    size_t repeatWrite(const uint8_t *buffer, size_t size); // write( ) each line, then remove it again if it is a repeat
+    void repeatLineEnd(); // a \n was written
+    bool repeatLineInBuffer(); // none of the current line has been sent yet
+    void repeatWriteSummary(bool beforeLine); // last line repeated N times
+    void repeatCheckTime(); // write the summary if maxMillis has passed
+    void repeatBreak(); // output that is not checked ends the run of repeats
+    size_t repeatHeld(); // bytes of the partly written line that nextByteOut() holds back
+    BufferedOutputRepeats* repeats; // NULL if not suppressing repeats
+
+    // statistics
+    void statsWritten(size_t n);
+    void statsDropped(size_t n);
+    void statsDemand(size_t used);
+    unsigned long statsBlockStart(size_t waiting); // returns micros()
+    void statsBlockEnd(unsigned long blockStart);
+    void statsDrainTime(); // times the drain rate while there is output waiting
+    void statsDrained(size_t n);
+    void statsCleared(size_t bytes, size_t lines); // removed by clearSpace( )
+    BufferedOutputStats* stats; // NULL if no setStats( )
+    void producerNextByteOut(); // nextByteOut() unless in SPSC mode
+    bool spsc; // true if useSPSC() called
     int internalAvailableForWrite();
     int internalStreamAvailableForWrite(); // returns 0 if no availableForWrite else connection.availableForWrite()-1 to allow for ESP blocking on 1
     void writeDropMark();
@@ -206,39 +748,62 @@ class BufferedOutput : public Stream {
     HardwareSerial* serialPtr; // non-null if HardwareSerial and availableForWrite returns non zero
     uint32_t baudRate;
     unsigned long sendTimerStart;
+    size_t sendTimerBytes; // bytes written by the last baud rate release, e.g. a record's text or a mux frame, the next release waits for them to be sent
     bool waitForEmpty;
     Print* debugOut; // only used if #define DEBUG uncomment in BufferedOutput.cpp
     int txBufferSize; // serial tx buffer, if any OR set to zero to only use ringBuffer
     bool dropMarkWritten;
     uint8_t lastCharWritten; // check for \n
+    size_t reservedLen; // space returned by last reserve( ), 0 if none or committed
 
     // ringBuffer methods
     /**
        _buf must be at least _size in length
-       _size is limited to 32766
+       _size is limited to BUFFERED_RING_MAX_SIZE, 32766 on AVR boards
     */
     void rb_init(uint8_t* _buf, size_t _size);
     void rb_clear();
     bool rb_clearSpace(size_t len); //returns true if some output dropped, clears space in outgoing (write) buffer, by removing last bytes written
+    bool rb_clearLastLines(size_t tobedropped); // CLEAR_LAST_LINES
+    bool rb_clearOldestLines(size_t tobedropped); // CLEAR_OLDEST_LINES, replaces the lines with a drop mark
+    bool rb_isLineStart(BufferedRingIndex idx); // true if the byte before idx, ignoring '\0's, is '\n'
+    size_t rb_countNewLines(BufferedRingIndex idx, size_t len);
     // from Stream
-    inline int rb_available() {
-      return rb_buffer_count;
-    }
+    int rb_available();
     int rb_peek();
     int rb_read();
+    size_t rb_read(uint8_t *buffer, size_t size); // returns number of bytes read, at most two memcpy's
+    void rb_skip(size_t len); // remove len bytes, len must be <= rb_available()
+    bool rb_reserve(size_t len, size_t maxUsed); // make len contiguous bytes available at rb_buffer_head, padding with '\0' if necessary
+    size_t rb_writeTo(Stream* streamPtr, size_t room, size_t limit, size_t &sent); // write upto room bytes to stream from the first limit bytes, in contiguous blocks, skipping '\0's and formatting records
+    size_t rb_writeRecordTo(Stream* streamPtr, size_t room, bool force, size_t &textLen); // format and write the record at the tail
+    BufferedRingIndex rb_recordStart(BufferedRingIndex idx); // start of a record that idx is inside of
     size_t rb_write(uint8_t b); // does not block, drops bytes if buffer full
     size_t rb_write(const uint8_t *buffer, size_t size); // does not block, drops bytes if buffer full
-    int rb_availableForWrite(); // {   return (bufSize - buffer_count); }
+    int rb_availableForWrite(); // {   return (bufSize - rb_used()); }
+    int rb_used(); // bytes not sent by this or by any BLOCK_IF_FULL sink
+    void rb_sinksMakeRoom(size_t len); // dropping sinks skip output that len more bytes would write over
+    bool rb_sinksWaiting(); // true if any sink has output to send
     size_t rb_getSize(); // size of ring buffer
     bool rb_lastBufferedByteProtect();
     void rb_dump(Stream* streamPtr);
 
     uint8_t* rb_buf;
-    uint16_t rb_bufSize;
-    uint16_t rb_buffer_head;
-    uint16_t rb_buffer_tail;
-    uint16_t rb_buffer_count;
-    uint16_t rb_wrapBufferIdx(uint16_t idx);
+    BufferedRingIndex rb_bufSize;
+    BufferedRingIndex rb_buffer_head; // mirror index 0 to 2*rb_bufSize-1, only stored by the producer
+    BufferedRingIndex* rb_headPtr; // &rb_buffer_head, or the source's head for a sink
+    BufferedRingIndex rb_buffer_tail; // mirror index 0 to 2*rb_bufSize-1, only stored by the consumer
+    BufferedRingIndex rb_clearToIdx; // SPSC clear() request, consumer drops upto here
+    BufferedRingIndex rb_clearRequests; // incremented by producer for each SPSC clear()
+    BufferedRingIndex rb_clearsDone; // consumer's copy of rb_clearRequests
+    inline size_t rb_pos(BufferedRingIndex idx) { // position in rb_buf of a mirror index
+      return (idx < rb_bufSize) ? idx : (idx - rb_bufSize);
+    }
+    BufferedRingIndex rb_advance(BufferedRingIndex idx, size_t n);
+    BufferedRingIndex rb_prev(BufferedRingIndex idx);
+    size_t rb_distance(BufferedRingIndex idx, BufferedRingIndex laterIdx);
+    void rb_requestClear();
+    void rb_processClearRequest();
     void rb_internalWrite(uint8_t b);
 };
 
@@ -0,0 +1,80 @@
+#ifndef BufferedRingIndex_h
+#define BufferedRingIndex_h
+#ifdef __cplusplus
+
+/**
+  BufferedRingIndex.h
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+*/
+
+/***
+  The index type used by the BufferedOutput and BufferedInput ring buffers.
+
+  On AVR boards (UNO, Mega, etc) the indices are uint16_t and the buffer size is limited to 32766 bytes.
+  On larger boards (ESP32, ESP8266, RP2040, SAMD, etc) the indices are size_t so buffers of 128K to 1M bytes can be used
+  to absorb bursts of output.
+
+  To override the board default, add one of
+    -DBUFFERED_RING_INDEX_16BIT   to force 16bit indices, saves a few bytes of RAM for each BufferedOutput/BufferedInput
+    -DBUFFERED_RING_INDEX_SIZE_T  to force size_t indices
+  to the compiler flags, e.g. build_flags in platformio.ini
+  The setting must be the same for the library and the sketch, so a #define in the sketch is not enough.
+*/
+
+#include <Arduino.h>
+#include <limits.h>
+
+#if !defined(BUFFERED_RING_INDEX_16BIT) && !defined(BUFFERED_RING_INDEX_SIZE_T)
+#if defined(__AVR__)
+#define BUFFERED_RING_INDEX_16BIT
+#else
+#define BUFFERED_RING_INDEX_SIZE_T
+#endif
+#endif
+
+#ifdef BUFFERED_RING_INDEX_16BIT
+typedef uint16_t BufferedRingIndex;
+// available() etc return int, so limit to max int16_t - 1, this also keeps the 2*size mirror indices in 16bits
+#define BUFFERED_RING_MAX_SIZE 32766
+#else
+typedef size_t BufferedRingIndex;
+// available() etc return int and add the Serial Tx buffer space, so keep well below max int
+#define BUFFERED_RING_MAX_SIZE ((size_t)(INT_MAX / 2))
+#endif
+
+/***
+  The ring buffers use mirror indices that run from 0 to 2*size-1, so head == tail is empty and head - tail == size is full.
+  This means the producer only ever writes the head and the consumer only ever writes the tail, there is no shared count.
+  The indices are read and written with these acquire / release functions so that, in the single producer single consumer (SPSC) mode,
+  one core or an ISR can add bytes while another core removes them without locks.
+  On AVR boards interrupts are disabled while the 16bit index is accessed.
+*/
+#if defined(__AVR__)
+static inline BufferedRingIndex bufferedRingLoad(const BufferedRingIndex *idxPtr) {
+  uint8_t oldSREG = SREG;
+  cli();
+  BufferedRingIndex idx = *((const volatile BufferedRingIndex*)idxPtr);
+  SREG = oldSREG;
+  return idx;
+}
+static inline void bufferedRingStore(BufferedRingIndex *idxPtr, BufferedRingIndex idx) {
+  uint8_t oldSREG = SREG;
+  cli();
+  *((volatile BufferedRingIndex*)idxPtr) = idx;
+  SREG = oldSREG;
+}
+#else
+static inline BufferedRingIndex bufferedRingLoad(const BufferedRingIndex *idxPtr) {
+  return __atomic_load_n(idxPtr, __ATOMIC_ACQUIRE);
+}
+static inline void bufferedRingStore(BufferedRingIndex *idxPtr, BufferedRingIndex idx) {
+  __atomic_store_n(idxPtr, idx, __ATOMIC_RELEASE);
+}
+#endif
+
+#endif  // __cplusplus
+#endif // BufferedRingIndex_h
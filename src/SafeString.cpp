@@ -1129,7 +1129,8 @@ size_t SafeString::print(const __FlashStringHelper *pstr) {
 #endif // SSTRING_DEBUG
     return 0;
   }
-  size_t newlen = len + strlen_P((PGM_P)pstr);
+  size_t pLen = strlen_P((PGM_P)pstr);
+  size_t newlen = len + pLen;
   if (!reserve(newlen)) {
     setError();
 #ifdef SSTRING_DEBUG
@@ -1139,8 +1140,35 @@ size_t SafeString::print(const __FlashStringHelper *pstr) {
 #endif // SSTRING_DEBUG
     return 0;
   }
-  concat(pstr);
-  return (strlen_P((PGM_P)pstr));
+  concatFlashInternal(pstr, pLen, false);
+  return pLen;
+}
+
+size_t SafeString::print(const SafeStringFlash &fstr) {
+  cleanUp();
+  if (!fstr.pstr) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("print"));
+      debugPtr->print(F(" was passed a NULL F_LEN( ) pointer"));
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return 0;
+  }
+  size_t newlen = len + fstr.length;
+  if (!reserve(newlen)) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      capError(F("print"), newlen, NULL, fstr.pstr);
+    }
+#endif // SSTRING_DEBUG
+    return 0;
+  }
+  concatFlashInternal(fstr.pstr, fstr.length, false);
+  return fstr.length;
 }
 
 // =========================================
@@ -1478,6 +1506,23 @@ SafeString & SafeString::operator = (const __FlashStringHelper *pstr) {
   return concatInternal(pstr, true);
 }
 
+SafeString & SafeString::operator = (const SafeStringFlash &fstr) {
+  cleanUp();
+  if (!fstr.pstr) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      debugPtr->print(F("Error:"));
+      outputName();
+      debugPtr->print(F(" = NULL F_LEN( ) ptr "));
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return *this;
+  } // else
+  return concatFlashInternal(fstr.pstr, fstr.length, true);
+}
+
 SafeString & SafeString::operator = (unsigned char c) {
   printInternal((unsigned long)c, DEC, true);
   return *this;
@@ -1608,7 +1653,23 @@ SafeString & SafeString::prefix(const __FlashStringHelper * pstr) {
 #endif // SSTRING_DEBUG
     return *this;
   }
-  return prefix(pstr, strlen_P((PGM_P)pstr));
+  return prefixFlashInternal(pstr, strlen_P((PGM_P)pstr));
+}
+
+SafeString & SafeString::prefix(const SafeStringFlash &fstr) {
+  cleanUp();
+  if (!fstr.pstr) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      prefixErr();
+      debugPtr->print(F(" was passed a NULL pointer"));
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return *this;
+  }
+  return prefixFlashInternal(fstr.pstr, fstr.length);
 }
 
 SafeString & SafeString::prefix(const __FlashStringHelper * pstr, size_t length) {
@@ -1642,7 +1703,14 @@ SafeString & SafeString::prefix(const __FlashStringHelper * pstr, size_t length)
 #endif // SSTRING_DEBUG
     return *this;
   }
+  return prefixFlashInternal(pstr, length);
+}
 
+// length is already known to be <= strlen_P(pstr), copy it in one block
+SafeString & SafeString::prefixFlashInternal(const __FlashStringHelper * pstr, size_t length) {
+  if (length == 0) {
+    return *this;
+  }
   size_t newlen = len + length;
   if (!reserve(newlen)) {
     setError();
@@ -1832,6 +1900,22 @@ SafeString & SafeString::concat(const __FlashStringHelper * pstr, size_t length)
   return concatInternal(pstr, length, false);
 }
 
+SafeString & SafeString::concat(const SafeStringFlash &fstr) {
+  cleanUp();
+  if (!fstr.pstr) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("concat"));
+      debugPtr->print(F(" was passed a NULL F_LEN( ) pointer"));
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return *this;
+  }
+  return concatFlashInternal(fstr.pstr, fstr.length, false);
+}
+
 // ============== internal concat methods
 // concat at most length chars from cstr
 // this method applies assignOp
@@ -1961,7 +2045,18 @@ SafeString & SafeString::concatInternal(const __FlashStringHelper * pstr, size_t
     }
     return *this;
   }
+  return concatFlashInternal(pstr, length, assignOp);
+}
 
+// length is already known to be <= strlen_P(pstr), copy it in one block
+// this method applies assignOp
+SafeString & SafeString::concatFlashInternal(const __FlashStringHelper * pstr, size_t length, bool assignOp) {
+  if (length == 0) {
+    if (assignOp) {
+      clear();
+    }
+    return *this;
+  }
   size_t newlen = len + length;
   if (assignOp) {
     newlen = length;
@@ -2070,7 +2165,7 @@ SafeString & SafeString::concatInternal(const __FlashStringHelper * pstr, bool a
     }
     return *this;
   }
-  return concatInternal(pstr, strlen_P((PGM_P)pstr), assignOp);
+  return concatFlashInternal(pstr, strlen_P((PGM_P)pstr), assignOp);
 }
 
 
@@ -2120,6 +2215,22 @@ int SafeString::compareTo(const char* cstr) {
   return strcmp(buffer, cstr);
 }
 
+int SafeString::compareTo(const __FlashStringHelper *pstr) {
+  cleanUp();
+  if (!pstr) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("compareTo"));
+      debugPtr->print(F(" was passed a NULL F( ) pointer"));
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return 1; // > for NULL
+  }
+  return strcmp_P(buffer, (PGM_P)pstr);
+}
+
 unsigned char SafeString::equals(SafeString &s2) {
   s2.cleanUp();
   cleanUp();
@@ -2146,6 +2257,40 @@ unsigned char SafeString::equals(const char *cstr) {
   return strcmp(buffer, cstr) == 0;
 }
 
+// error if pstr is NULL
+unsigned char SafeString::equals(const __FlashStringHelper *pstr) {
+  cleanUp();
+  if (!pstr) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("equals"));
+      debugPtr->print(F(" was passed a NULL F( ) pointer"));
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return false;
+  }
+  return strcmp_P(buffer, (PGM_P)pstr) == 0;
+}
+
+// the length is known so different lengths never read the flash
+unsigned char SafeString::equals(const SafeStringFlash &fstr) {
+  cleanUp();
+  if (!fstr.pstr) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("equals"));
+      debugPtr->print(F(" was passed a NULL F_LEN( ) pointer"));
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return false;
+  }
+  return ((len == fstr.length) && (strncmp_P(buffer, (PGM_P)fstr.pstr, len) == 0));
+}
+
 // compare string to char
 unsigned char SafeString::equals(const char c) {
   cleanUp();
@@ -2337,6 +2482,68 @@ unsigned char SafeString::startsWith( const char *str2, unsigned int fromIndex )
   return strncmp( &buffer[fromIndex], str2, str2Len ) == 0;
 }
 
+unsigned char SafeString::startsWith(const __FlashStringHelper *pstr, unsigned int fromIndex) {
+  cleanUp();
+  if (!pstr) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("startsWith"));
+      debugPtr->print(F(" was passed a NULL F( ) pointer"));
+      outputFromIndexIfFullDebug(fromIndex);
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return false;
+  }
+  return startsWithFlashInternal(pstr, strlen_P((PGM_P)pstr), fromIndex);
+}
+
+unsigned char SafeString::startsWith(const SafeStringFlash &fstr, unsigned int fromIndex) {
+  cleanUp();
+  if (!fstr.pstr) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("startsWith"));
+      debugPtr->print(F(" was passed a NULL F_LEN( ) pointer"));
+      outputFromIndexIfFullDebug(fromIndex);
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return false;
+  }
+  return startsWithFlashInternal(fstr.pstr, fstr.length, fromIndex);
+}
+
+unsigned char SafeString::startsWithFlashInternal(const __FlashStringHelper *pstr, size_t pLen, unsigned int fromIndex) {
+  if (fromIndex == ((unsigned int)(-1))) {
+    fromIndex = len;
+  }
+  if (fromIndex > len) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("startsWith"));
+      debugPtr->print(F(" fromIndex ")); debugPtr->print(fromIndex); debugPtr->print(F(" > ")); outputName(); debugPtr->print(F(".length() : ")); debugPtr->print(len);
+      if (fullDebug) {
+        debugPtr->println(); debugPtr->print(F("       "));
+        debugPtr->print(F(" Input arg was '")); debugPtr->print(pstr); debugPtr->print('\'');
+      }
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return false;
+  }
+  if ((fromIndex + pLen) > len ) {
+    return false;
+  }
+  if (pLen == 0) {
+    return (fromIndex == len);
+  }
+  return strncmp_P(&buffer[fromIndex], (PGM_P)pstr, pLen) == 0;
+}
+
 unsigned char SafeString::startsWith( SafeString &s2, unsigned int fromIndex ) {
   s2.cleanUp();
   cleanUp();
@@ -2614,6 +2821,44 @@ unsigned char SafeString::endsWith(const char *suffix) {
   return strcmp(&buffer[len - str2Len], suffix) == 0;
 }
 
+unsigned char SafeString::endsWith(const __FlashStringHelper *suffix) {
+  cleanUp();
+  if (!suffix) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("endsWith"));
+      debugPtr->print(F(" was passed a NULL F( ) pointer"));
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return false;
+  }
+  return endsWith(SafeStringFlash(suffix, strlen_P((PGM_P)suffix)));
+}
+
+unsigned char SafeString::endsWith(const SafeStringFlash &suffix) {
+  cleanUp();
+  if (!suffix.pstr) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("endsWith"));
+      debugPtr->print(F(" was passed a NULL F_LEN( ) pointer"));
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return false;
+  }
+  if (len < suffix.length) {
+    return false;
+  }
+  if (suffix.length == 0) {
+    return (len == 0);
+  }
+  return strcmp_P(&buffer[len - suffix.length], (PGM_P)suffix.pstr) == 0;
+}
+
 unsigned char SafeString::endsWithCharFrom(SafeString &s2) {
   s2.cleanUp();
   cleanUp();
@@ -2932,6 +3177,95 @@ int SafeString::indexOf(const char* cstr , unsigned int fromIndex) {
   return (int)(found - buffer);
 }
 
+int SafeString::indexOf(const __FlashStringHelper *pstr, unsigned int fromIndex) {
+  cleanUp();
+  if (!pstr) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("indexOf"));
+      debugPtr->print(F(" was passed a NULL F( ) pointer"));
+      outputFromIndexIfFullDebug(fromIndex);
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return -1;
+  }
+  return indexOfFlashInternal(pstr, strlen_P((PGM_P)pstr), fromIndex);
+}
+
+int SafeString::indexOf(const SafeStringFlash &fstr, unsigned int fromIndex) {
+  cleanUp();
+  if (!fstr.pstr) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("indexOf"));
+      debugPtr->print(F(" was passed a NULL F_LEN( ) pointer"));
+      outputFromIndexIfFullDebug(fromIndex);
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return -1;
+  }
+  return indexOfFlashInternal(fstr.pstr, fstr.length, fromIndex);
+}
+
+// memchr for the first char in RAM then compare the rest from flash, only reads flash at candidate matches
+int SafeString::indexOfFlashInternal(const __FlashStringHelper *pstr, size_t pLen, unsigned int fromIndex) {
+  if (pLen == 0) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("indexOf"));
+      debugPtr->print(F(" was passed an empty F( ) string"));
+      outputFromIndexIfFullDebug(fromIndex);
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    // return -1;
+  }
+  if ((fromIndex == (unsigned int)(-1)) || (fromIndex == len)) {
+    return -1;
+  }
+  if (fromIndex > len) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("indexOf"));
+      debugPtr->print(F(" fromIndex ")); debugPtr->print(fromIndex); debugPtr->print(F(" > ")); outputName(); debugPtr->print(F(".length() : ")); debugPtr->print(len);
+      if (fullDebug) {
+        debugPtr->println(); debugPtr->print(F("       "));
+        debugPtr->print(F(" Input arg was '")); debugPtr->print(pstr); debugPtr->print('\'');
+      }
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return -1;
+  }
+  if (pLen == 0) {
+    return fromIndex; // as for strstr
+  }
+  if ((len - fromIndex) < pLen) {
+    return -1;
+  }
+  PGM_P p = (PGM_P)pstr;
+  char firstChar = (char)pgm_read_byte(p);
+  const char *searchPtr = buffer + fromIndex;
+  const char *lastStart = buffer + (len - pLen); // last possible match position
+  while (searchPtr <= lastStart) {
+    const char *found = (const char *)memchr(searchPtr, firstChar, (lastStart - searchPtr) + 1);
+    if (found == NULL) {
+      return -1;
+    }
+    if ((pLen == 1) || (strncmp_P(found + 1, p + 1, pLen - 1) == 0)) {
+      return (int)(found - buffer);
+    }
+    searchPtr = found + 1;
+  }
+  return -1;
+}
+
 int SafeString::lastIndexOf( char theChar ) {
   return lastIndexOf(theChar, len - 1); // calls cleanUp() // if len == 0, len-1 == (unsigned int)-1
 }
@@ -3725,6 +4059,189 @@ void SafeString::keepLast(unsigned int count) {
   remove(0, len - count);
 }
 
+/*****  UTF-8 methods ***********/
+// true if c is a UTF-8 continuation byte 0b10xxxxxx
+static inline bool isUTF8Continuation(char c) {
+  return ((((uint8_t)c) & 0xC0) == 0x80);
+}
+
+// true if none of the 4 bytes starting at p have the top bit set, i.e. all ASCII
+// uses memcpy so unaligned p is OK on all boards
+static inline bool isASCIIWord(const char *p) {
+  uint32_t w;
+  memcpy(&w, p, sizeof(w));
+  return ((w & 0x80808080UL) == 0);
+}
+
+// one pass, skips runs of ASCII 4 bytes at a time
+unsigned char SafeString::isUTF8() {
+  cleanUp();
+  const uint8_t *p = (const uint8_t *)buffer;
+  size_t i = 0;
+  while (i < len) {
+    if ((i + 4) <= len && isASCIIWord(buffer + i)) {
+      i += 4;
+      continue;
+    }
+    uint8_t c = p[i];
+    if (c < 0x80) {
+      i++;
+      continue;
+    }
+    size_t need; // continuation bytes needed
+    uint8_t lo = 0x80; // limits for the first continuation byte, excludes overlongs, surrogates and > U+10FFFF
+    uint8_t hi = 0xBF;
+    if (c < 0xC2) {
+      return false; // continuation byte or overlong 2 byte sequence
+    } else if (c < 0xE0) {
+      need = 1;
+    } else if (c < 0xF0) {
+      need = 2;
+      if (c == 0xE0) {
+        lo = 0xA0;
+      } else if (c == 0xED) {
+        hi = 0x9F;
+      }
+    } else if (c < 0xF5) {
+      need = 3;
+      if (c == 0xF0) {
+        lo = 0x90;
+      } else if (c == 0xF4) {
+        hi = 0x8F;
+      }
+    } else {
+      return false;
+    }
+    if ((i + need) >= len) {
+      return false; // truncated sequence
+    }
+    if ((p[i + 1] < lo) || (p[i + 1] > hi)) {
+      return false;
+    }
+    for (size_t j = 2; j <= need; j++) {
+      if (!isUTF8Continuation(buffer[i + j])) {
+        return false;
+      }
+    }
+    i += need + 1;
+  }
+  return true;
+}
+
+unsigned int SafeString::utf8Length() {
+  cleanUp();
+  unsigned int count = 0;
+  size_t i = 0;
+  while (i < len) {
+    if ((i + 4) <= len && isASCIIWord(buffer + i)) {
+      i += 4;
+      count += 4;
+      continue;
+    }
+    if (!isUTF8Continuation(buffer[i])) {
+      count++;
+    }
+    i++;
+  }
+  return count;
+}
+
+unsigned int SafeString::utf8Index(unsigned int cpIndex) {
+  cleanUp();
+  size_t i = 0;
+  while (i < len) {
+    if (!isUTF8Continuation(buffer[i])) {
+      if (cpIndex == 0) {
+        return i;
+      }
+      cpIndex--;
+    }
+    i++;
+  }
+  return len;
+}
+
+SafeString & SafeString::utf8Substring(SafeString &result, unsigned int beginCP, unsigned int endCP) {
+  cleanUp();
+  unsigned int cpLen = utf8Length();
+  if ((beginCP != (unsigned int)(-1)) && (beginCP > cpLen)) {
+    return substring(result, len + 1); // raises the beginIdx > length() error
+  }
+  unsigned int beginIdx = (beginCP == (unsigned int)(-1)) ? beginCP : utf8Index(beginCP);
+  unsigned int endIdx = endCP;
+  if (endCP != (unsigned int)(-1)) {
+    endIdx = (endCP > cpLen) ? (len + 1) : utf8Index(endCP); // > length() raises an error in substring
+  }
+  return substring(result, beginIdx, endIdx);
+}
+
+// remove the last 'count' code points
+void SafeString::utf8RemoveLast(unsigned int count) {
+  cleanUp();
+  size_t i = len;
+  unsigned int n = count;
+  while ((n > 0) && (i > 0)) {
+    i--;
+    if (!isUTF8Continuation(buffer[i])) {
+      n--;
+    }
+  }
+  if (n > 0) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("utf8RemoveLast"));
+      debugPtr->print(F(" count ")); debugPtr->print(count); debugPtr->print(F(" > ")); outputName(); debugPtr->print(F(".utf8Length() : ")); debugPtr->print(utf8Length());
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+  }
+  removeFrom(i);
+}
+
+// keep the last 'count' code points, remove the rest
+void SafeString::utf8KeepLast(unsigned int count) {
+  cleanUp();
+  if (count == 0) {
+    clear();
+    return;
+  }
+  size_t i = len;
+  unsigned int n = count;
+  while ((n > 0) && (i > 0)) {
+    i--;
+    if (!isUTF8Continuation(buffer[i])) {
+      n--;
+    }
+  }
+  if (n > 0) {
+    setError();
+#ifdef SSTRING_DEBUG
+    if (debugPtr) {
+      errorMethod(F("utf8KeepLast"));
+      debugPtr->print(F(" count ")); debugPtr->print(count); debugPtr->print(F(" > ")); outputName(); debugPtr->print(F(".utf8Length() : ")); debugPtr->print(utf8Length());
+      debugInternalMsg(fullDebug);
+    }
+#endif // SSTRING_DEBUG
+    return;
+  }
+  removeBefore(i);
+}
+
+// reduce length() to at most maxBytes, backing up to the start of a code point
+void SafeString::utf8Truncate(unsigned int maxBytes) {
+  cleanUp();
+  if (maxBytes >= len) {
+    return;
+  }
+  size_t i = maxBytes;
+  while ((i > 0) && isUTF8Continuation(buffer[i])) {
+    i--;
+  }
+  removeFrom(i);
+}
+/***** end of UTF-8 methods ***********/
+
 /***** end of removeFrom(), keepFrom() remove(), remooveLast(), keepLast() methods ***********/
 
 /*****  end of Modification replace(), remove(), removeLast()  *******/
@@ -5409,3 +5926,25 @@ unsigned char SafeString::toInt64_t(int64_t &l) {
   return true; // OK
 }
 
+
+
+// print the F_LEN( ) string in blocks via a small RAM buffer, one write( ) per block
+size_t SafeStringFlash::printTo(Print& p) const {
+  char buf[32];
+  size_t rtn = 0;
+  size_t offset = 0;
+  while (offset < length) {
+    size_t n = length - offset;
+    if (n > sizeof(buf)) {
+      n = sizeof(buf);
+    }
+    memcpy_P(buf, ((PGM_P)pstr) + offset, n);
+    size_t written = p.write((const uint8_t*)buf, n);
+    rtn += written;
+    if (written != n) {
+      break;
+    }
+    offset += n;
+  }
+  return rtn;
+}
\ No newline at end of file
@@ -225,6 +225,34 @@
 #define cSFP createSafeStringFromCharPtr
 #define cSFPS createSafeStringFromCharPtrWithSize
 
+/**
+  F_LEN("text")
+  creates a SafeStringFlash, an F("text") string with its length worked out by the compiler.
+  Use it instead of F("text") in SafeString assignments, concats, prefixes and compares so the flash does not have to be scanned for the terminating '\0'
+  e.g. sfStr = F_LEN("HTTP/1.1 200 OK"); if (sfStr.startsWith(F_LEN("HTTP"))) { ...
+  Only string literals can be used, F_LEN(charPtr) will give the wrong length.
+*/
+#define F_LEN(string_literal) SafeStringFlash(F(string_literal), sizeof(string_literal) - 1)
+
+/**************
+  A **SafeStringFlash** holds a F( ) string and its length, create one with the F_LEN("..") macro, see the detailed description.
+
+  SafeStringFlash can be used where F("..") is used in assignments, concat( ), prefix( ), += , -= , equals( ), == , !=, startsWith( ), endsWith( ) and indexOf( ).<br>
+  Since the length is already known, the text is copied or compared in one block using memcpy_P / strncmp_P instead of first scanning for its length with strlen_P.<br>
+  It can also be printed, e.g. Serial.print(F_LEN("Ready"));
+****************************************************************************************/
+class SafeStringFlash : public Printable {
+  public:
+    SafeStringFlash(const __FlashStringHelper *_pstr, size_t _length) : pstr(_pstr), length(_length) {
+      if (pstr == NULL) {
+        length = 0;
+      }
+    }
+    size_t printTo(Print& p) const;
+    const __FlashStringHelper *pstr;
+    size_t length;
+};
+
 /**************
   To create SafeStrings use one of the four (4) macros **createSafeString** or **cSF**, **createSafeStringFromCharArray** or **cSFA**, **createSafeStringFromCharPtr** or **cSFP**, **createSafeStringFromCharPtrWithSize** or **cSFPS** see the detailed description. 
   
@@ -481,6 +509,7 @@ class SafeString : public Printable, public Print {
     size_t print(int64_t, int = DEC);
     size_t print(double, int = 2);
     size_t print(const __FlashStringHelper *);
+    size_t print(const SafeStringFlash &fstr);
     size_t print(const char*);
     size_t print(char);
     size_t print(SafeString &str);
@@ -649,6 +678,11 @@ class SafeString : public Printable, public Print {
     ****************************************************************************/
     SafeString & operator = (const __FlashStringHelper *pstr); // handle F(" .. ") values
 
+    /*************************************************************
+    Clears this SafeString and copies the F_LEN("..") string, using its known length
+    ****************************************************************************/
+    SafeString & operator = (const SafeStringFlash &fstr); // handle F_LEN(" .. ") values
+
     /********
       prefix methods add to the front of the current SafeString.
       
@@ -671,6 +705,7 @@ class SafeString : public Printable, public Print {
     SafeString & prefix(const __FlashStringHelper * str);
     SafeString & prefix(const char *cstr, size_t length);
     SafeString & prefix(const __FlashStringHelper * str, size_t length);
+    SafeString & prefix(const SafeStringFlash &fstr);
 
     /*******
       concat methods add to the end of the current SafeString.
@@ -692,6 +727,7 @@ class SafeString : public Printable, public Print {
     SafeString & concat(float num);
     SafeString & concat(double num);
     SafeString & concat(const __FlashStringHelper * str);
+    SafeString & concat(const SafeStringFlash &fstr);
     // ------------------------------------------------------
     // no corresponding methods these three (3) in  prefix, +=, -+
     
@@ -757,6 +793,9 @@ class SafeString : public Printable, public Print {
     SafeString & operator -= (const __FlashStringHelper *str) {
       return prefix(str);
     }
+    SafeString & operator -= (const SafeStringFlash &fstr) {
+      return prefix(fstr);
+    }
 
     /* concat() operator  +=  ******************
       Operator versions of concat( )
@@ -807,6 +846,9 @@ class SafeString : public Printable, public Print {
     SafeString & operator += (const __FlashStringHelper *str) {
       return concat(str);
     }
+    SafeString & operator += (const SafeStringFlash &fstr) {
+      return concat(fstr);
+    }
 
     /* Comparision methods and operators  ******************
       comparisons only work with SafeStrings and "strings"
@@ -821,10 +863,16 @@ class SafeString : public Printable, public Print {
        returns -1 if this SafeString is < cstr, 0 if this SafeString == cstr and +1 if this SafeString > cst
      **/
     int compareTo(const char *cstr) ;
+     /***
+       compares with a F("..") string, reading the flash in blocks with strcmp_P
+     **/
+    int compareTo(const __FlashStringHelper *pstr) ;
     
     unsigned char equals(SafeString &s) ;
     unsigned char equals(const char *cstr) ;
     unsigned char equals(const char c) ;
+    unsigned char equals(const __FlashStringHelper *pstr) ;
+    unsigned char equals(const SafeStringFlash &fstr) ;
     unsigned char operator == (SafeString &rhs) {
       return equals(rhs);
     }
@@ -834,6 +882,12 @@ class SafeString : public Printable, public Print {
     unsigned char operator == (const char c) {
       return equals(c);
     }
+    unsigned char operator == (const __FlashStringHelper *pstr) {
+      return equals(pstr);
+    }
+    unsigned char operator == (const SafeStringFlash &fstr) {
+      return equals(fstr);
+    }
     unsigned char operator != (SafeString &rhs) {
       return !equals(rhs);
     }
@@ -843,6 +897,12 @@ class SafeString : public Printable, public Print {
     unsigned char operator != (const char c) {
       return !equals(c);
     }
+    unsigned char operator != (const __FlashStringHelper *pstr) {
+      return !equals(pstr);
+    }
+    unsigned char operator != (const SafeStringFlash &fstr) {
+      return !equals(fstr);
+    }
     unsigned char operator <  (SafeString &rhs) {
       return compareTo(rhs) < 0;
     }
@@ -898,6 +958,15 @@ class SafeString : public Printable, public Print {
       @param fromIndex -- where in the SafeString to start looking, default 0, that is start from beginning
     **/
     unsigned char startsWith(SafeString &s2, unsigned int fromIndex = 0) ;
+    /** 
+      returns non-zero of this SafeString starts with the F("..") argument looking from fromIndex onwards.
+      Use the F_LEN("..") version to avoid scanning the flash for its length
+      
+      @param pstr -- the F("..") string to check for
+      @param fromIndex -- where in the SafeString to start looking, default 0, that is start from beginning
+    **/
+    unsigned char startsWith(const __FlashStringHelper *pstr, unsigned int fromIndex = 0) ;
+    unsigned char startsWith(const SafeStringFlash &fstr, unsigned int fromIndex = 0) ;
     
     /** 
       returns non-zero of this SafeString starts this argument, ignoring case, looking from fromIndex onwards.
@@ -940,6 +1009,13 @@ class SafeString : public Printable, public Print {
       @param suffix -- string to check for
     **/
     unsigned char endsWith(const char *suffix) ;
+    /** 
+      returns non-zero of this SafeString ends with the F("..") or F_LEN("..") argument
+      
+      @param suffix -- string to check for
+    **/
+    unsigned char endsWith(const __FlashStringHelper *suffix) ;
+    unsigned char endsWith(const SafeStringFlash &suffix) ;
     /** 
       returns non-zero of this SafeString ends any one of the chars in the argument
       
@@ -1032,6 +1108,15 @@ class SafeString : public Printable, public Print {
       @return -1 if not found, else the index in the range 0 to length()-1
       */
     int indexOf( SafeString & str, unsigned int fromIndex = 0 ) ;
+    /**
+      returns the index of the F("..") or F_LEN("..") string, searching from fromIndex.<br>
+      Uses memchr to find each candidate first char and then compares the rest directly from flash
+      @param pstr - the F("..") string to search for
+      @param fromIndex - where to start the search from, default 0, that is from begining<br> if fromIndex > length() raise an error<br> if fromIndex == -1 OR fromIndex == length(), return -1 without error
+      @return -1 if not found, else the index in the range 0 to length()-1
+      */
+    int indexOf(const __FlashStringHelper *pstr, unsigned int fromIndex = 0) ;
+    int indexOf(const SafeStringFlash &fstr, unsigned int fromIndex = 0) ;
 
     /**
       returns the last index of the char, searching backwards from fromIndex (inclusive).
@@ -1265,6 +1350,60 @@ class SafeString : public Printable, public Print {
       */
     void keepLast(unsigned int count);
 
+    /* *** UTF-8 methods ************/
+    // SafeString lengths and indices are in bytes (chars). These methods work in UTF-8 code points
+    // and never split a multi-byte UTF-8 sequence.
+    /**
+      check this SafeString is valid UTF-8, in one pass.<br>
+      Overlong encodings, surrogates (U+D800 to U+DFFF) and values > U+10FFFF are invalid.
+      @return true if valid UTF-8 (plain ASCII is valid UTF-8)
+      */
+    unsigned char isUTF8();
+
+    /**
+      @return the number of UTF-8 code points.  For invalid UTF-8, each byte that is not a continuation byte (0b10xxxxxx) is counted.
+      */
+    unsigned int utf8Length();
+
+    /**
+      @param cpIndex - a code point index, 0 to utf8Length()
+      @return the byte index of the start of that code point, length() if cpIndex >= utf8Length()
+      */
+    unsigned int utf8Index(unsigned int cpIndex);
+
+    /**
+      The result is the substring from code point beginCP to code point endCP (exclusive)<br>
+      beginCP and endCP are converted to byte indices with utf8Index( ) and then substring( ) is called, so the same error rules apply.
+      @param result - the substring, it is ALWAYS cleared first
+      @param beginCP - the code point index of the start of the substring
+      @param endCP - the code point index after the end of the substring, (unsigned int)(-1) for the rest of this SafeString
+      @return result
+      */
+    SafeString & utf8Substring(SafeString & result, unsigned int beginCP, unsigned int endCP = ((unsigned int)(-1)));
+
+    /**
+      remove the last count code points
+      @param count - the number of code points to remove<br>
+      count >= utf8Length() clears the SafeString<br>
+      count > utf8Length() raises and error
+      */
+    void utf8RemoveLast(unsigned int count);
+
+    /**
+      keep the last count code points and remove the rest
+      @param count - the number of code points to keep<br>
+      count == 0 clears the SafeString<br>
+      count > utf8Length() raises and error and leaves the SafeString unchanged
+      */
+    void utf8KeepLast(unsigned int count);
+
+    /**
+      reduce the length() to at most maxBytes, without splitting a multi-byte code point.<br>
+      If the byte at maxBytes is in the middle of a code point, that whole code point is removed, so the result may be shorter than maxBytes.
+      @param maxBytes - the maximum length( ) to keep, e.g. the size of a display line or MQTT field
+      */
+    void utf8Truncate(unsigned int maxBytes);
+
 
     /* *** change case ************/
     /**
@@ -1955,6 +2094,10 @@ class SafeString : public Printable, public Print {
     SafeString & concatInternal(const char *cstr, bool assignOp = false);
     SafeString & concatInternal(char c, bool assignOp = false);
     SafeString & concatInternal(const __FlashStringHelper * str, bool assignOp = false);
+    SafeString & concatFlashInternal(const __FlashStringHelper * str, size_t length, bool assignOp); // length already checked, one memcpy_P
+    SafeString & prefixFlashInternal(const __FlashStringHelper * str, size_t length); // length already checked, one memcpy_P
+    unsigned char startsWithFlashInternal(const __FlashStringHelper * str, size_t length, unsigned int fromIndex);
+    int indexOfFlashInternal(const __FlashStringHelper * str, size_t length, unsigned int fromIndex);
     size_t printInternal(long, int = DEC, bool assignOp = false);
     size_t printInternal(unsigned long, int = DEC, bool assignOp = false);
     size_t printInternal(double, int = 2, bool assignOp = false);
@@ -0,0 +1,130 @@
+#ifndef SAFE_STRING_CRC_H
+#define SAFE_STRING_CRC_H
+/*
+  SafeStringCRC.h  table driven CRC-8, CRC-16 (CCITT and Modbus) and CRC-32
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+#ifdef __cplusplus
+#include <Arduino.h>
+#include "SafeString.h"
+#include "SafeStringView.h"
+
+// slicing-by-4 processes 4 bytes per step for CRC-16/MODBUS and CRC-32, but uses 3 more 256 entry tables
+// i.e. 1.5K more flash for CRC-16/MODBUS and 3K more for CRC-32, only if they are used.
+// It is not used on AVR boards by default, #define SAFE_STRING_CRC_NO_SLICING to turn it off on other boards
+#if !defined(ARDUINO_ARCH_AVR) && !defined(SAFE_STRING_CRC_NO_SLICING)
+#define SAFE_STRING_CRC_SLICING
+#endif
+
+// handle namespace arduino
+#include "SafeStringNameSpaceStart.h"
+
+/**************
+  **SafeStringCRC** is the base class for the CRC calculators, see the detailed description.
+
+  Each calculator keeps a running CRC so the input can be added a piece at a time, e.g. as each SafeStringReader token is read,
+  and <code>getCRC()</code> returns the CRC of all the input added since the last <code>reset()</code>.<br>
+  The calculators are Print objects so anything that can be printed can be added to the CRC, e.g. <code>crc.print(sfToken); crc.print(count);</code><br>
+  The static <code>calc( )</code> methods return the CRC of one SafeString or byte range.<br>
+
+  **SafeStringCRC8** CRC-8, poly 0x07, init 0x00 e.g. "123456789" gives 0xF4<br>
+  **SafeStringCRC16CCITT** CRC-16/CCITT-FALSE, poly 0x1021, init 0xFFFF e.g. "123456789" gives 0x29B1<br>
+  **SafeStringCRC16Modbus** CRC-16/MODBUS, poly 0x8005 reflected, init 0xFFFF e.g. "123456789" gives 0x4B37, send the low byte first<br>
+  **SafeStringCRC32** CRC-32 (Ethernet, zip), poly 0x04C11DB7 reflected, init and final xor 0xFFFFFFFF e.g. "123456789" gives 0xCBF43926<br>
+
+  The tables are in PROGMEM.  If SAFE_STRING_CRC_SLICING is defined, CRC-16/MODBUS and CRC-32 process 4 bytes per step.<br>
+  e.g.<br>
+<code>
+  uint32_t crc = SafeStringCRC32::calc(sfMsg);<br>
+  SafeStringCRC16Modbus modbusCRC;<br>
+  modbusCRC.update(frame, frameLen);<br>
+  uint16_t crc16 = modbusCRC.getCRC();<br>
+</code>
+****************************************************************************************/
+class SafeStringCRC : public Print {
+  public:
+    /**
+      start a new CRC
+    */
+    virtual void reset() = 0;
+    /**
+      add length bytes to the CRC
+    */
+    virtual void update(const uint8_t *data, size_t length) = 0;
+    void update(uint8_t b);
+    void update(const char *str);
+    void update(SafeString &str);
+    void update(const SafeStringView &str);
+
+    /**
+      Print interface, adds the bytes to the CRC
+      @return the number of bytes added
+    */
+    virtual size_t write(uint8_t b);
+    virtual size_t write(const uint8_t *buffer, size_t length);
+    using Print::write; // pull in write(str)
+};
+
+class SafeStringCRC8 : public SafeStringCRC {
+  public:
+    SafeStringCRC8();
+    void reset();
+    void update(const uint8_t *data, size_t length);
+    using SafeStringCRC::update;
+    /**
+      @return the CRC of the input added since the last reset(), more input can still be added
+    */
+    uint8_t getCRC();
+    static uint8_t calc(const uint8_t *data, size_t length);
+    static uint8_t calc(SafeString &str);
+  private:
+    uint8_t crc;
+};
+
+class SafeStringCRC16CCITT : public SafeStringCRC {
+  public:
+    SafeStringCRC16CCITT();
+    void reset();
+    void update(const uint8_t *data, size_t length);
+    using SafeStringCRC::update;
+    uint16_t getCRC();
+    static uint16_t calc(const uint8_t *data, size_t length);
+    static uint16_t calc(SafeString &str);
+  private:
+    uint16_t crc;
+};
+
+class SafeStringCRC16Modbus : public SafeStringCRC {
+  public:
+    SafeStringCRC16Modbus();
+    void reset();
+    void update(const uint8_t *data, size_t length);
+    using SafeStringCRC::update;
+    uint16_t getCRC();
+    static uint16_t calc(const uint8_t *data, size_t length);
+    static uint16_t calc(SafeString &str);
+  private:
+    uint16_t crc;
+};
+
+class SafeStringCRC32 : public SafeStringCRC {
+  public:
+    SafeStringCRC32();
+    void reset();
+    void update(const uint8_t *data, size_t length);
+    using SafeStringCRC::update;
+    uint32_t getCRC();
+    static uint32_t calc(const uint8_t *data, size_t length);
+    static uint32_t calc(SafeString &str);
+  private:
+    uint32_t crc; // before the final xor
+};
+
+#include "SafeStringNameSpaceEnd.h"
+
+#endif  // __cplusplus
+#endif // SAFE_STRING_CRC_H
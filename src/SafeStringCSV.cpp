@@ -0,0 +1,198 @@
+/*
+  SafeStringCSV.cpp  a one pass CSV record indexer
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+
+#include "SafeStringCSV.h"
+
+#include "SafeStringNameSpace.h"
+
+SafeStringCSV::SafeStringCSV(SafeStringCSVField *_fields, size_t _maxFields, char _delimiter) {
+  fields = _fields;
+  maxFields = _maxFields;
+  if (fields == NULL) {
+    maxFields = 0;
+  }
+  delimiter = _delimiter;
+  recordPtr = "";
+  recordLen = 0;
+  fieldCount = 0;
+  recordFieldCount = 0;
+  malformedFlag = false;
+}
+
+void SafeStringCSV::setDelimiter(char _delimiter) {
+  delimiter = _delimiter;
+}
+
+bool SafeStringCSV::index(SafeString &record) {
+  return index(record.c_str(), record.length());
+}
+
+void SafeStringCSV::addField(size_t offset, size_t length) {
+  if (fieldCount < maxFields) {
+    fields[fieldCount].offset = offset;
+    fields[fieldCount].length = length;
+    fieldCount++;
+  }
+  recordFieldCount++;
+}
+
+void SafeStringCSV::malformed(const __FlashStringHelper *msg) {
+  malformedFlag = true;
+#ifdef SSTRING_DEBUG
+  SafeString::Output.print(F("SafeStringCSV Error: ")); SafeString::Output.println(msg);
+#else
+  (void)(msg);
+#endif // SSTRING_DEBUG
+}
+
+bool SafeStringCSV::index(const char *record, size_t length) {
+  fieldCount = 0;
+  recordFieldCount = 0;
+  malformedFlag = false;
+  recordPtr = "";
+  recordLen = 0;
+  if (record == NULL) {
+    return false;
+  }
+  // ignore trailing \r\n
+  while ((length > 0) && ((record[length - 1] == '\n') || (record[length - 1] == '\r'))) {
+    length--;
+  }
+  recordPtr = record;
+  recordLen = length;
+  if (length == 0) {
+    return true; // no fields
+  }
+
+  size_t i = 0;
+  while (true) {
+    // at the start of a field
+    if (record[i] == '"') {
+      i++;
+      size_t start = i;
+      while (true) {
+        const char *q = (const char*)memchr(record + i, '"', length - i);
+        if (q == NULL) {
+          malformed(F("missing closing quote"));
+          addField(start, length - start);
+          i = length;
+          break;
+        }
+        i = q - record;
+        if (((i + 1) < length) && (record[i + 1] == '"')) {
+          i += 2; // escaped "" skip it
+          continue;
+        }
+        addField(start, i - start);
+        i++; // skip closing quote
+        break;
+      }
+      if ((i < length) && (record[i] != delimiter)) {
+        malformed(F("chars after closing quote"));
+        // skip to the next delimiter
+        const char *d = (const char*)memchr(record + i, delimiter, length - i);
+        i = (d == NULL) ? length : (size_t)(d - record);
+      }
+    } else {
+      const char *d = (const char*)memchr(record + i, delimiter, length - i);
+      size_t end = (d == NULL) ? length : (size_t)(d - record);
+      addField(i, end - i);
+      i = end;
+    }
+    if (i >= length) {
+      break;
+    }
+    i++; // skip delimiter
+    if (i == length) {
+      addField(length, 0); // record ends with a delimiter, so last field is empty
+      break;
+    }
+  }
+  return (!isOverflow()) && (!malformedFlag);
+}
+
+size_t SafeStringCSV::getFieldCount() {
+  return fieldCount;
+}
+
+size_t SafeStringCSV::getRecordFieldCount() {
+  return recordFieldCount;
+}
+
+bool SafeStringCSV::isOverflow() {
+  return (recordFieldCount > fieldCount);
+}
+
+bool SafeStringCSV::isMalformed() {
+  return malformedFlag;
+}
+
+SafeStringView SafeStringCSV::field(size_t idx) {
+  if (idx >= fieldCount) {
+    return SafeStringView();
+  }
+  return SafeStringView(recordPtr + fields[idx].offset, fields[idx].length);
+}
+
+bool SafeStringCSV::isQuoted(size_t idx) {
+  if (idx >= fieldCount) {
+    return false;
+  }
+  size_t offset = fields[idx].offset;
+  // unquoted fields always start at the beginning of the record or after a delimiter
+  return ((offset > 0) && (recordPtr[offset - 1] == '"'));
+}
+
+size_t SafeStringCSV::getOffset(size_t idx) {
+  if (idx >= fieldCount) {
+    return recordLen;
+  }
+  return fields[idx].offset;
+}
+
+size_t SafeStringCSV::getLength(size_t idx) {
+  if (idx >= fieldCount) {
+    return 0;
+  }
+  return fields[idx].length;
+}
+
+bool SafeStringCSV::copyField(size_t idx, SafeString &result) {
+  result.clear();
+  if (idx >= fieldCount) {
+    return false;
+  }
+  const char *p = recordPtr + fields[idx].offset;
+  size_t len = fields[idx].length;
+  if (!isQuoted(idx)) {
+    result.concat(p, len);
+    return (result.length() == len);
+  }
+  size_t unescapedLen = len;
+  for (size_t i = 0; i < len; i++) {
+    if (p[i] == '"') {
+      unescapedLen--;
+      i++; // skip the second "
+    }
+  }
+  if (unescapedLen > result.capacity()) {
+    result.concat(p, len); // will fail and flag the error on result
+    return false;
+  }
+  size_t start = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (p[i] == '"') {
+      result.concat(p + start, i + 1 - start); // include the first "
+      i++; // skip the second "
+      start = i + 1;
+    }
+  }
+  result.concat(p + start, len - start);
+  return true;
+}
@@ -0,0 +1,144 @@
+#ifndef SAFE_STRING_CSV_H
+#define SAFE_STRING_CSV_H
+/*
+  SafeStringCSV.h  a one pass CSV record indexer
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+#ifdef __cplusplus
+#include <Arduino.h>
+#include "SafeString.h"
+#include "SafeStringView.h"
+
+// handle namespace arduino
+#include "SafeStringNameSpaceStart.h"
+
+/**
+  createSafeStringCSV( )
+  params
+    name - name of this SafeStringCSV variable (DO NOT use " " just use the plain name see the examples)
+    maxFields - the maximum number of fields that can be indexed in one record
+
+    example
+    createSafeStringCSV(csv, 10);
+    This creates a SafeStringCSV csv which can index records of upto 10 fields, using a ',' delimiter.
+    Use csv.setDelimiter(';') to change the delimiter
+*/
+#define createSafeStringCSV(name, maxFields) \
+  SafeStringCSVField name ## _FIELDS_BUFFER[(maxFields)]; \
+  SafeStringCSV name(name ## _FIELDS_BUFFER, (maxFields));
+
+// the position of one field in the record, for quoted fields this excludes the enclosing quotes
+typedef struct {
+  size_t offset;
+  size_t length;
+} SafeStringCSVField;
+
+/**************
+  To create a SafeStringCSV use the macro **createSafeStringCSV**  see the detailed description.
+
+  <code>index(record)</code> scans a CSV record once and fills the fields array with the (offset, length) of each field.<br>
+  No fields are copied. <code>field(i)</code> returns a SafeStringView of the field's text, which can be compared, converted to a number or printed in place.<br>
+  The record must not be changed while its fields are being accessed.<br>
+
+  Fields may be enclosed in double quotes, "..", to include the delimiter, and a quote is included in a quoted field by doubling it, "".<br>
+  The view of a quoted field excludes the enclosing quotes but still has the doubled quotes, use <code>copyField(i, sfResult)</code> to get the unescaped text.<br>
+  Trailing \\r\\n are ignored. An empty record has no fields.<br>
+
+  If the record has more than <i>maxFields</i> fields, the first <i>maxFields</i> are indexed, <code>isOverflow()</code> returns true
+  and <code>getRecordFieldCount()</code> still returns the total number of fields in the record.<br>
+  A quoted field with no closing quote, or with other chars between the closing quote and the next delimiter, sets <code>isMalformed()</code>.<br>
+  e.g.<br>
+<code>
+  createSafeStringCSV(csv, 10);<br>
+  if (sfReader.read()) {<br>
+  &nbsp;&nbsp;if (csv.index(sfReader)) {<br>
+  &nbsp;&nbsp;&nbsp;&nbsp;long id;<br>
+  &nbsp;&nbsp;&nbsp;&nbsp;if (csv.field(0).toLong(id)) { ... }<br>
+  &nbsp;&nbsp;}<br>
+  }<br>
+</code>
+****************************************************************************************/
+class SafeStringCSV {
+  public:
+    // use createSafeStringCSV(name, maxFields); instead of calling this constructor
+    explicit SafeStringCSV(SafeStringCSVField *fields, size_t maxFields, char delimiter = ',');
+
+    /**
+      setDelimiter(char delimiter)
+      @param delimiter - the field separator, default ','. Use '\\t' for tab separated records
+    */
+    void setDelimiter(char delimiter);
+
+    /**
+      index(SafeString& record)
+      scans the record once and records the position of each field.
+      @param record - the CSV record e.g. a SafeStringReader token, not copied, so it must not change while the fields are accessed
+      @return true if all the fields were indexed and the record was well formed, otherwise see isOverflow() and isMalformed()
+    */
+    bool index(SafeString &record);
+    bool index(const char *record, size_t length);
+
+    /**
+      @return the number of fields indexed, at most maxFields
+    */
+    size_t getFieldCount();
+    /**
+      @return the number of fields in the record, more than getFieldCount() if isOverflow()
+    */
+    size_t getRecordFieldCount();
+    /**
+      @return true if the record had more than maxFields fields
+    */
+    bool isOverflow();
+    /**
+      @return true if a quoted field was not closed or was followed by chars other than the delimiter
+    */
+    bool isMalformed();
+
+    /**
+      field(idx)
+      @param idx - the field to return, 0 is the first field
+      @return a view of the field text, excluding any enclosing quotes, empty if idx >= getFieldCount()
+    */
+    SafeStringView field(size_t idx);
+    /**
+      @return true if field idx was enclosed in quotes
+    */
+    bool isQuoted(size_t idx);
+    /**
+      @return the offset of field idx in the record, or the record length if idx >= getFieldCount()
+    */
+    size_t getOffset(size_t idx);
+    /**
+      @return the length of field idx, 0 if idx >= getFieldCount()
+    */
+    size_t getLength(size_t idx);
+
+    /**
+      copyField(idx, result)
+      Clears result and copies field idx into it, replacing "" in quoted fields by "
+      @return false if idx >= getFieldCount() or result does not have the capacity to hold the field, in which case result is left empty
+    */
+    bool copyField(size_t idx, SafeString &result);
+
+  private:
+    void addField(size_t offset, size_t length);
+    void malformed(const __FlashStringHelper *msg);
+    SafeStringCSVField *fields;
+    size_t maxFields;
+    char delimiter;
+    const char *recordPtr;
+    size_t recordLen;
+    size_t fieldCount;
+    size_t recordFieldCount;
+    bool malformedFlag;
+};
+
+#include "SafeStringNameSpaceEnd.h"
+
+#endif  // __cplusplus
+#endif // SAFE_STRING_CSV_H
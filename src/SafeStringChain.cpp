@@ -0,0 +1,272 @@
+/*
+  SafeStringChain.cpp  links a number of SafeStrings into one logical string
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+
+#include "SafeStringChain.h"
+
+#include "SafeStringNameSpace.h"
+
+SafeStringChain::SafeStringChain(SafeString **segmentsBuf, size_t _maxSegments, const char *_name) {
+  segments = segmentsBuf;
+  maxSegments = _maxSegments;
+  if (segments == NULL) {
+    maxSegments = 0;
+  }
+  segmentCount = 0;
+  name = _name;
+  errorFlag = false;
+}
+
+bool SafeStringChain::addSegment(SafeString &segment) {
+  if (segmentCount >= maxSegments) {
+    errorFlag = true;
+#ifdef SSTRING_DEBUG
+    SafeString::Output.print(F("Error: "));
+    if (name) {
+      SafeString::Output.print(name);
+    }
+    SafeString::Output.print(F(".addSegment() chain already has maxSegments:")); SafeString::Output.println(maxSegments);
+#endif // SSTRING_DEBUG
+    return false;
+  }
+  segments[segmentCount++] = &segment;
+  return true;
+}
+
+size_t SafeStringChain::getSegmentCount() {
+  return segmentCount;
+}
+
+SafeString *SafeStringChain::getSegment(size_t idx) {
+  if (idx >= segmentCount) {
+    return NULL;
+  }
+  return segments[idx];
+}
+
+void SafeStringChain::removeSegments() {
+  segmentCount = 0;
+}
+
+size_t SafeStringChain::length() {
+  size_t total = 0;
+  for (size_t i = 0; i < segmentCount; i++) {
+    total += segments[i]->length();
+  }
+  return total;
+}
+
+size_t SafeStringChain::capacity() {
+  size_t total = 0;
+  for (size_t i = 0; i < segmentCount; i++) {
+    total += segments[i]->capacity();
+  }
+  return total;
+}
+
+// space left after the last segment that has text
+size_t SafeStringChain::available() {
+  size_t total = 0;
+  for (size_t i = segmentCount; i > 0; i--) {
+    SafeString *seg = segments[i - 1];
+    total += seg->capacity() - seg->length();
+    if (seg->length() != 0) {
+      break; // earlier segments are before the end of the text
+    }
+  }
+  return total;
+}
+
+void SafeStringChain::clear() {
+  for (size_t i = 0; i < segmentCount; i++) {
+    segments[i]->clear();
+  }
+}
+
+char SafeStringChain::charAt(size_t index) {
+  for (size_t i = 0; i < segmentCount; i++) {
+    size_t segLen = segments[i]->length();
+    if (index < segLen) {
+      return segments[i]->charAt(index);
+    }
+    index -= segLen;
+  }
+  return '\0';
+}
+
+void SafeStringChain::capError(const __FlashStringHelper *methodName, size_t needed) {
+  errorFlag = true;
+#ifdef SSTRING_DEBUG
+  SafeString::Output.print(F("Error: "));
+  if (name) {
+    SafeString::Output.print(name);
+  }
+  SafeString::Output.print('.'); SafeString::Output.print(methodName); SafeString::Output.print(F("() needs "));
+  SafeString::Output.print(needed); SafeString::Output.print(F(" more chars, only ")); SafeString::Output.print(available());
+  SafeString::Output.println(F(" available"));
+#else
+  (void)(methodName);
+  (void)(needed);
+#endif // SSTRING_DEBUG
+}
+
+// all or nothing, fill the last segment with text then spill into the following empty segments
+size_t SafeStringChain::addChars(const char *cstr, size_t length) {
+  if (length == 0) {
+    return 0;
+  }
+  if (length > available()) {
+    return 0;
+  }
+  size_t i = segmentCount;
+  while ((i > 0) && (segments[i - 1]->length() == 0)) {
+    i--;
+  }
+  if (i > 0) {
+    i--; // the last segment with text
+  }
+  size_t added = 0;
+  for (; (i < segmentCount) && (added < length); i++) {
+    SafeString *seg = segments[i];
+    size_t space = seg->capacity() - seg->length();
+    if (space == 0) {
+      continue;
+    }
+    size_t n = length - added;
+    if (n > space) {
+      n = space;
+    }
+    seg->concat(cstr + added, n);
+    added += n;
+  }
+  return added;
+}
+
+SafeStringChain & SafeStringChain::concat(char c) {
+  if (c == '\0') {
+    errorFlag = true;
+    return *this;
+  }
+  if (addChars(&c, 1) != 1) {
+    capError(F("concat"), 1);
+  }
+  return *this;
+}
+
+SafeStringChain & SafeStringChain::concat(const char *cstr) {
+  if (cstr == NULL) {
+    errorFlag = true;
+    return *this;
+  }
+  return concat(cstr, strlen(cstr));
+}
+
+SafeStringChain & SafeStringChain::concat(const char *cstr, size_t length) {
+  if (cstr == NULL) {
+    errorFlag = true;
+    return *this;
+  }
+  if (length > strnlen(cstr, length)) {
+    errorFlag = true; // '\0' in the chars
+    return *this;
+  }
+  if ((length != 0) && (addChars(cstr, length) != length)) {
+    capError(F("concat"), length);
+  }
+  return *this;
+}
+
+SafeStringChain & SafeStringChain::concat(SafeString &str) {
+  return concat(str.c_str(), str.length());
+}
+
+SafeStringChain & SafeStringChain::concat(const __FlashStringHelper *pstr) {
+  if (pstr == NULL) {
+    errorFlag = true;
+    return *this;
+  }
+  PGM_P p = reinterpret_cast<PGM_P>(pstr);
+  size_t length = strlen_P(p);
+  if (length > available()) {
+    capError(F("concat"), length);
+    return *this;
+  }
+  // copy from flash a small block at a time, there is space for all of it
+  char buf[16];
+  while (length > 0) {
+    size_t n = (length < sizeof(buf)) ? length : sizeof(buf);
+    memcpy_P(buf, p, n);
+    addChars(buf, n);
+    p += n;
+    length -= n;
+  }
+  return *this;
+}
+
+size_t SafeStringChain::write(uint8_t b) {
+  if (b == 0) {
+    errorFlag = true;
+    return 0;
+  }
+  char c = (char)b;
+  if (addChars(&c, 1) != 1) {
+    capError(F("write"), 1);
+    return 0;
+  }
+  return 1;
+}
+
+size_t SafeStringChain::write(const uint8_t *buffer, size_t length) {
+  if ((buffer == NULL) || (length > strnlen((const char*)buffer, length))) {
+    errorFlag = true;
+    return 0;
+  }
+  if (length == 0) {
+    return 0;
+  }
+  size_t added = addChars((const char*)buffer, length);
+  if (added != length) {
+    capError(F("write"), length);
+  }
+  return added;
+}
+
+size_t SafeStringChain::printTo(Print &p) const {
+  size_t total = 0;
+  for (size_t i = 0; i < segmentCount; i++) {
+    size_t segLen = segments[i]->length();
+    if (segLen) {
+      total += p.write((const uint8_t*)segments[i]->c_str(), segLen);
+    }
+  }
+  return total;
+}
+
+size_t SafeStringChain::writeTo(Print &p, size_t startIdx) {
+  size_t idx = 0; // start of this segment in the chain
+  for (size_t i = 0; i < segmentCount; i++) {
+    size_t segLen = segments[i]->length();
+    if (startIdx < (idx + segLen)) {
+      size_t offset = startIdx - idx;
+      size_t toWrite = segLen - offset;
+      size_t written = p.write((const uint8_t*)(segments[i]->c_str() + offset), toWrite);
+      startIdx += written;
+      if (written < toWrite) {
+        return startIdx; // output full
+      }
+    }
+    idx += segLen;
+  }
+  return idx; // all written
+}
+
+bool SafeStringChain::hasError() {
+  bool rtn = errorFlag;
+  errorFlag = false;
+  return rtn;
+}
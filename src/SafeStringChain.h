@@ -0,0 +1,149 @@
+#ifndef SAFE_STRING_CHAIN_H
+#define SAFE_STRING_CHAIN_H
+/*
+  SafeStringChain.h  links a number of SafeStrings into one logical string
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+#ifdef __cplusplus
+#include <Arduino.h>
+#include "SafeString.h"
+
+// handle namespace arduino
+#include "SafeStringNameSpaceStart.h"
+
+/**
+  createSafeStringChain( )
+  params
+    name - name of this SafeStringChain variable (DO NOT use " " just use the plain name see the examples)
+    maxSegments - the maximum number of SafeStrings that can be linked in this chain
+
+    example
+    createSafeStringChain(response, 4);
+    cSF(header, 60); cSF(body, 200); cSF(footer, 40);
+    response.addSegment(header); response.addSegment(body); response.addSegment(footer);
+*/
+#define createSafeStringChain(name, maxSegments) \
+  SafeString* name ## _SEGMENTS_BUFFER[(maxSegments)]; \
+  SafeStringChain name(name ## _SEGMENTS_BUFFER, (maxSegments), #name);
+
+/**************
+  To create a SafeStringChain use the macro **createSafeStringChain**  see the detailed description.
+
+  A SafeStringChain links a number of separate SafeString segments together and treats them as one string, see the detailed description.<br>
+  A large output, e.g. a web page, can then be built from a few smaller SafeStrings instead of one SafeString sized for the worst case.<br>
+
+  The chain's text is the text of each segment in the order they were added.<br>
+  <code>concat( )</code>, <code>print( )</code> and <code>write( )</code> add to the end of the last segment that has text, and spill into the following segments as each one fills up.<br>
+  As for SafeString, adds are all or nothing. If there is not enough space left in the chain, nothing is added and an error is raised.<br>
+  Segments can also be filled directly, e.g. <code>header = F("HTTP/1.1 200 OK");</code>, before adding to the chain.<br>
+
+  <code>printTo( )</code> (used by <code>Serial.print(chain)</code>) hands each segment to the Print in turn, without copying them together.<br>
+  <code>writeTo(client, startIdx)</code> writes as much as the Print will accept and returns where to continue from, for non-blocking outputs.<br>
+  e.g.<br>
+<code>
+  createSafeStringChain(page, 3);<br>
+  cSF(head, 40); cSF(body1, 100); cSF(body2, 100);<br>
+  page.addSegment(head); page.addSegment(body1); page.addSegment(body2);<br>
+  page.print(F("<html>")); .. page.print(reading); ..<br>
+  client.print(page);<br>
+</code>
+****************************************************************************************/
+class SafeStringChain : public Printable, public Print {
+  public:
+    // use createSafeStringChain(name, maxSegments); instead of calling this constructor
+    explicit SafeStringChain(SafeString **segmentsBuf, size_t maxSegments, const char *name = NULL);
+
+    /**
+      addSegment(SafeString& segment)
+      adds segment to the end of the chain, any text already in segment becomes part of the chain's text
+      @return false, and raises an error, if the chain already has maxSegments segments
+    */
+    bool addSegment(SafeString &segment);
+    /**
+      @return the number of segments added
+    */
+    size_t getSegmentCount();
+    /**
+      @return a pointer to the idx'th segment, NULL if idx >= getSegmentCount()
+    */
+    SafeString *getSegment(size_t idx);
+    /**
+      removes all the segments from the chain, the segments are not changed
+    */
+    void removeSegments();
+
+    /**
+      @return the total length of the text in all the segments
+    */
+    size_t length();
+    /**
+      @return the total capacity of all the segments
+    */
+    size_t capacity();
+    /**
+      @return the number of chars that can still be added to the chain
+    */
+    size_t available();
+    /**
+      clears all the segments
+    */
+    void clear();
+    /**
+      @return the char at index in the chain's text, '\\0' if index >= length()
+    */
+    char charAt(size_t index);
+
+    SafeStringChain & concat(char c);
+    SafeStringChain & concat(const char *cstr);
+    SafeStringChain & concat(const char *cstr, size_t length);
+    SafeStringChain & concat(SafeString &str);
+    SafeStringChain & concat(const __FlashStringHelper *pstr);
+
+    /**
+      Write (concat) bytes to this chain, from Print class. '\\0' bytes are not allowed.
+      @return the number of bytes added, either all or 0
+    */
+    virtual size_t write(uint8_t b);
+    virtual size_t write(const uint8_t *buffer, size_t length);
+    using Print::write; // pull in write(str)
+
+    /**
+      Implements the Printable interface, each segment is written to p in turn with p.write(buf, len)
+      @param p - where to print to
+    */
+    size_t printTo(Print &p) const;
+
+    /**
+      writeTo(Print& p, size_t startIdx)
+      writes the chain's text from startIdx, one segment at a time, until p does not accept a whole segment.
+      For non-blocking outputs, call again with the returned index until it equals length()
+      @param p - where to write to
+      @param startIdx - where to start writing from, default 0
+      @return the index of the next char to write, length() when all written
+    */
+    size_t writeTo(Print &p, size_t startIdx = 0);
+
+    /**
+      @return true if an error was detected since the last call to hasError( ), each call clears the error flag
+    */
+    bool hasError();
+
+  private:
+    SafeStringChain(const SafeStringChain& other); // no copies
+    size_t addChars(const char *cstr, size_t length);
+    void capError(const __FlashStringHelper *methodName, size_t needed);
+    SafeString **segments;
+    size_t maxSegments;
+    size_t segmentCount;
+    const char *name;
+    bool errorFlag;
+};
+
+#include "SafeStringNameSpaceEnd.h"
+
+#endif  // __cplusplus
+#endif // SAFE_STRING_CHAIN_H
@@ -0,0 +1,163 @@
+/*
+  SafeStringDemux.cpp  separates the channels sent by BufferedOutput::addChannel( )
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+
+#include "SafeStringDemux.h"
+
+#include "SafeStringNameSpace.h"
+
+// SafeStringDemux states
+static const uint8_t DEMUX_WAIT_START = 0;
+static const uint8_t DEMUX_CHANNEL = 1;
+static const uint8_t DEMUX_LENGTH = 2;
+static const uint8_t DEMUX_FRAME = 3;
+
+SafeStringDemuxChannel::SafeStringDemuxChannel(size_t bufferSize, uint8_t _buf[]) {
+  buf = _buf;
+  bufSize = (buf == NULL) ? 0 : bufferSize;
+  head = 0;
+  count = 0;
+  dropped = 0;
+  channelId = 0;
+  demuxPtr = NULL;
+  nextChannel = NULL;
+}
+
+size_t SafeStringDemuxChannel::getBytesDropped() {
+  size_t rtn = dropped;
+  dropped = 0;
+  return rtn;
+}
+
+bool SafeStringDemuxChannel::put(uint8_t b) {
+  if (count >= bufSize) {
+    dropped++;
+    return false;
+  }
+  buf[head++] = b;
+  if (head == bufSize) {
+    head = 0;
+  }
+  count++;
+  return true;
+}
+
+int SafeStringDemuxChannel::available() {
+  if (demuxPtr) {
+    demuxPtr->poll();
+  }
+  return count;
+}
+
+int SafeStringDemuxChannel::peek() {
+  if (available() == 0) {
+    return -1;
+  }
+  size_t tail = (head >= count) ? (head - count) : (head + bufSize - count);
+  return buf[tail];
+}
+
+int SafeStringDemuxChannel::read() {
+  int b = peek();
+  if (b >= 0) {
+    count--;
+  }
+  return b;
+}
+
+size_t SafeStringDemuxChannel::write(uint8_t b) {
+  if (!demuxPtr) {
+    return 0;
+  }
+  return demuxPtr->inPtr->write(b);
+}
+
+size_t SafeStringDemuxChannel::write(const uint8_t *buffer, size_t size) {
+  if (!demuxPtr) {
+    return 0;
+  }
+  return demuxPtr->inPtr->write(buffer, size);
+}
+
+int SafeStringDemuxChannel::availableForWrite() {
+  if (!demuxPtr) {
+    return 0;
+  }
+  return demuxPtr->inPtr->availableForWrite();
+}
+
+void SafeStringDemuxChannel::flush() {
+  if (demuxPtr) {
+    demuxPtr->inPtr->flush();
+  }
+}
+
+SafeStringDemux::SafeStringDemux(Stream& in) {
+  inPtr = &in;
+  channels = NULL;
+  current = NULL;
+  state = DEMUX_WAIT_START;
+  frameLeft = 0;
+  dropped = 0;
+}
+
+void SafeStringDemux::addChannel(uint8_t channelId, SafeStringDemuxChannel& channel) {
+  if (channel.demuxPtr) {
+    return; // already added
+  }
+  channel.channelId = channelId;
+  channel.demuxPtr = this;
+  channel.nextChannel = channels;
+  channels = &channel;
+}
+
+size_t SafeStringDemux::getBytesDropped() {
+  size_t rtn = dropped;
+  dropped = 0;
+  return rtn;
+}
+
+void SafeStringDemux::poll() {
+  while (inPtr->available() > 0) {
+    int c = inPtr->read();
+    if (c < 0) {
+      return;
+    }
+    switch (state) {
+      case DEMUX_WAIT_START:
+        if (c == BUFFERED_MUX_FRAME_START) {
+          state = DEMUX_CHANNEL;
+        } else {
+          dropped++;
+        }
+        break;
+      case DEMUX_CHANNEL:
+        current = channels;
+        while (current && (current->channelId != c)) {
+          current = current->nextChannel;
+        }
+        state = DEMUX_LENGTH;
+        break;
+      case DEMUX_LENGTH:
+        frameLeft = (uint8_t)c;
+        state = (frameLeft == 0) ? DEMUX_WAIT_START : DEMUX_FRAME;
+        break;
+      default: // DEMUX_FRAME
+        if (!current) {
+          dropped++; // channel not added
+        } else {
+          current->put((uint8_t)c); // counts the dropped bytes if full
+        }
+        frameLeft--;
+        if (frameLeft == 0) {
+          state = DEMUX_WAIT_START;
+        }
+        break;
+    }
+  }
+}
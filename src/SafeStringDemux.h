@@ -0,0 +1,119 @@
+#ifndef SAFE_STRING_DEMUX_H
+#define SAFE_STRING_DEMUX_H
+/*
+  SafeStringDemux.h  separates the channels sent by BufferedOutput::addChannel( )
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+#ifdef __cplusplus
+#include <Arduino.h>
+#include "SafeString.h"
+#include "BufferedOutput.h" // for the frame format
+
+// handle namespace arduino
+#include "SafeStringNameSpaceStart.h"
+
+#define createSafeStringDemuxChannel(name, size) uint8_t name ## _DEMUX_BUFFER[(size)]; SafeStringDemuxChannel name(sizeof(name ## _DEMUX_BUFFER), name ## _DEMUX_BUFFER);
+
+class SafeStringDemux;
+
+/**************
+  **SafeStringDemux** reads the frames sent by a BufferedOutput with channels and routes each frame's bytes to its **SafeStringDemuxChannel**, see the detailed description.
+
+  Each SafeStringDemuxChannel is a Stream, so a SafeStringReader or BufferedInput can read from it as though it was a separate serial connection.<br>
+  Create each channel with the **createSafeStringDemuxChannel** macro to give it a buffer.
+  Reading from any channel reads all the available input and routes it to the channels.
+  If a channel's buffer is full, the rest of its frame is dropped, the other channels are not held up.<br>
+  Bytes received outside a frame, or for a channel that has not been added, are dropped.<br>
+  e.g.<br>
+<code>
+  SafeStringDemux demux(Serial);<br>
+  createSafeStringDemuxChannel(logIn, 64);<br>
+  createSafeStringDemuxChannel(telemetryIn, 64);<br>
+  createSafeStringReader(logReader, 80, '\\n');<br>
+  // in setup()<br>
+  demux.addChannel(0, logIn);<br>
+  demux.addChannel(1, telemetryIn);<br>
+  logReader.connect(logIn);<br>
+</code>
+****************************************************************************************/
+class SafeStringDemuxChannel : public Stream {
+  public:
+    /**
+      use createSafeStringDemuxChannel(name, size); instead
+    */
+    SafeStringDemuxChannel(size_t bufferSize, uint8_t buf[]);
+
+    /**
+      @return the number of bytes dropped because this channel's buffer was full, the count is reset to zero by this call
+    */
+    size_t getBytesDropped();
+
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+    /**
+      write( ) is not framed, the bytes are written directly to the SafeStringDemux's input stream
+    */
+    virtual size_t write(uint8_t b);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    using Print::write; // pull in write(str)
+    virtual int availableForWrite();
+    virtual void flush();
+
+  private:
+    friend class SafeStringDemux;
+    SafeStringDemuxChannel(const SafeStringDemuxChannel& other);
+    bool put(uint8_t b); // false if full
+    uint8_t *buf;
+    size_t bufSize;
+    size_t head; // next byte written here
+    size_t count;
+    size_t dropped;
+    uint8_t channelId;
+    SafeStringDemux *demuxPtr;
+    SafeStringDemuxChannel *nextChannel;
+};
+
+class SafeStringDemux {
+  public:
+    /**
+      @param in -- the Stream the frames are read from
+    */
+    explicit SafeStringDemux(Stream& in);
+
+    /**
+      Routes the frames for channelId to channel, call this in setup()
+      @param channelId -- the channel number returned by BufferedOutput::addChannel( ), 0 for the BufferedOutput the channels were added to
+      @param channel -- where the bytes are put
+    */
+    void addChannel(uint8_t channelId, SafeStringDemuxChannel& channel);
+
+    /**
+      Reads all the available input and routes it to the channels, called by each channel's available(), read() and peek()
+    */
+    void poll();
+
+    /**
+      @return the number of bytes dropped because they were not in a frame for a channel that has been added, the count is reset to zero by this call
+    */
+    size_t getBytesDropped();
+
+  private:
+    friend class SafeStringDemuxChannel;
+    SafeStringDemux(const SafeStringDemux& other);
+    Stream *inPtr;
+    SafeStringDemuxChannel *channels;
+    SafeStringDemuxChannel *current; // channel of the frame being read, NULL if not added
+    uint8_t state; // waiting for the frame start, channel, length or frame bytes
+    uint8_t frameLeft; // frame bytes still to be read
+    size_t dropped;
+};
+
+#include "SafeStringNameSpaceEnd.h"
+
+#endif  // __cplusplus
+#endif // SAFE_STRING_DEMUX_H
@@ -0,0 +1,236 @@
+/*
+  SafeStringGlob.cpp  a precompiled glob/wildcard pattern matcher
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+
+#include "SafeStringGlob.h"
+
+#include "SafeStringNameSpace.h"
+
+static const uint8_t GLOB_LITERAL = 0;
+static const uint8_t GLOB_ANY = 1;
+static const uint8_t GLOB_STAR = 2;
+static const uint8_t GLOB_CLASS = 3;
+static const uint8_t GLOB_NOT_CLASS = 4;
+
+SafeStringGlob::SafeStringGlob(char *patternBuf, size_t _maxPatternLen, SafeStringGlobToken *tokenBuf, size_t _maxTokens) {
+  pattern = patternBuf;
+  maxPatternLen = _maxPatternLen;
+  if (maxPatternLen > 255) {
+    maxPatternLen = 255; // class offsets are uint8_t
+  }
+  tokens = tokenBuf;
+  maxTokens = _maxTokens;
+  if (maxTokens > SAFE_STRING_GLOB_MAX_TOKENS) {
+    maxTokens = SAFE_STRING_GLOB_MAX_TOKENS;
+  }
+  if ((pattern == NULL) || (tokens == NULL)) {
+    maxPatternLen = 0;
+    maxTokens = 0;
+  } else {
+    pattern[0] = '\0';
+  }
+  tokenCount = 0;
+  starMask = 0;
+  ignoreCase = false;
+  valid = false;
+}
+
+bool SafeStringGlob::compileError(const __FlashStringHelper *msg) {
+  valid = false;
+  tokenCount = 0;
+  starMask = 0;
+#ifdef SSTRING_DEBUG
+  SafeString::Output.print(F("SafeStringGlob Error: ")); SafeString::Output.println(msg);
+#else
+  (void)(msg);
+#endif // SSTRING_DEBUG
+  return false;
+}
+
+bool SafeStringGlob::compile(const char *_pattern, bool _ignoreCase) {
+  if ((_pattern == NULL) || (maxTokens == 0)) {
+    return compileError(F("NULL pattern"));
+  }
+  size_t len = strlen(_pattern);
+  if (len > maxPatternLen) {
+    return compileError(F("pattern too long"));
+  }
+  memcpy(pattern, _pattern, len + 1);
+  return compileInternal(_ignoreCase);
+}
+
+bool SafeStringGlob::compile(SafeString &_pattern, bool _ignoreCase) {
+  return compile(_pattern.c_str(), _ignoreCase);
+}
+
+bool SafeStringGlob::compile(const __FlashStringHelper *_pattern, bool _ignoreCase) {
+  if ((_pattern == NULL) || (maxTokens == 0)) {
+    return compileError(F("NULL pattern"));
+  }
+  PGM_P p = reinterpret_cast<PGM_P>(_pattern);
+  size_t len = strlen_P(p);
+  if (len > maxPatternLen) {
+    return compileError(F("pattern too long"));
+  }
+  memcpy_P(pattern, p, len + 1);
+  return compileInternal(_ignoreCase);
+}
+
+bool SafeStringGlob::compileInternal(bool _ignoreCase) {
+  valid = false;
+  tokenCount = 0;
+  starMask = 0;
+  ignoreCase = _ignoreCase;
+  size_t i = 0;
+  while (pattern[i] != '\0') {
+    char c = pattern[i];
+    if ((c == '*') && (tokenCount > 0) && (tokens[tokenCount - 1].type == GLOB_STAR)) {
+      i++; // ** is the same as *
+      continue;
+    }
+    if (tokenCount >= maxTokens) {
+      return compileError(F("too many pattern elements"));
+    }
+    SafeStringGlobToken &token = tokens[tokenCount];
+    token.value = 0;
+    token.len = 0;
+    if (c == '*') {
+      token.type = GLOB_STAR;
+      starMask |= ((uint32_t)1) << tokenCount;
+      i++;
+    } else if (c == '?') {
+      token.type = GLOB_ANY;
+      i++;
+    } else if (c == '[') {
+      i++;
+      token.type = GLOB_CLASS;
+      if ((pattern[i] == '!') || (pattern[i] == '^')) {
+        token.type = GLOB_NOT_CLASS;
+        i++;
+      }
+      size_t start = i;
+      if (pattern[i] == ']') {
+        i++; // leading ] is part of the class
+      }
+      while ((pattern[i] != '\0') && (pattern[i] != ']')) {
+        if (pattern[i] == '\\') {
+          i++;
+          if (pattern[i] == '\0') {
+            break;
+          }
+        }
+        i++;
+      }
+      if (pattern[i] != ']') {
+        return compileError(F("missing ] in pattern"));
+      }
+      token.value = (uint8_t)start;
+      token.len = (uint8_t)(i - start);
+      i++; // skip ]
+    } else {
+      if (c == '\\') {
+        i++;
+        c = pattern[i];
+        if (c == '\0') {
+          return compileError(F("pattern ends with \\"));
+        }
+      }
+      token.type = GLOB_LITERAL;
+      token.value = (uint8_t)(ignoreCase ? tolower(c) : c);
+      i++;
+    }
+    tokenCount++;
+  }
+  valid = true;
+  return true;
+}
+
+bool SafeStringGlob::isValid() {
+  return valid;
+}
+
+bool SafeStringGlob::classMatches(const SafeStringGlobToken &token, char c) {
+  const char *p = pattern + token.value;
+  const char *end = p + token.len;
+  while (p < end) {
+    char lo = *p++;
+    if ((lo == '\\') && (p < end)) {
+      lo = *p++;
+    }
+    char hi = lo;
+    if (((p + 1) < end) && (*p == '-')) {
+      p++;
+      hi = *p++;
+      if ((hi == '\\') && (p < end)) {
+        hi = *p++;
+      }
+    }
+    if (((unsigned char)c >= (unsigned char)lo) && ((unsigned char)c <= (unsigned char)hi)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SafeStringGlob::tokenMatches(const SafeStringGlobToken &token, char c) {
+  switch (token.type) {
+    case GLOB_LITERAL:
+      return ((char)token.value == (ignoreCase ? (char)tolower(c) : c));
+    case GLOB_ANY:
+      return true;
+    case GLOB_CLASS:
+    case GLOB_NOT_CLASS: {
+        bool inClass = classMatches(token, c);
+        if ((!inClass) && ignoreCase) {
+          inClass = classMatches(token, (char)tolower(c)) || classMatches(token, (char)toupper(c));
+        }
+        return (token.type == GLOB_CLASS) ? inClass : !inClass;
+      }
+    default: // GLOB_STAR is handled by starMask
+      return false;
+  }
+}
+
+bool SafeStringGlob::match(SafeString &input) {
+  return match(input.c_str(), input.length());
+}
+
+bool SafeStringGlob::match(const SafeStringView &input) {
+  return match(input.data(), input.length());
+}
+
+bool SafeStringGlob::match(const char *input) {
+  if (input == NULL) {
+    return false;
+  }
+  return match(input, strlen(input));
+}
+
+// bit i of state set means the input so far matches the first i pattern elements
+// each input char moves every state past a matching element, * elements also keep their state
+// so the time taken is input length * pattern elements, with no backtracking
+bool SafeStringGlob::match(const char *input, size_t length) {
+  if ((!valid) || (input == NULL)) {
+    return false;
+  }
+  uint32_t state = 1;
+  state |= (state & starMask) << 1; // a leading * can match nothing
+  for (size_t i = 0; (i < length) && (state != 0); i++) {
+    char c = input[i];
+    uint32_t next = state & starMask;
+    uint32_t s = state & ~starMask;
+    for (uint8_t t = 0; s != 0; t++, s >>= 1) {
+      if ((s & 1) && (t < tokenCount) && tokenMatches(tokens[t], c)) {
+        next |= ((uint32_t)1) << (t + 1);
+      }
+    }
+    next |= (next & starMask) << 1; // runs of * are compiled to one, so one step is enough
+    state = next;
+  }
+  return ((state >> tokenCount) & 1);
+}
@@ -0,0 +1,120 @@
+#ifndef SAFE_STRING_GLOB_H
+#define SAFE_STRING_GLOB_H
+/*
+  SafeStringGlob.h  a precompiled glob/wildcard pattern matcher
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+#ifdef __cplusplus
+#include <Arduino.h>
+#include "SafeString.h"
+#include "SafeStringView.h"
+
+// handle namespace arduino
+#include "SafeStringNameSpaceStart.h"
+
+// the maximum number of pattern elements, e.g. a*b?[xyz] has 5, runs of * count as one
+// each element is one bit of the match state
+#define SAFE_STRING_GLOB_MAX_TOKENS 31
+
+/**
+  createSafeStringGlob( )
+  params
+    name - name of this SafeStringGlob variable (DO NOT use " " just use the plain name see the examples)
+    maxPatternLen - the maximum length of the pattern that can be compiled
+
+    example
+    createSafeStringGlob(topicFilter, 20);
+    This creates a SafeStringGlob topicFilter which can compile patterns upto 20 chars long, e.g. topicFilter.compile("sensor*.temp");
+*/
+#define createSafeStringGlob(name, maxPatternLen) \
+  char name ## _PATTERN_BUFFER[(maxPatternLen)+1]; \
+  SafeStringGlobToken name ## _TOKEN_BUFFER[((maxPatternLen) < SAFE_STRING_GLOB_MAX_TOKENS) ? ((maxPatternLen) + 1) : SAFE_STRING_GLOB_MAX_TOKENS]; \
+  SafeStringGlob name(name ## _PATTERN_BUFFER, (maxPatternLen), name ## _TOKEN_BUFFER, \
+                      ((maxPatternLen) < SAFE_STRING_GLOB_MAX_TOKENS) ? ((maxPatternLen) + 1) : SAFE_STRING_GLOB_MAX_TOKENS);
+
+// one compiled pattern element
+typedef struct {
+  uint8_t type;
+  uint8_t value; // the char for a literal, the offset of the class chars in the pattern for a class
+  uint8_t len;   // the number of class chars
+} SafeStringGlobToken;
+
+/**************
+  To create a SafeStringGlob use the macro **createSafeStringGlob**  see the detailed description.
+
+  <code>compile(pattern)</code> checks the pattern once and converts it to a table of elements.<br>
+  <code>match(input)</code> then tests the whole of the input against the pattern.<br>
+  The pattern is matched by tracking all the possible positions in the pattern at once, so match( ) takes time proportional to the input length,
+  with no recursion and no backtracking, however many * there are.<br>
+
+  Pattern syntax<br>
+  <code>*</code> matches any run of chars, including none<br>
+  <code>?</code> matches any one char<br>
+  <code>[abc]</code> matches one of a, b or c, <code>[a-z0-9]</code> matches one char in the ranges, <code>[!abc]</code> or <code>[^abc]</code> matches any one char except a, b or c.
+  A ] first in the class is included in the class, e.g. []abc]<br>
+  <code>\\</code> matches the next char literally, e.g. \\* matches *<br>
+  All other chars match themselves, or ignoring case if compiled with ignoreCase true.<br>
+
+  The pattern is copied, so it need not be kept after compile( ).<br>
+  compile( ) returns false, and nothing matches, if the pattern is too long, has more than SAFE_STRING_GLOB_MAX_TOKENS elements, an unclosed [ or a trailing \\.<br>
+  e.g.<br>
+<code>
+  createSafeStringGlob(filter, 20);<br>
+  filter.compile("temp_*_[0-9]?", true);<br>
+  if (filter.match(sfTopic)) { ... }<br>
+</code>
+****************************************************************************************/
+class SafeStringGlob {
+  public:
+    // use createSafeStringGlob(name, maxPatternLen); instead of calling this constructor
+    explicit SafeStringGlob(char *patternBuf, size_t maxPatternLen, SafeStringGlobToken *tokenBuf, size_t maxTokens);
+
+    /**
+      compile(pattern, ignoreCase)
+      checks the pattern and converts it to the table used by match( )
+      @param pattern - the glob pattern, it is copied
+      @param ignoreCase - default false, if true literals and classes match either case
+      @return true if the pattern is valid, else false and match( ) always returns false
+    */
+    bool compile(const char *pattern, bool ignoreCase = false);
+    bool compile(SafeString &pattern, bool ignoreCase = false);
+    bool compile(const __FlashStringHelper *pattern, bool ignoreCase = false);
+
+    /**
+      @return true if the last compile( ) succeeded
+    */
+    bool isValid();
+
+    /**
+      match(input)
+      @param input - the text to test, the whole of input must match the pattern
+      @return true if input matches the compiled pattern
+    */
+    bool match(SafeString &input);
+    bool match(const SafeStringView &input);
+    bool match(const char *input);
+    bool match(const char *input, size_t length);
+
+  private:
+    bool compileInternal(bool ignoreCase);
+    bool compileError(const __FlashStringHelper *msg);
+    bool tokenMatches(const SafeStringGlobToken &token, char c);
+    bool classMatches(const SafeStringGlobToken &token, char c);
+    char *pattern;
+    size_t maxPatternLen;
+    SafeStringGlobToken *tokens;
+    size_t maxTokens;
+    uint8_t tokenCount;
+    uint32_t starMask; // bit i set if token i is *
+    bool ignoreCase;
+    bool valid;
+};
+
+#include "SafeStringNameSpaceEnd.h"
+
+#endif  // __cplusplus
+#endif // SAFE_STRING_GLOB_H
@@ -0,0 +1,489 @@
+/*
+  SafeStringJsonTokenizer.cpp  an incremental, pull-style JSON tokenizer
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+
+#include "SafeStringJsonTokenizer.h"
+
+#include "SafeStringNameSpace.h"
+
+// tokenizer states
+// the structural states skip white space, the others are inside a key or value
+static const uint8_t JSON_ST_VALUE = 0;          // expecting a value, at top level or after : or ,
+static const uint8_t JSON_ST_VALUE_OR_END_ARRAY = 1; // just after [
+static const uint8_t JSON_ST_KEY_OR_END_OBJECT = 2;  // just after {
+static const uint8_t JSON_ST_KEY = 3;            // after , in an object
+static const uint8_t JSON_ST_COLON = 4;          // after a key
+static const uint8_t JSON_ST_COMMA_OR_END = 5;   // after a value inside an object or array
+static const uint8_t JSON_ST_STRING = 6;         // inside a key or string value
+static const uint8_t JSON_ST_ESCAPE = 7;         // after \ in a string
+static const uint8_t JSON_ST_UNICODE = 8;        // reading the XXXX of \uXXXX
+static const uint8_t JSON_ST_NUMBER = 9;
+static const uint8_t JSON_ST_LITERAL = 10;       // reading true false or null
+static const uint8_t JSON_ST_ERROR = 11;         // stays here until reset()
+
+// the parts of a number, -? (0 | [1-9][0-9]*) (.[0-9]+)? ([eE][+-]?[0-9]+)?
+static const uint8_t JSON_NUM_SIGN = 0;       // after the leading -
+static const uint8_t JSON_NUM_ZERO = 1;       // the integer part is 0, no more digits allowed
+static const uint8_t JSON_NUM_INT = 2;        // in the integer part
+static const uint8_t JSON_NUM_FRAC_START = 3; // after the .
+static const uint8_t JSON_NUM_FRAC = 4;       // in the fraction digits
+static const uint8_t JSON_NUM_EXP_START = 5;  // after the e or E
+static const uint8_t JSON_NUM_EXP_SIGN = 6;   // after the exponent's + or -
+static const uint8_t JSON_NUM_EXP = 7;        // in the exponent digits
+
+// stackBuf must be at least (maxDepth+7)/8 bytes long
+SafeStringJsonTokenizer::SafeStringJsonTokenizer(SafeString& sfValue, uint8_t *stackBuf, size_t _maxDepth) {
+  sfValuePtr = &sfValue;
+  stack = stackBuf;
+  maxDepth = _maxDepth;
+  if (stack == NULL) {
+    maxDepth = 0;
+  }
+  literal = NULL;
+  literalEvent = JSON_NONE;
+  isKey = false;
+  pendingChar = '\0';
+  reset();
+}
+
+// private and so never called
+SafeStringJsonTokenizer::SafeStringJsonTokenizer(const SafeStringJsonTokenizer& other) {
+  (void)(other); // to suppress unused warning
+}
+
+void SafeStringJsonTokenizer::reset() {
+  depth = 0;
+  state = JSON_ST_VALUE;
+  havePendingChar = false;
+  hexCount = 0;
+  codeUnit = 0;
+  highSurrogate = 0;
+  numberPart = JSON_NUM_SIGN;
+  sfValuePtr->clear();
+}
+
+SafeString& SafeStringJsonTokenizer::getValue() {
+  return *sfValuePtr;
+}
+
+size_t SafeStringJsonTokenizer::getDepth() {
+  return depth;
+}
+
+bool SafeStringJsonTokenizer::isInArray() {
+  if (depth == 0) {
+    return false;
+  }
+  size_t top = depth - 1;
+  return ((stack[top >> 3] & (1 << (top & 7))) == 0);
+}
+
+SafeStringJsonEvent SafeStringJsonTokenizer::next(const char c) {
+  if (havePendingChar) {
+    havePendingChar = false;
+    SafeStringJsonEvent ev = processChar(pendingChar);
+    if (ev != JSON_NONE) {
+      // save c for next call
+      pendingChar = c;
+      havePendingChar = true;
+      return ev;
+    }
+  }
+  return processChar(c);
+}
+
+SafeStringJsonEvent SafeStringJsonTokenizer::next(SafeString& input) {
+  SafeStringJsonEvent ev = JSON_NONE;
+  if (havePendingChar) {
+    havePendingChar = false;
+    ev = processChar(pendingChar);
+    if (ev != JSON_NONE) {
+      return ev;
+    }
+  }
+  const char *p = input.c_str();
+  size_t len = input.length();
+  size_t i = 0;
+  while (i < len) {
+    ev = processChar(p[i++]); // the char that ends a number is kept in pendingChar
+    if (ev != JSON_NONE) {
+      break;
+    }
+  }
+  input.removeBefore(i);
+  return ev;
+}
+
+SafeStringJsonEvent SafeStringJsonTokenizer::next(Stream& input) {
+  SafeStringJsonEvent ev = JSON_NONE;
+  if (havePendingChar) {
+    havePendingChar = false;
+    ev = processChar(pendingChar);
+    if (ev != JSON_NONE) {
+      return ev;
+    }
+  }
+  while (input.available()) {
+    int c = input.read();
+    if (c < 0) {
+      break;
+    }
+    ev = processChar((char)c);
+    if (ev != JSON_NONE) {
+      break;
+    }
+  }
+  return ev;
+}
+
+SafeStringJsonEvent SafeStringJsonTokenizer::error(const __FlashStringHelper *msg) {
+  state = JSON_ST_ERROR;
+#ifdef SSTRING_DEBUG
+  SafeString::Output.print(F("SafeStringJsonTokenizer Error: ")); SafeString::Output.println(msg);
+#else
+  (void)(msg);
+#endif // SSTRING_DEBUG
+  return JSON_ERROR;
+}
+
+// moves numberPart on for the next char of the number, c is a digit . e E + or -
+// returns false if c is not valid here, e.g. 01 1.2.3 1e or --1
+bool SafeStringJsonTokenizer::nextNumberPart(char c) {
+  bool digit = isdigit(c);
+  bool exp = ((c == 'e') || (c == 'E'));
+  switch (numberPart) {
+    case JSON_NUM_SIGN:
+      if (digit) {
+        numberPart = (c == '0') ? JSON_NUM_ZERO : JSON_NUM_INT;
+        return true;
+      }
+      return false;
+    case JSON_NUM_ZERO:
+    case JSON_NUM_INT:
+      if (digit && (numberPart == JSON_NUM_INT)) {
+        return true;
+      }
+      if (c == '.') {
+        numberPart = JSON_NUM_FRAC_START;
+        return true;
+      }
+      if (exp) {
+        numberPart = JSON_NUM_EXP_START;
+        return true;
+      }
+      return false; // leading 0 or a sign
+    case JSON_NUM_FRAC_START:
+    case JSON_NUM_FRAC:
+      if (digit) {
+        numberPart = JSON_NUM_FRAC;
+        return true;
+      }
+      if (exp && (numberPart == JSON_NUM_FRAC)) {
+        numberPart = JSON_NUM_EXP_START;
+        return true;
+      }
+      return false;
+    case JSON_NUM_EXP_START:
+      if ((c == '+') || (c == '-')) {
+        numberPart = JSON_NUM_EXP_SIGN;
+        return true;
+      }
+      // fall through
+    case JSON_NUM_EXP_SIGN:
+    case JSON_NUM_EXP:
+      if (digit) {
+        numberPart = JSON_NUM_EXP;
+        return true;
+      }
+      return false;
+    default:
+      return false;
+  }
+}
+
+// returns false if sfValue is full
+bool SafeStringJsonTokenizer::addToValue(char c) {
+  if (sfValuePtr->isFull()) {
+    return false;
+  }
+  sfValuePtr->concat(c);
+  return true;
+}
+
+// all or nothing, returns false if the encoding will not fit
+bool SafeStringJsonTokenizer::addUTF8(unsigned long cp) {
+  char buf[5];
+  size_t n = 0;
+  if (cp < 0x80) {
+    buf[n++] = (char)cp;
+  } else if (cp < 0x800) {
+    buf[n++] = (char)(0xC0 | (cp >> 6));
+    buf[n++] = (char)(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    buf[n++] = (char)(0xE0 | (cp >> 12));
+    buf[n++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    buf[n++] = (char)(0x80 | (cp & 0x3F));
+  } else {
+    buf[n++] = (char)(0xF0 | (cp >> 18));
+    buf[n++] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    buf[n++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    buf[n++] = (char)(0x80 | (cp & 0x3F));
+  }
+  buf[n] = '\0';
+  if ((cp == 0) || (sfValuePtr->availableForWrite() < (int)n)) {
+    return false; // \u0000 cannot be held in a SafeString
+  }
+  sfValuePtr->concat(buf);
+  return true;
+}
+
+SafeStringJsonEvent SafeStringJsonTokenizer::push(bool isObject) {
+  if (depth >= maxDepth) {
+    return error(F("nesting deeper than maxDepth"));
+  }
+  if (isObject) {
+    stack[depth >> 3] |= (1 << (depth & 7));
+    state = JSON_ST_KEY_OR_END_OBJECT;
+  } else {
+    stack[depth >> 3] &= ~(1 << (depth & 7));
+    state = JSON_ST_VALUE_OR_END_ARRAY;
+  }
+  depth++;
+  return (isObject ? JSON_START_OBJECT : JSON_START_ARRAY);
+}
+
+SafeStringJsonEvent SafeStringJsonTokenizer::pop(bool isObject) {
+  if ((depth == 0) || (isInArray() == isObject)) {
+    return error(isObject ? F("unexpected }") : F("unexpected ]"));
+  }
+  depth--;
+  return afterValue(isObject ? JSON_END_OBJECT : JSON_END_ARRAY);
+}
+
+SafeStringJsonEvent SafeStringJsonTokenizer::afterValue(SafeStringJsonEvent ev) {
+  state = (depth ? JSON_ST_COMMA_OR_END : JSON_ST_VALUE);
+  return ev;
+}
+
+SafeStringJsonEvent SafeStringJsonTokenizer::processChar(char c) {
+  switch (state) {
+    case JSON_ST_STRING:
+      if (c == '"') {
+        if (highSurrogate && (!addUTF8(0xFFFD))) {
+          return error(F("key or value too long"));
+        }
+        highSurrogate = 0;
+        if (isKey) {
+          state = JSON_ST_COLON;
+          return JSON_KEY;
+        }
+        return afterValue(JSON_STRING);
+      }
+      if (c == '\\') {
+        state = JSON_ST_ESCAPE;
+        return JSON_NONE;
+      }
+      if (((uint8_t)c) < 0x20) {
+        return error(F("control char in string"));
+      }
+      if (highSurrogate) {
+        highSurrogate = 0;
+        if (!addUTF8(0xFFFD)) {
+          return error(F("key or value too long"));
+        }
+      }
+      if (!addToValue(c)) {
+        return error(F("key or value too long"));
+      }
+      return JSON_NONE;
+
+    case JSON_ST_ESCAPE:
+      state = JSON_ST_STRING;
+      if (c == 'u') {
+        hexCount = 0;
+        codeUnit = 0;
+        state = JSON_ST_UNICODE;
+        return JSON_NONE;
+      }
+      if (highSurrogate) {
+        highSurrogate = 0;
+        if (!addUTF8(0xFFFD)) {
+          return error(F("key or value too long"));
+        }
+      }
+      switch (c) {
+        case '"': case '\\': case '/': break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'n': c = '\n'; break;
+        case 'r': c = '\r'; break;
+        case 't': c = '\t'; break;
+        default:
+          return error(F("invalid escape in string"));
+      }
+      if (!addToValue(c)) {
+        return error(F("key or value too long"));
+      }
+      return JSON_NONE;
+
+    case JSON_ST_UNICODE: {
+        if (!isxdigit(c)) {
+          return error(F("invalid \\u escape"));
+        }
+        codeUnit = (codeUnit << 4) | (isdigit(c) ? (c - '0') : ((c | 0x20) - 'a' + 10));
+        if (++hexCount < 4) {
+          return JSON_NONE;
+        }
+        state = JSON_ST_STRING;
+        unsigned long cp = codeUnit;
+        if ((codeUnit >= 0xD800) && (codeUnit <= 0xDBFF)) {
+          // high surrogate, wait for the low one
+          if (highSurrogate && (!addUTF8(0xFFFD))) {
+            return error(F("key or value too long"));
+          }
+          highSurrogate = codeUnit;
+          return JSON_NONE;
+        }
+        if ((codeUnit >= 0xDC00) && (codeUnit <= 0xDFFF)) {
+          cp = 0xFFFD; // lone low surrogate
+          if (highSurrogate) {
+            cp = 0x10000UL + (((unsigned long)(highSurrogate - 0xD800)) << 10) + (codeUnit - 0xDC00);
+          }
+        } else if (highSurrogate && (!addUTF8(0xFFFD))) {
+          return error(F("key or value too long"));
+        }
+        highSurrogate = 0;
+        if (!addUTF8(cp)) {
+          return error(F("key or value too long or \\u0000"));
+        }
+        return JSON_NONE;
+      }
+
+    case JSON_ST_NUMBER:
+      if (isdigit(c) || (c == '.') || (c == 'e') || (c == 'E') || (c == '+') || (c == '-')) {
+        if (!nextNumberPart(c)) {
+          return error(F("invalid number"));
+        }
+        if (!addToValue(c)) {
+          return error(F("number too long"));
+        }
+        return JSON_NONE;
+      }
+      // else this char ends the number, keep it to be processed next
+      pendingChar = c;
+      havePendingChar = true;
+      if ((numberPart != JSON_NUM_ZERO) && (numberPart != JSON_NUM_INT) &&
+          (numberPart != JSON_NUM_FRAC) && (numberPart != JSON_NUM_EXP)) {
+        return error(F("invalid number")); // e.g. - 1. or 1e+
+      }
+      return afterValue(JSON_NUMBER);
+
+    case JSON_ST_LITERAL:
+      if (c != *literal) {
+        return error(F("invalid literal"));
+      }
+      literal++;
+      if (*literal == '\0') {
+        return afterValue(literalEvent);
+      }
+      return JSON_NONE;
+
+    case JSON_ST_ERROR:
+      return JSON_ERROR;
+
+    default:
+      break; // structural states handled below
+  }
+
+  if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n')) {
+    return JSON_NONE;
+  }
+
+  switch (state) {
+    case JSON_ST_KEY_OR_END_OBJECT:
+      if (c == '}') {
+        return pop(true);
+      }
+    // fall through
+    case JSON_ST_KEY:
+      if (c != '"') {
+        return error(F("expected key"));
+      }
+      sfValuePtr->clear();
+      isKey = true;
+      highSurrogate = 0;
+      state = JSON_ST_STRING;
+      return JSON_NONE;
+
+    case JSON_ST_COLON:
+      if (c != ':') {
+        return error(F("expected :"));
+      }
+      state = JSON_ST_VALUE;
+      return JSON_NONE;
+
+    case JSON_ST_COMMA_OR_END:
+      if (c == ',') {
+        state = (isInArray() ? JSON_ST_VALUE : JSON_ST_KEY);
+        return JSON_NONE;
+      }
+      if (c == '}') {
+        return pop(true);
+      }
+      if (c == ']') {
+        return pop(false);
+      }
+      return error(F("expected , or end of object/array"));
+
+    case JSON_ST_VALUE_OR_END_ARRAY:
+      if (c == ']') {
+        return pop(false);
+      }
+      break; // to start value below
+
+    default:
+      break; // JSON_ST_VALUE
+  }
+
+  // start a new value
+  sfValuePtr->clear();
+  switch (c) {
+    case '{':
+      return push(true);
+    case '[':
+      return push(false);
+    case '"':
+      isKey = false;
+      highSurrogate = 0;
+      state = JSON_ST_STRING;
+      return JSON_NONE;
+    case 't':
+      literal = "rue";
+      literalEvent = JSON_TRUE;
+      state = JSON_ST_LITERAL;
+      return JSON_NONE;
+    case 'f':
+      literal = "alse";
+      literalEvent = JSON_FALSE;
+      state = JSON_ST_LITERAL;
+      return JSON_NONE;
+    case 'n':
+      literal = "ull";
+      literalEvent = JSON_NULL;
+      state = JSON_ST_LITERAL;
+      return JSON_NONE;
+    default:
+      if ((c == '-') || isdigit(c)) {
+        addToValue(c); // just cleared so always room
+        numberPart = (c == '-') ? JSON_NUM_SIGN : ((c == '0') ? JSON_NUM_ZERO : JSON_NUM_INT);
+        state = JSON_ST_NUMBER;
+        return JSON_NONE;
+      }
+      return error(F("expected value"));
+  }
+}
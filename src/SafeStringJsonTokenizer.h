@@ -0,0 +1,154 @@
+#ifndef SAFE_STRING_JSON_TOKENIZER_H
+#define SAFE_STRING_JSON_TOKENIZER_H
+/*
+  SafeStringJsonTokenizer.h  an incremental, pull-style JSON tokenizer
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+#ifdef __cplusplus
+#include <Arduino.h>
+#include "SafeString.h"
+// SafeString.h includes defines for Stream
+
+// handle namespace arduino
+#include "SafeStringNameSpaceStart.h"
+
+/**
+  createSafeStringJsonTokenizer( )
+  params
+    name - name of this SafeStringJsonTokenizer variable (DO NOT use " " just use the plain name see the examples)
+    valueSize - the maximum length of any key, string value or number text that can be returned.
+           Longer keys/values are not truncated, they stop the tokenizer with a JSON_ERROR
+    maxDepth - the maximum nesting of objects and arrays, each level uses 1 bit of RAM
+
+    example
+    createSafeStringJsonTokenizer(json, 20, 8);
+    This creates a SafeStringJsonTokenizer json which can return keys and values upto 20 chars long nested upto 8 levels deep
+*/
+#define createSafeStringJsonTokenizer(name, valueSize, maxDepth) \
+  char name ## _VALUE_BUFFER[(valueSize)+1]; \
+  uint8_t name ## _STACK_BUFFER[((maxDepth)+7)/8]; \
+  SafeString name ## _SF_VALUE((valueSize)+1, name ## _VALUE_BUFFER, "", #name "_Value"); \
+  SafeStringJsonTokenizer name(name ## _SF_VALUE, name ## _STACK_BUFFER, (maxDepth));
+
+typedef enum { JSON_NONE, JSON_START_OBJECT, JSON_END_OBJECT, JSON_START_ARRAY, JSON_END_ARRAY,
+               JSON_KEY, JSON_STRING, JSON_NUMBER, JSON_TRUE, JSON_FALSE, JSON_NULL, JSON_ERROR
+             } SafeStringJsonEvent;
+
+/**************
+  To create a SafeStringJsonTokenizer use the macro **createSafeStringJsonTokenizer**  see the detailed description.
+
+  The SafeStringJsonTokenizer reads JSON text a chunk at a time and returns one event for each key, value and start/end of object or array.<br>
+  The whole document never needs to be held in memory. Only the current key or value, upto <i>valueSize</i> chars, and one bit per nesting level are kept.<br>
+  The chunks can be split anywhere, even in the middle of a key, string or number.<br>
+
+  Each call to <code>next(input)</code> consumes chars from the input until the next event is found and returns that event.<br>
+  <code>JSON_NONE</code> is returned when the input has been used up and more input is needed.<br>
+  For <code>JSON_KEY, JSON_STRING</code> and <code>JSON_NUMBER</code> the text is available from <code>getValue()</code>. String escapes, including \\uXXXX, are decoded to UTF-8.<br>
+  Numbers are returned as text so use <code>getValue().toLong( )</code> or <code>getValue().toDouble( )</code> to convert them.
+  They must follow the JSON number format, so e.g. 01, +1, 1. or 1e return <code>JSON_ERROR</code>.<br>
+  On a syntax error, a key/value longer than <i>valueSize</i> or nesting deeper than <i>maxDepth</i>, <code>JSON_ERROR</code> is returned and is returned again on every call until <code>reset()</code> is called.<br>
+  After a top level value completes, the tokenizer is ready for the next document, so newline delimited JSON can be read continuously.<br>
+  e.g.<br>
+<code>
+  createSafeStringJsonTokenizer(json, 20, 8);<br>
+  cSF(sfInput, 32);<br>
+  void loop() {<br>
+  &nbsp;&nbsp;sfInput.read(Serial); // read what is available<br>
+  &nbsp;&nbsp;SafeStringJsonEvent ev;<br>
+  &nbsp;&nbsp;while ((ev = json.next(sfInput)) != JSON_NONE) {<br>
+  &nbsp;&nbsp;&nbsp;&nbsp;if (ev == JSON_KEY) { .. json.getValue() is the key .. }<br>
+  &nbsp;&nbsp;}<br>
+  }<br>
+</code>
+****************************************************************************************/
+class SafeStringJsonTokenizer {
+  public:
+    // use createSafeStringJsonTokenizer(name, valueSize, maxDepth); instead of calling this constructor
+    // stackBuf must be at least (maxDepth+7)/8 bytes long
+    explicit SafeStringJsonTokenizer(SafeString& sfValue, uint8_t *stackBuf, size_t maxDepth);
+
+    /**
+      next(SafeString& input)
+      consumes chars from the front of input until the next event is found.
+      The chars consumed are removed from input.
+      @param input - the chunk of JSON text to process, can be a SafeStringReader token or the result of SafeString::read(Stream)
+      @return the next event or JSON_NONE if all of input has been consumed and more input is needed
+    */
+    SafeStringJsonEvent next(SafeString& input);
+
+    /**
+      next(Stream& input)
+      reads the chars available from the Stream until the next event is found.
+      Never blocks, returns JSON_NONE when there are no more chars available.
+      @param input - the stream to read the JSON text from
+      @return the next event or JSON_NONE if no more chars are available
+    */
+    SafeStringJsonEvent next(Stream& input);
+
+    /**
+      next(const char c)
+      process a single char. If c completes a number, e.g. the ] in [12], the JSON_NUMBER is returned and c is saved and processed
+      by the following call, so a call to next( ) with any input, even next(SafeString&) with an empty input, will return its event.
+      @param c - the next char of JSON text
+      @return the event completed by this char, if any, else JSON_NONE
+    */
+    SafeStringJsonEvent next(const char c);
+
+    /**
+      getValue()
+      @return the text of the last JSON_KEY, JSON_STRING or JSON_NUMBER event. Cleared at the start of each key or value.
+    */
+    SafeString& getValue();
+
+    /**
+      getDepth()
+      @return the current nesting depth, 0 at the top level
+    */
+    size_t getDepth();
+
+    /**
+      isInArray()
+      @return true if the current value is inside an array, false if at the top level or inside an object
+    */
+    bool isInArray();
+
+    /**
+      reset()
+      clears any error and returns the tokenizer to the top level, ready for a new document
+    */
+    void reset();
+
+  private:
+    SafeStringJsonTokenizer(const SafeStringJsonTokenizer& other);
+    SafeStringJsonEvent processChar(char c); // sets reprocessChar if c needs to be processed again
+    SafeStringJsonEvent push(bool isObject);
+    SafeStringJsonEvent pop(bool isObject);
+    SafeStringJsonEvent afterValue(SafeStringJsonEvent ev);
+    SafeStringJsonEvent error(const __FlashStringHelper *msg);
+    bool addToValue(char c);
+    bool nextNumberPart(char c); // false if c is not valid at this point in the number
+    bool addUTF8(unsigned long codePoint);
+    SafeString* sfValuePtr;
+    uint8_t *stack; // 1 bit per depth, 1 for object 0 for array
+    size_t maxDepth;
+    size_t depth;
+    uint8_t state;
+    bool isKey; // true if current string is a key
+    bool havePendingChar; // true if pendingChar to be reprocessed
+    char pendingChar;
+    const char *literal; // rest of true/false/null still to be matched
+    SafeStringJsonEvent literalEvent;
+    uint8_t hexCount; // number of \uXXXX hex digits read
+    unsigned int codeUnit; // \uXXXX being read
+    unsigned int highSurrogate; // non-zero if waiting for the low surrogate
+    uint8_t numberPart; // which part of a number is being read
+};
+
+#include "SafeStringNameSpaceEnd.h"
+
+#endif  // __cplusplus
+#endif // SAFE_STRING_JSON_TOKENIZER_H
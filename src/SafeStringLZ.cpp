@@ -0,0 +1,267 @@
+/*
+  SafeStringLZ.cpp  a small window LZ compressor and decompressor for slow serial links
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+
+#include "SafeStringLZ.h"
+
+#include "SafeStringNameSpace.h"
+
+SafeStringLZOutput::SafeStringLZOutput(Stream& out) {
+  outPtr = &out;
+  reset();
+}
+
+void SafeStringLZOutput::reset() {
+  memset(window, 0, sizeof(window));
+  winPos = 0;
+  winCount = 0;
+  lookLen = 0;
+  literalLen = 0;
+  bytesIn = 0;
+  bytesOut = 0;
+}
+
+unsigned long SafeStringLZOutput::getBytesIn() {
+  return bytesIn;
+}
+
+unsigned long SafeStringLZOutput::getBytesOut() {
+  return bytesOut;
+}
+
+size_t SafeStringLZOutput::write(uint8_t b) {
+  bytesIn++;
+  look[lookLen++] = b;
+  if (lookLen == SAFE_STRING_LZ_MAX_MATCH) {
+    encodeOne();
+  }
+  if (b == '\n') {
+    flushPoint();
+  }
+  return 1;
+}
+
+size_t SafeStringLZOutput::write(const uint8_t *buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    write(buffer[i]);
+  }
+  return size;
+}
+
+// the worst case is every byte waiting is sent as a literal
+int SafeStringLZOutput::availableForWrite() {
+  int avail = outPtr->availableForWrite() - (literalLen + lookLen + 2);
+  return (avail < 0) ? 0 : avail;
+}
+
+void SafeStringLZOutput::flushPoint() {
+  while (lookLen > 0) {
+    encodeOne();
+  }
+  writeLiterals();
+}
+
+void SafeStringLZOutput::flush() {
+  flushPoint();
+  outPtr->flush();
+}
+
+int SafeStringLZOutput::available() {
+  return outPtr->available();
+}
+
+int SafeStringLZOutput::read() {
+  return outPtr->read();
+}
+
+int SafeStringLZOutput::peek() {
+  return outPtr->peek();
+}
+
+// a match can run on from the window into look[] e.g. distance 1 repeats the last byte
+uint8_t SafeStringLZOutput::matchByte(size_t distance, size_t i) {
+  if (i >= distance) {
+    return look[i - distance];
+  }
+  size_t pos = winPos + SAFE_STRING_LZ_WINDOW - distance + i;
+  if (pos >= SAFE_STRING_LZ_WINDOW) {
+    pos -= SAFE_STRING_LZ_WINDOW;
+  }
+  return window[pos];
+}
+
+// memchr finds each window byte that matches the first byte, then the match is extended
+// stops at the first match of all of look[]
+size_t SafeStringLZOutput::findMatch(size_t &distance) {
+  size_t best = 0;
+  const uint8_t *p = window;
+  const uint8_t *end = window + winCount;
+  while (p < end) {
+    p = (const uint8_t *)memchr(p, look[0], end - p);
+    if (p == NULL) {
+      break;
+    }
+    size_t pos = p - window;
+    size_t d = (pos < winPos) ? (winPos - pos) : (winPos + SAFE_STRING_LZ_WINDOW - pos);
+    size_t len = 1;
+    while ((len < lookLen) && (matchByte(d, len) == look[len])) {
+      len++;
+    }
+    if (len > best) {
+      best = len;
+      distance = d;
+      if (best == lookLen) {
+        break;
+      }
+    }
+    p++;
+  }
+  return best;
+}
+
+void SafeStringLZOutput::encodeOne() {
+  size_t distance = 0;
+  size_t len = findMatch(distance);
+  if (len >= SAFE_STRING_LZ_MIN_MATCH) {
+    writeLiterals();
+    size_t offset = distance - 1;
+    outPtr->write((uint8_t)(0x80 | ((len - SAFE_STRING_LZ_MIN_MATCH) << 4) | (offset >> 8)));
+    outPtr->write((uint8_t)(offset & 0xFF));
+    bytesOut += 2;
+  } else {
+    len = 1;
+    literals[literalLen++] = look[0];
+    if (literalLen == SAFE_STRING_LZ_MAX_LITERALS) {
+      writeLiterals();
+    }
+  }
+  addToWindow(look, len);
+  lookLen -= len;
+  memmove(look, look + len, lookLen);
+}
+
+void SafeStringLZOutput::writeLiterals() {
+  if (literalLen == 0) {
+    return;
+  }
+  outPtr->write((uint8_t)(literalLen - 1));
+  outPtr->write(literals, literalLen);
+  bytesOut += literalLen + 1;
+  literalLen = 0;
+}
+
+void SafeStringLZOutput::addToWindow(const uint8_t *bytes, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    window[winPos++] = bytes[i];
+    if (winPos == SAFE_STRING_LZ_WINDOW) {
+      winPos = 0;
+    }
+  }
+  winCount = ((winCount + len) > SAFE_STRING_LZ_WINDOW) ? SAFE_STRING_LZ_WINDOW : (winCount + len);
+}
+
+SafeStringLZInput::SafeStringLZInput(Stream& in) {
+  inPtr = &in;
+  reset();
+}
+
+void SafeStringLZInput::reset() {
+  memset(window, 0, sizeof(window));
+  winPos = 0;
+  literalsLeft = 0;
+  matchLeft = 0;
+  matchDistance = 1;
+  matchToken = -1;
+  nextByte = -1;
+}
+
+// only reads from the input stream when it has a byte available, so never blocks
+bool SafeStringLZInput::nextOut() {
+  if (nextByte >= 0) {
+    return true;
+  }
+  while (true) {
+    if (matchLeft) {
+      size_t pos = winPos + SAFE_STRING_LZ_WINDOW - matchDistance;
+      if (pos >= SAFE_STRING_LZ_WINDOW) {
+        pos -= SAFE_STRING_LZ_WINDOW;
+      }
+      matchLeft--;
+      nextByte = window[pos];
+      break;
+    }
+    if (inPtr->available() <= 0) {
+      return false;
+    }
+    int c = inPtr->read();
+    if (c < 0) {
+      return false;
+    }
+    if (literalsLeft) {
+      literalsLeft--;
+      nextByte = c;
+      break;
+    }
+    if (matchToken >= 0) {
+      matchDistance = ((((uint16_t)matchToken) & 0x0F) << 8) + c + 1;
+      if (matchDistance > SAFE_STRING_LZ_WINDOW) {
+        matchDistance = SAFE_STRING_LZ_WINDOW; // the sender's window is too large
+      }
+      matchLeft = ((matchToken >> 4) & 0x07) + SAFE_STRING_LZ_MIN_MATCH;
+      matchToken = -1;
+    } else if (c < 0x80) {
+      literalsLeft = c + 1;
+    } else {
+      matchToken = c;
+    }
+  }
+  window[winPos++] = (uint8_t)nextByte;
+  if (winPos == SAFE_STRING_LZ_WINDOW) {
+    winPos = 0;
+  }
+  return true;
+}
+
+int SafeStringLZInput::available() {
+  if (!nextOut()) {
+    return 0;
+  }
+  return 1 + matchLeft;
+}
+
+int SafeStringLZInput::read() {
+  if (!nextOut()) {
+    return -1;
+  }
+  int rtn = nextByte;
+  nextByte = -1;
+  return rtn;
+}
+
+int SafeStringLZInput::peek() {
+  if (!nextOut()) {
+    return -1;
+  }
+  return nextByte;
+}
+
+size_t SafeStringLZInput::write(uint8_t b) {
+  return inPtr->write(b);
+}
+
+size_t SafeStringLZInput::write(const uint8_t *buffer, size_t size) {
+  return inPtr->write(buffer, size);
+}
+
+int SafeStringLZInput::availableForWrite() {
+  return inPtr->availableForWrite();
+}
+
+void SafeStringLZInput::flush() {
+  inPtr->flush();
+}
@@ -0,0 +1,170 @@
+#ifndef SAFE_STRING_LZ_H
+#define SAFE_STRING_LZ_H
+/*
+  SafeStringLZ.h  a small window LZ compressor and decompressor for slow serial links
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+#ifdef __cplusplus
+#include <Arduino.h>
+#include "SafeString.h"
+
+// the window of previous output that matches can refer to, the RAM used by each SafeStringLZOutput and SafeStringLZInput
+// the decompressor's window must be at least as large as the compressor's, max 4096
+#ifndef SAFE_STRING_LZ_WINDOW
+#if defined(ARDUINO_ARCH_AVR)
+#define SAFE_STRING_LZ_WINDOW 256
+#else
+#define SAFE_STRING_LZ_WINDOW 1024
+#endif
+#endif
+#if (SAFE_STRING_LZ_WINDOW > 4096) || (SAFE_STRING_LZ_WINDOW < 16)
+#error SAFE_STRING_LZ_WINDOW must be 16 to 4096
+#endif
+// literal bytes collected by the compressor before they are sent, 1 to 128
+#ifndef SAFE_STRING_LZ_MAX_LITERALS
+#define SAFE_STRING_LZ_MAX_LITERALS 32
+#endif
+#define SAFE_STRING_LZ_MIN_MATCH 3
+#define SAFE_STRING_LZ_MAX_MATCH 10
+
+// handle namespace arduino
+#include "SafeStringNameSpaceStart.h"
+
+/**************
+  **SafeStringLZOutput** compresses the bytes written to it and writes them to another Stream, see the detailed description.
+  **SafeStringLZInput** reads the compressed bytes from a Stream and returns the original bytes.
+
+  Use these to send more text over a slow link, e.g. a 9600 baud radio, repetitive text logs are typically reduced to about half.<br>
+  Connect a BufferedOutput to a SafeStringLZOutput and read from a SafeStringLZInput with a BufferedInput or SafeStringReader on the other end.<br>
+  Each side uses a fixed SAFE_STRING_LZ_WINDOW bytes of RAM, 256 on AVR boards, 1024 on others.
+  The receiving side's SAFE_STRING_LZ_WINDOW must be at least as large as the sending side's.<br>
+
+  Each \\n is a flush point, the compressor sends everything written upto and including the \\n, so the receiver gets each line without waiting for more output.
+  Call <code>flushPoint()</code> to send partial lines. The window is kept across flush points so later lines still match earlier ones.<br>
+
+  The compressed format is a sequence of tokens<br>
+  0x00 to 0x7F -- T, followed by T+1 literal bytes<br>
+  0x80 to 0xFF -- T, followed by one byte B, copy ((T>>4)&7)+3 bytes from ((T&0x0F)<<8 | B)+1 bytes back in the output<br>
+
+  There is no error recovery, so the link should be reliable and both sides started together. <code>reset()</code> both sides to start again.<br>
+  e.g. sender<br>
+<code>
+  SafeStringLZOutput lzOut(Serial);<br>
+  createBufferedOutput(output, 80, DROP_IF_FULL);<br>
+  // in setup()<br>
+  output.connect(lzOut); // output.print( ) is compressed and sent to Serial<br>
+</code>
+  receiver<br>
+<code>
+  SafeStringLZInput lzIn(Serial);<br>
+  createSafeStringReader(sfReader, 80, '\\n');<br>
+  // in setup()<br>
+  sfReader.connect(lzIn);<br>
+</code>
+****************************************************************************************/
+class SafeStringLZOutput : public Stream {
+  public:
+    /**
+      @param out -- the Stream the compressed bytes are written to, also used for available(), read() and peek()
+    */
+    explicit SafeStringLZOutput(Stream& out);
+
+    /**
+      Sends all the bytes written so far, called for each \\n and by flush().
+    */
+    void flushPoint();
+    /**
+      Drops any unsent bytes and clears the window. The SafeStringLZInput must also be reset()
+    */
+    void reset();
+    /**
+      @return the number of bytes written to this compressor
+    */
+    unsigned long getBytesIn();
+    /**
+      @return the number of compressed bytes written to the output stream
+    */
+    unsigned long getBytesOut();
+
+    virtual size_t write(uint8_t b);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    using Print::write; // pull in write(str)
+    /**
+      @return the output stream's availableForWrite() less the bytes waiting to be compressed, so writing that many will not block
+    */
+    virtual int availableForWrite();
+    /**
+      flushPoint() and then flush() the output stream
+    */
+    virtual void flush();
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+
+  private:
+    SafeStringLZOutput(const SafeStringLZOutput& other);
+    void encodeOne(); // encode the start of look[] as a match or a literal
+    size_t findMatch(size_t &distance); // longest match of the start of look[] in the window
+    uint8_t matchByte(size_t distance, size_t i); // byte i of the match starting distance back
+    void writeLiterals();
+    void addToWindow(const uint8_t *bytes, size_t len);
+    Stream *outPtr;
+    uint8_t window[SAFE_STRING_LZ_WINDOW];
+    uint16_t winPos; // next byte written here
+    uint16_t winCount; // bytes in the window, upto SAFE_STRING_LZ_WINDOW
+    uint8_t look[SAFE_STRING_LZ_MAX_MATCH]; // bytes waiting to be encoded
+    uint8_t lookLen;
+    uint8_t literals[SAFE_STRING_LZ_MAX_LITERALS]; // literals waiting to be sent
+    uint8_t literalLen;
+    unsigned long bytesIn;
+    unsigned long bytesOut;
+};
+
+class SafeStringLZInput : public Stream {
+  public:
+    /**
+      @param in -- the Stream the compressed bytes are read from, also used for write()
+    */
+    explicit SafeStringLZInput(Stream& in);
+
+    /**
+      Clears the window and any partly read token. The SafeStringLZOutput must also be reset()
+    */
+    void reset();
+
+    /**
+      @return the number of bytes that can be read now without reading more from the input stream, or 1 if the next byte has been read from it.
+    */
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+    /**
+      write( ) is not compressed, the bytes are written directly to the input stream
+    */
+    virtual size_t write(uint8_t b);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    using Print::write; // pull in write(str)
+    virtual int availableForWrite();
+    virtual void flush();
+
+  private:
+    SafeStringLZInput(const SafeStringLZInput& other);
+    bool nextOut(); // decode the next byte into nextByte, returns false if waiting for input
+    Stream *inPtr;
+    uint8_t window[SAFE_STRING_LZ_WINDOW];
+    uint16_t winPos; // next byte written here
+    uint8_t literalsLeft;
+    uint8_t matchLeft;
+    uint16_t matchDistance;
+    int matchToken; // first byte of a match, -1 if not waiting for the second byte
+    int nextByte; // -1 if not decoded yet
+};
+
+#include "SafeStringNameSpaceEnd.h"
+
+#endif  // __cplusplus
+#endif // SAFE_STRING_LZ_H
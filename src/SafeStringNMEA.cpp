@@ -0,0 +1,365 @@
+/*
+  SafeStringNMEA.cpp  a zero copy NMEA 0183 sentence parser
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+
+#include "SafeStringNMEA.h"
+
+#include "SafeStringNameSpace.h"
+
+// NMEA sentences are at most 82 chars, allow some extra for proprietary sentences,
+// but the offsets upto one past the end, length+1, must fit in the uint8_t fieldStart[]
+static const size_t NMEA_MAX_LENGTH = 254;
+
+static int nmeaHexValue(char c) {
+  if ((c >= '0') && (c <= '9')) {
+    return c - '0';
+  }
+  c |= 0x20; // to lower case
+  if ((c >= 'a') && (c <= 'f')) {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+SafeStringNMEA::SafeStringNMEA() {
+  sentencePtr = "";
+  type = NMEA_UNKNOWN;
+  valid = false;
+  fieldCount = 0;
+  fieldStart[0] = 0;
+}
+
+bool SafeStringNMEA::parse(SafeString &sentence, bool checksumRequired) {
+  return parse(sentence.c_str(), sentence.length(), checksumRequired);
+}
+
+bool SafeStringNMEA::parse(const char *sentence, size_t length, bool checksumRequired) {
+  valid = false;
+  type = NMEA_UNKNOWN;
+  fieldCount = 0;
+  sentencePtr = "";
+  if (sentence == NULL) {
+    return false;
+  }
+  // ignore trailing \r\n etc
+  while ((length > 0) && isspace(sentence[length - 1])) {
+    length--;
+  }
+  if ((length < 2) || (length > NMEA_MAX_LENGTH) || ((sentence[0] != '$') && (sentence[0] != '!'))) {
+    return false;
+  }
+  sentencePtr = sentence;
+
+  // one pass, xor the chars between $ and * while recording the start of each field
+  uint8_t sum = 0;
+  size_t i = 1;
+  fieldStart[0] = 1;
+  uint8_t count = 1;
+  bool tooManyFields = false;
+  for (; i < length; i++) {
+    char c = sentence[i];
+    if (c == '*') {
+      break;
+    }
+    sum ^= (uint8_t)c;
+    if (c == ',') {
+      if (count < NMEA_MAX_FIELDS) {
+        fieldStart[count++] = (uint8_t)(i + 1);
+      } else if (!tooManyFields) {
+        // extra fields are not indexed, end the last indexed field at this ,
+        fieldStart[count] = (uint8_t)(i + 1);
+        tooManyFields = true;
+      }
+    }
+  }
+  size_t endIdx = i; // the * or the end
+  if (!tooManyFields) {
+    fieldStart[count] = (uint8_t)(endIdx + 1);
+  }
+  fieldCount = count;
+
+  if (endIdx == length) {
+    // no checksum
+    if (checksumRequired) {
+      return false;
+    }
+  } else {
+    // need exactly 2 hex digits after the *
+    if ((length - endIdx) != 3) {
+      return false;
+    }
+    int hi = nmeaHexValue(sentence[endIdx + 1]);
+    int lo = nmeaHexValue(sentence[endIdx + 2]);
+    if ((hi < 0) || (lo < 0) || (((uint8_t)((hi << 4) | lo)) != sum)) {
+      return false;
+    }
+  }
+
+  SafeStringView address = field(0);
+  if (address.length() == 5) { // ttsss
+    const char *s = address.data() + 2;
+    if (memcmp(s, "GGA", 3) == 0) {
+      type = NMEA_GGA;
+    } else if (memcmp(s, "RMC", 3) == 0) {
+      type = NMEA_RMC;
+    } else if (memcmp(s, "VTG", 3) == 0) {
+      type = NMEA_VTG;
+    } else if (memcmp(s, "GSA", 3) == 0) {
+      type = NMEA_GSA;
+    }
+  }
+  valid = true;
+  return true;
+}
+
+bool SafeStringNMEA::isValid() {
+  return valid;
+}
+
+NMEASentenceType SafeStringNMEA::getType() {
+  return type;
+}
+
+SafeStringView SafeStringNMEA::getTalker() {
+  return field(0).subView(0, 2);
+}
+
+size_t SafeStringNMEA::getFieldCount() {
+  return fieldCount;
+}
+
+SafeStringView SafeStringNMEA::field(size_t idx) {
+  if (idx >= fieldCount) {
+    return SafeStringView();
+  }
+  size_t start = fieldStart[idx];
+  return SafeStringView(sentencePtr + start, fieldStart[idx + 1] - 1 - start);
+}
+
+bool SafeStringNMEA::getFixed(size_t idx, uint8_t decimals, long &result) {
+  return field(idx).toFixedPoint(result, decimals);
+}
+
+bool SafeStringNMEA::getTwoDigits(SafeStringView &v, size_t idx, uint8_t &result) {
+  char c1 = v.charAt(idx);
+  char c2 = v.charAt(idx + 1);
+  if ((!isdigit(c1)) || (!isdigit(c2))) {
+    return false;
+  }
+  result = (uint8_t)((c1 - '0') * 10 + (c2 - '0'));
+  return true;
+}
+
+// ddmm.mmmm or dddmm.mmmm followed by hemisphere field
+bool SafeStringNMEA::getDegrees(size_t idx, uint8_t degDigits, char negHemisphere, long &result) {
+  SafeStringView v = field(idx);
+  if (v.length() <= degDigits) {
+    return false;
+  }
+  long degs = 0;
+  for (uint8_t i = 0; i < degDigits; i++) {
+    char c = v.charAt(i);
+    if (!isdigit(c)) {
+      return false;
+    }
+    degs = degs * 10 + (c - '0');
+  }
+  long mins_e5 = 0;
+  if (!v.subView(degDigits).toFixedPoint(mins_e5, 5)) {
+    return false;
+  }
+  if ((mins_e5 < 0) || (mins_e5 >= 6000000L)) {
+    return false;
+  }
+  // 1 min = 10^7/60 deg_e7, mins_e5 * 100 < 6*10^8 so no overflow
+  long deg_e7 = degs * 10000000L + (mins_e5 * 100 + 30) / 60;
+  SafeStringView hemisphere = field(idx + 1);
+  if (hemisphere.charAt(0) == negHemisphere) {
+    deg_e7 = -deg_e7;
+  }
+  result = deg_e7;
+  return true;
+}
+
+bool SafeStringNMEA::getUTCTime(uint8_t &hours, uint8_t &minutes, uint8_t &seconds, uint16_t &milliseconds) {
+  if ((type != NMEA_GGA) && (type != NMEA_RMC)) {
+    return false;
+  }
+  SafeStringView v = field(1); // hhmmss.sss
+  uint8_t h, m, s;
+  if ((!getTwoDigits(v, 0, h)) || (!getTwoDigits(v, 2, m)) || (!getTwoDigits(v, 4, s))) {
+    return false;
+  }
+  uint16_t ms = 0;
+  if (v.length() > 6) {
+    if (v.charAt(6) != '.') {
+      return false;
+    }
+    uint16_t scale = 100;
+    for (size_t i = 7; i < v.length(); i++) {
+      char c = v.charAt(i);
+      if (!isdigit(c)) {
+        return false;
+      }
+      ms += (c - '0') * scale;
+      scale /= 10;
+    }
+  }
+  hours = h;
+  minutes = m;
+  seconds = s;
+  milliseconds = ms;
+  return true;
+}
+
+bool SafeStringNMEA::getDate(uint8_t &day, uint8_t &month, uint8_t &year) {
+  if (type != NMEA_RMC) {
+    return false;
+  }
+  SafeStringView v = field(9); // ddmmyy
+  uint8_t d, m, y;
+  if ((v.length() != 6) || (!getTwoDigits(v, 0, d)) || (!getTwoDigits(v, 2, m)) || (!getTwoDigits(v, 4, y))) {
+    return false;
+  }
+  day = d;
+  month = m;
+  year = y;
+  return true;
+}
+
+bool SafeStringNMEA::getLatitude(long &lat_e7) {
+  if (type == NMEA_GGA) {
+    return getDegrees(2, 2, 'S', lat_e7);
+  } else if (type == NMEA_RMC) {
+    return getDegrees(3, 2, 'S', lat_e7);
+  }
+  return false;
+}
+
+bool SafeStringNMEA::getLongitude(long &lon_e7) {
+  if (type == NMEA_GGA) {
+    return getDegrees(4, 3, 'W', lon_e7);
+  } else if (type == NMEA_RMC) {
+    return getDegrees(5, 3, 'W', lon_e7);
+  }
+  return false;
+}
+
+bool SafeStringNMEA::isActive() {
+  return ((type == NMEA_RMC) && (field(2).charAt(0) == 'A'));
+}
+
+bool SafeStringNMEA::getSpeedKnots(long &knots_x100) {
+  if (type == NMEA_RMC) {
+    return getFixed(7, 2, knots_x100);
+  } else if (type == NMEA_VTG) {
+    return getFixed(5, 2, knots_x100);
+  }
+  return false;
+}
+
+bool SafeStringNMEA::getSpeedKmh(long &kmh_x100) {
+  if (type == NMEA_VTG) {
+    return getFixed(7, 2, kmh_x100);
+  } else if (type == NMEA_RMC) {
+    long knots_x100 = 0;
+    if (!getFixed(7, 2, knots_x100)) {
+      return false;
+    }
+    kmh_x100 = (knots_x100 * 1852L + 500) / 1000; // 1 knot = 1.852 km/h
+    return true;
+  }
+  return false;
+}
+
+bool SafeStringNMEA::getCourse(long &degrees_x100) {
+  if (type == NMEA_RMC) {
+    return getFixed(8, 2, degrees_x100);
+  } else if (type == NMEA_VTG) {
+    return getFixed(1, 2, degrees_x100);
+  }
+  return false;
+}
+
+bool SafeStringNMEA::getFixQuality(uint8_t &quality) {
+  long q = 0;
+  if ((type != NMEA_GGA) || (!getFixed(6, 0, q)) || (q < 0) || (q > 255)) {
+    return false;
+  }
+  quality = (uint8_t)q;
+  return true;
+}
+
+bool SafeStringNMEA::getFixType(uint8_t &fixType) {
+  long f = 0;
+  if ((type != NMEA_GSA) || (!getFixed(2, 0, f)) || (f < 0) || (f > 255)) {
+    return false;
+  }
+  fixType = (uint8_t)f;
+  return true;
+}
+
+bool SafeStringNMEA::getSatellitesUsed(uint8_t &count) {
+  if (type == NMEA_GGA) {
+    long n = 0;
+    if ((!getFixed(7, 0, n)) || (n < 0) || (n > 255)) {
+      return false;
+    }
+    count = (uint8_t)n;
+    return true;
+  } else if (type == NMEA_GSA) {
+    uint8_t n = 0;
+    for (size_t i = 3; i <= 14; i++) {
+      if (!field(i).isEmpty()) {
+        n++;
+      }
+    }
+    count = n;
+    return true;
+  }
+  return false;
+}
+
+bool SafeStringNMEA::getSatelliteId(uint8_t idx, uint8_t &id) {
+  long n = 0;
+  if ((type != NMEA_GSA) || (idx > 11) || (!getFixed(3 + idx, 0, n)) || (n < 0) || (n > 255)) {
+    return false;
+  }
+  id = (uint8_t)n;
+  return true;
+}
+
+bool SafeStringNMEA::getAltitude(long &altitude_cm) {
+  if (type != NMEA_GGA) {
+    return false;
+  }
+  return getFixed(9, 2, altitude_cm);
+}
+
+bool SafeStringNMEA::getHDOP(long &hdop_x100) {
+  if (type == NMEA_GGA) {
+    return getFixed(8, 2, hdop_x100);
+  } else if (type == NMEA_GSA) {
+    return getFixed(16, 2, hdop_x100);
+  }
+  return false;
+}
+
+bool SafeStringNMEA::getPDOP(long &pdop_x100) {
+  if (type != NMEA_GSA) {
+    return false;
+  }
+  return getFixed(15, 2, pdop_x100);
+}
+
+bool SafeStringNMEA::getVDOP(long &vdop_x100) {
+  if (type != NMEA_GSA) {
+    return false;
+  }
+  return getFixed(17, 2, vdop_x100);
+}
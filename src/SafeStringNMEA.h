@@ -0,0 +1,160 @@
+#ifndef SAFE_STRING_NMEA_H
+#define SAFE_STRING_NMEA_H
+/*
+  SafeStringNMEA.h  a zero copy NMEA 0183 sentence parser
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+#ifdef __cplusplus
+#include <Arduino.h>
+#include "SafeString.h"
+#include "SafeStringView.h"
+
+// handle namespace arduino
+#include "SafeStringNameSpaceStart.h"
+
+// the maximum number of fields indexed, including the $GPxxx address field
+// GSV has 20, GSA has 19 (20 for NMEA 4.1). Any extra fields are still included in the checksum but cannot be accessed
+#define NMEA_MAX_FIELDS 24
+
+typedef enum { NMEA_UNKNOWN, NMEA_GGA, NMEA_RMC, NMEA_VTG, NMEA_GSA } NMEASentenceType;
+
+/**************
+  **SafeStringNMEA** checks and indexes an NMEA 0183 sentence in one pass and then converts its fields in place, see the detailed description.
+
+  <code>parse(sentence)</code> checks the *hh checksum in the same pass that records where each field starts.<br>
+  No fields are copied. The accessor methods convert the fields directly from the sentence text, using integer fixed point maths only,
+  so a 16Mhz board can keep up with 10Hz multi-constellation receivers.<br>
+  The sentence must not be changed while its fields are being accessed.<br>
+
+  Any talker ID is accepted, e.g. $GP (GPS), $GN (multi-constellation), $GL (GLONASS), $GA (Galileo), $GB/$BD (BeiDou).<br>
+  GGA, RMC, VTG and GSA sentences are decoded by the typed accessors. Other sentences can be read with <code>field(i)</code>.<br>
+  Each accessor returns false, and leaves its arguments unchanged, if this sentence type does not have that field or the field is empty or invalid.<br>
+  e.g.<br>
+<code>
+  SafeStringNMEA nmea;<br>
+  if (sfReader.read() && nmea.parse(sfReader)) {<br>
+  &nbsp;&nbsp;long lat_e7; long lon_e7;<br>
+  &nbsp;&nbsp;if (nmea.getLatitude(lat_e7) && nmea.getLongitude(lon_e7)) { ... }<br>
+  }<br>
+</code>
+****************************************************************************************/
+class SafeStringNMEA {
+  public:
+    SafeStringNMEA();
+
+    /**
+      parse(SafeString& sentence)
+      checks the checksum and indexes the fields of sentence, e.g. $GPRMC,194509.000,A,4042.6142,N,07400.4168,W,2.03,221.11,160412,,,A*77
+      Trailing white space, e.g. \\r\\n, is ignored. Sentences longer than 254 chars, without the trailing white space, are rejected.
+      @param sentence - the NMEA sentence starting with $ or !, not copied, so it must not change while the fields are accessed
+      @param checksumRequired - default true, if false a sentence without a *hh checksum is accepted, a *hh present is always checked
+      @return true if the sentence is well formed and the checksum matches
+    */
+    bool parse(SafeString &sentence, bool checksumRequired = true);
+    bool parse(const char *sentence, size_t length, bool checksumRequired = true);
+
+    /**
+      @return true if the last parse( ) succeeded
+    */
+    bool isValid();
+
+    /**
+      @return the type of the last sentence parsed, NMEA_UNKNOWN if invalid or not one of the decoded types
+    */
+    NMEASentenceType getType();
+
+    /**
+      @return the talker ID e.g. GP or GN
+    */
+    SafeStringView getTalker();
+
+    /**
+      @return the number of fields, including field 0 the address field e.g. GPRMC
+    */
+    size_t getFieldCount();
+
+    /**
+      field(idx)
+      @param idx - the field to return, 0 is the address field e.g. GPRMC, 1 is the first data field
+      @return a view of the field text, empty if idx >= getFieldCount()
+    */
+    SafeStringView field(size_t idx);
+
+    /**
+      UTC time of fix from GGA or RMC
+    */
+    bool getUTCTime(uint8_t &hours, uint8_t &minutes, uint8_t &seconds, uint16_t &milliseconds);
+    /**
+      UTC date from RMC, year is 2 digits
+    */
+    bool getDate(uint8_t &day, uint8_t &month, uint8_t &year);
+    /**
+      Latitude from GGA or RMC in degrees * 10^7, -ve for South
+    */
+    bool getLatitude(long &lat_e7);
+    /**
+      Longitude from GGA or RMC in degrees * 10^7, -ve for West
+    */
+    bool getLongitude(long &lon_e7);
+    /**
+      RMC status, true for A (active), false for V (void) or not RMC
+    */
+    bool isActive();
+    /**
+      Speed over ground from RMC or VTG in knots * 100
+    */
+    bool getSpeedKnots(long &knots_x100);
+    /**
+      Speed over ground from VTG (or RMC converted) in km/h * 100
+    */
+    bool getSpeedKmh(long &kmh_x100);
+    /**
+      Course over ground (true) from RMC or VTG in degrees * 100
+    */
+    bool getCourse(long &degrees_x100);
+    /**
+      GGA fix quality, 0 = no fix, 1 = GPS, 2 = DGPS ...
+    */
+    bool getFixQuality(uint8_t &quality);
+    /**
+      GSA fix type, 1 = no fix, 2 = 2D, 3 = 3D
+    */
+    bool getFixType(uint8_t &fixType);
+    /**
+      Number of satellites used, from GGA or counted from the GSA satellite IDs
+    */
+    bool getSatellitesUsed(uint8_t &count);
+    /**
+      GSA ID of the idx'th satellite used, idx 0 to 11
+    */
+    bool getSatelliteId(uint8_t idx, uint8_t &id);
+    /**
+      Altitude above mean sea level from GGA in cm
+    */
+    bool getAltitude(long &altitude_cm);
+    /**
+      Dilution of precision * 100,  HDOP from GGA or GSA,  PDOP and VDOP from GSA
+    */
+    bool getHDOP(long &hdop_x100);
+    bool getPDOP(long &pdop_x100);
+    bool getVDOP(long &vdop_x100);
+
+  private:
+    bool getDegrees(size_t idx, uint8_t degDigits, char negHemisphere, long &result);
+    bool getFixed(size_t idx, uint8_t decimals, long &result);
+    bool getTwoDigits(SafeStringView &v, size_t idx, uint8_t &result);
+    const char *sentencePtr;
+    NMEASentenceType type;
+    bool valid;
+    uint8_t fieldCount;
+    uint8_t fieldStart[NMEA_MAX_FIELDS + 1]; // fieldStart[fieldCount] is one past the , or * after the last field
+};
+
+#include "SafeStringNameSpaceEnd.h"
+
+#endif  // __cplusplus
+#endif // SAFE_STRING_NMEA_H
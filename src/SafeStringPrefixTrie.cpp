@@ -0,0 +1,182 @@
+/*
+  SafeStringPrefixTrie.cpp  longest prefix matching of a table of prefixes
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+
+#include "SafeStringPrefixTrie.h"
+
+#include "SafeStringNameSpace.h"
+
+SafeStringPrefixTrie::SafeStringPrefixTrie(SafeStringPrefixTrieNode *nodesBuf, size_t _maxNodes, const char *_name) {
+  nodes = nodesBuf;
+  maxNodes = _maxNodes;
+  if (maxNodes > 65535) {
+    maxNodes = 65535; // node indices are uint16_t
+  }
+  if (nodes == NULL) {
+    maxNodes = 0;
+  }
+  name = _name;
+  errorFlag = false;
+  clear();
+}
+
+void SafeStringPrefixTrie::clear() {
+  nodeCount = 0;
+  if (maxNodes > 0) {
+    // node 0 is the root, the empty prefix
+    nodes[0].firstChild = 0;
+    nodes[0].nextSibling = 0;
+    nodes[0].id = -1;
+    nodes[0].c = '\0';
+    nodeCount = 1;
+  }
+}
+
+size_t SafeStringPrefixTrie::nodesUsed() {
+  return nodeCount;
+}
+
+void SafeStringPrefixTrie::error(const __FlashStringHelper *msg) {
+  errorFlag = true;
+#ifdef SSTRING_DEBUG
+  SafeString::Output.print(F("Error: "));
+  if (name) {
+    SafeString::Output.print(name); SafeString::Output.print(' ');
+  }
+  SafeString::Output.println(msg);
+#else
+  (void)(msg);
+#endif // SSTRING_DEBUG
+}
+
+// returns 0 if node has no child for c
+uint16_t SafeStringPrefixTrie::findChild(uint16_t node, char c) {
+  uint16_t child = nodes[node].firstChild;
+  while (child != 0) {
+    if (nodes[child].c == c) {
+      return child;
+    }
+    child = nodes[child].nextSibling;
+  }
+  return 0;
+}
+
+bool SafeStringPrefixTrie::add(const SafeStringView &prefix, int16_t id) {
+  if (nodeCount == 0) {
+    error(F("add() no nodes"));
+    return false;
+  }
+  if (id < 0) {
+    error(F("add() id must be >= 0"));
+    return false;
+  }
+  const char *p = prefix.data();
+  size_t len = prefix.length();
+  // check there are enough nodes before changing anything
+  uint16_t node = 0;
+  size_t i = 0;
+  for (; i < len; i++) {
+    uint16_t child = findChild(node, p[i]);
+    if (child == 0) {
+      break;
+    }
+    node = child;
+  }
+  if ((nodeCount + (len - i)) > maxNodes) {
+    error(F("add() not enough nodes left for prefix"));
+    return false;
+  }
+  for (; i < len; i++) {
+    uint16_t child = (uint16_t)nodeCount++;
+    nodes[child].firstChild = 0;
+    nodes[child].nextSibling = nodes[node].firstChild;
+    nodes[child].id = -1;
+    nodes[child].c = p[i];
+    nodes[node].firstChild = child;
+    node = child;
+  }
+  nodes[node].id = id;
+  return true;
+}
+
+bool SafeStringPrefixTrie::add(const char *prefix, int16_t id) {
+  if (prefix == NULL) {
+    errorFlag = true;
+    return false;
+  }
+  return add(SafeStringView(prefix, strlen(prefix)), id);
+}
+
+bool SafeStringPrefixTrie::add(SafeString &prefix, int16_t id) {
+  return add(SafeStringView(prefix), id);
+}
+
+bool SafeStringPrefixTrie::addAll(const char *packedPrefixes) {
+  if (packedPrefixes == NULL) {
+    errorFlag = true;
+    return false;
+  }
+  int16_t id = 0;
+  const char *p = packedPrefixes;
+  while (*p != '\0') {
+    size_t len = strlen(p);
+    if (!add(SafeStringView(p, len), id++)) {
+      return false;
+    }
+    p += len + 1;
+  }
+  return true;
+}
+
+// one walk down the trie, remembering the last node with an id
+int SafeStringPrefixTrie::match(const char *input, size_t length, size_t &matchLen) {
+  matchLen = 0;
+  if ((nodeCount == 0) || (input == NULL)) {
+    return -1;
+  }
+  int result = nodes[0].id;
+  uint16_t node = 0;
+  for (size_t i = 0; i < length; i++) {
+    node = findChild(node, input[i]);
+    if (node == 0) {
+      break;
+    }
+    if (nodes[node].id >= 0) {
+      result = nodes[node].id;
+      matchLen = i + 1;
+    }
+  }
+  return result;
+}
+
+int SafeStringPrefixTrie::match(const SafeStringView &input, size_t &matchLen) {
+  return match(input.data(), input.length(), matchLen);
+}
+
+int SafeStringPrefixTrie::match(SafeString &input, size_t &matchLen) {
+  return match(input.c_str(), input.length(), matchLen);
+}
+
+int SafeStringPrefixTrie::match(SafeString &input) {
+  size_t matchLen;
+  return match(input.c_str(), input.length(), matchLen);
+}
+
+int SafeStringPrefixTrie::match(const char *input) {
+  if (input == NULL) {
+    return -1;
+  }
+  size_t matchLen;
+  return match(input, strlen(input), matchLen);
+}
+
+bool SafeStringPrefixTrie::hasError() {
+  bool rtn = errorFlag;
+  errorFlag = false;
+  return rtn;
+}
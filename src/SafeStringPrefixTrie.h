@@ -0,0 +1,122 @@
+#ifndef SAFE_STRING_PREFIX_TRIE_H
+#define SAFE_STRING_PREFIX_TRIE_H
+/*
+  SafeStringPrefixTrie.h  longest prefix matching of a table of prefixes
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+#ifdef __cplusplus
+#include <Arduino.h>
+#include "SafeString.h"
+#include "SafeStringView.h"
+
+// handle namespace arduino
+#include "SafeStringNameSpaceStart.h"
+
+/**
+  createSafeStringPrefixTrie( )
+  params
+    name - name of this SafeStringPrefixTrie variable (DO NOT use " " just use the plain name see the examples)
+    maxNodes - the maximum number of nodes, at most 1 + the total length of all the prefixes, less for shared leading chars.  Each node uses 7 bytes
+
+    example
+    createSafeStringPrefixTrie(routes, 20);
+    routes.add("AT+", 1); routes.add("$GP", 2);
+*/
+#define createSafeStringPrefixTrie(name, maxNodes) \
+  SafeStringPrefixTrieNode name ## _NODES_BUFFER[(maxNodes)]; \
+  SafeStringPrefixTrie name(name ## _NODES_BUFFER, (maxNodes), #name);
+
+// one char of a prefix, the children of a node are linked by nextSibling
+typedef struct {
+  uint16_t firstChild;  // 0 for none, the root node 0 is never a child
+  uint16_t nextSibling; // 0 for none
+  int16_t id;           // -1 if no prefix ends at this node
+  char c;
+} SafeStringPrefixTrieNode;
+
+/**************
+  To create a SafeStringPrefixTrie use the macro **createSafeStringPrefixTrie**  see the detailed description.
+
+  A SafeStringPrefixTrie holds a table of prefixes, e.g. "AT+", "$GP", "/api/v1/", each with an id.<br>
+  <code>match(input)</code> walks the input once, a char at a time, and returns the id of the longest prefix that input starts with.<br>
+  Prefixes with the same leading chars share nodes, so "/api/v1/led" and "/api/v1/status" only store "/api/v1/" once.<br>
+
+  The table is built with <code>add(prefix, id)</code>, or <code>addAll(packedPrefixes)</code> for a '\\0' separated constant list.<br>
+  The nodes are allocated statically by the create macro, add( ) returns false and raises an error if they run out.<br>
+  e.g.<br>
+<code>
+  createSafeStringPrefixTrie(routes, 40);<br>
+  routes.addAll("AT+\\0AT+CSQ\\0$GP\\0/api/v1/"); // ids 0,1,2,3<br>
+  size_t matchLen;<br>
+  int id = routes.match(sfLine, matchLen); // -1 if no prefix matches<br>
+  if (id >= 0) { sfLine.removeBefore(matchLen); ... }<br>
+</code>
+****************************************************************************************/
+class SafeStringPrefixTrie {
+  public:
+    // use createSafeStringPrefixTrie(name, maxNodes); instead of calling this constructor
+    explicit SafeStringPrefixTrie(SafeStringPrefixTrieNode *nodesBuf, size_t maxNodes, const char *name = NULL);
+
+    /**
+      add(prefix, id)
+      @param prefix - the prefix to add, "" matches every input
+      @param id - the id returned by match( ) for this prefix, 0 to 32767. Adding the same prefix again replaces its id
+      @return false, and raises an error, if there are not enough nodes left
+    */
+    bool add(const char *prefix, int16_t id);
+    bool add(SafeString &prefix, int16_t id);
+    bool add(const SafeStringView &prefix, int16_t id);
+    /**
+      addAll(packedPrefixes)
+      adds each of the '\\0' separated prefixes with ids 0,1,2.. in order, e.g. routes.addAll("AT+\\0$GP\\0/api/v1/");
+      Must be the first adds to this trie. The list ends at the first empty prefix, i.e. "\\0\\0"
+      @return false if not all the prefixes could be added
+    */
+    bool addAll(const char *packedPrefixes);
+
+    /**
+      removes all the prefixes
+    */
+    void clear();
+    /**
+      @return the number of nodes used
+    */
+    size_t nodesUsed();
+
+    /**
+      match(input, matchLen)
+      finds the longest prefix that input starts with, in one pass over input
+      @param input - the text to match
+      @param matchLen - set to the length of the prefix matched, 0 if none
+      @return the id of the longest matching prefix, -1 if none
+    */
+    int match(SafeString &input, size_t &matchLen);
+    int match(const SafeStringView &input, size_t &matchLen);
+    int match(const char *input, size_t length, size_t &matchLen);
+    int match(SafeString &input);
+    int match(const char *input);
+
+    /**
+      @return true if an error was detected since the last call to hasError( ), each call clears the error flag
+    */
+    bool hasError();
+
+  private:
+    SafeStringPrefixTrie(const SafeStringPrefixTrie& other); // no copies
+    uint16_t findChild(uint16_t node, char c);
+    void error(const __FlashStringHelper *msg);
+    SafeStringPrefixTrieNode *nodes;
+    size_t maxNodes;
+    size_t nodeCount;
+    const char *name;
+    bool errorFlag;
+};
+
+#include "SafeStringNameSpaceEnd.h"
+
+#endif  // __cplusplus
+#endif // SAFE_STRING_PREFIX_TRIE_H
@@ -0,0 +1,323 @@
+/*
+  SafeStringTable.cpp  a packed table of strings with sort and binary search
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+
+#include "SafeStringTable.h"
+
+#include "SafeStringNameSpace.h"
+
+// compare '\0' terminated s with the keyLen chars of key, as strcmp
+static int compareToKey(const char *s, const char *key, size_t keyLen) {
+  int rtn = strncmp(s, key, keyLen);
+  if (rtn != 0) {
+    return rtn;
+  }
+  return (s[keyLen] == '\0') ? 0 : 1; // s is longer
+}
+
+SafeStringTable::SafeStringTable(char *blobBuf, size_t _blobSize, uint16_t *offsetsBuf, size_t _maxStrings, const char *_name) {
+  blob = blobBuf;
+  writableBlob = blobBuf;
+  blobSize = _blobSize;
+  if (blobSize > 65535) {
+    blobSize = 65535; // offsets are uint16_t
+  }
+  offsets = offsetsBuf;
+  maxStrings = _maxStrings;
+  if ((blobBuf == NULL) || (offsetsBuf == NULL)) {
+    blob = "";
+    writableBlob = NULL;
+    blobSize = 0;
+    maxStrings = 0;
+  }
+  blobLen = 0;
+  count = 0;
+  name = _name;
+  sorted = true;
+  errorFlag = false;
+}
+
+SafeStringTable::SafeStringTable(const char *packedStrings, size_t packedSize, uint16_t *offsetsBuf, size_t _maxStrings, const char *_name) {
+  blob = packedStrings;
+  writableBlob = NULL;
+  blobSize = packedSize;
+  offsets = offsetsBuf;
+  maxStrings = _maxStrings;
+  if ((packedStrings == NULL) || (offsetsBuf == NULL)) {
+    blob = "";
+    blobSize = 0;
+    maxStrings = 0;
+  }
+  name = _name;
+  errorFlag = false;
+  indexPacked();
+}
+
+// find the start of each '\0' separated string, the last string ends with the terminating '\0' of packedStrings
+void SafeStringTable::indexPacked() {
+  count = 0;
+  blobLen = blobSize;
+  sorted = true;
+  size_t pos = 0;
+  while ((pos + 1) < blobSize) {
+    if (count >= maxStrings) {
+      error(F("more packed strings than maxStrings"));
+      break;
+    }
+    if (pos > 65535) {
+      error(F("packed strings longer than 65535"));
+      break;
+    }
+    offsets[count++] = (uint16_t)pos;
+    pos += strlen(blob + pos) + 1;
+  }
+  sorted = (count < 2);
+}
+
+void SafeStringTable::error(const __FlashStringHelper *msg) {
+  errorFlag = true;
+#ifdef SSTRING_DEBUG
+  SafeString::Output.print(F("Error: "));
+  if (name) {
+    SafeString::Output.print(name); SafeString::Output.print(' ');
+  }
+  SafeString::Output.println(msg);
+#else
+  (void)(msg);
+#endif // SSTRING_DEBUG
+}
+
+bool SafeStringTable::addChars(const char *str, size_t len) {
+  if (writableBlob == NULL) {
+    error(F("add() not allowed for packed strings"));
+    return false;
+  }
+  if (count >= maxStrings) {
+    error(F("add() table already has maxStrings"));
+    return false;
+  }
+  if ((blobLen + len + 1) > blobSize) {
+    error(F("add() not enough space left for string"));
+    return false;
+  }
+  memmove(writableBlob + blobLen, str, len);
+  writableBlob[blobLen + len] = '\0';
+  offsets[count++] = (uint16_t)blobLen;
+  blobLen += len + 1;
+  sorted = (count < 2);
+  return true;
+}
+
+bool SafeStringTable::add(const char *str) {
+  if (str == NULL) {
+    errorFlag = true;
+    return false;
+  }
+  return addChars(str, strlen(str));
+}
+
+bool SafeStringTable::add(SafeString &str) {
+  return addChars(str.c_str(), str.length());
+}
+
+bool SafeStringTable::add(const SafeStringView &str) {
+  if (memchr(str.data(), '\0', str.length()) != NULL) {
+    errorFlag = true; // would split into two strings
+    return false;
+  }
+  return addChars(str.data(), str.length());
+}
+
+bool SafeStringTable::addList(SafeString &list, const char *delimiters) {
+  if (delimiters == NULL) {
+    errorFlag = true;
+    return false;
+  }
+  const char *p = list.c_str();
+  size_t len = list.length();
+  size_t start = 0;
+  bool rtn = true;
+  for (size_t i = 0; i <= len; i++) {
+    if ((i == len) || (strchr(delimiters, p[i]) != NULL)) {
+      if (i > start) {
+        if (!addChars(p + start, i - start)) {
+          rtn = false;
+          break;
+        }
+      }
+      start = i + 1;
+    }
+  }
+  return rtn;
+}
+
+size_t SafeStringTable::size() {
+  return count;
+}
+
+size_t SafeStringTable::blobUsed() {
+  return blobLen;
+}
+
+void SafeStringTable::clear() {
+  if (writableBlob == NULL) {
+    indexPacked();
+    return;
+  }
+  count = 0;
+  blobLen = 0;
+  sorted = true;
+}
+
+SafeStringView SafeStringTable::get(size_t idx) {
+  if (idx >= count) {
+    return SafeStringView();
+  }
+  const char *s = blob + offsets[idx];
+  return SafeStringView(s, strlen(s));
+}
+
+const char *SafeStringTable::c_str(size_t idx) {
+  if (idx >= count) {
+    return "";
+  }
+  return blob + offsets[idx];
+}
+
+void SafeStringTable::siftDown(size_t root, size_t end) {
+  uint16_t rootOffset = offsets[root];
+  const char *rootStr = blob + rootOffset;
+  while (true) {
+    size_t child = 2 * root + 1;
+    if (child >= end) {
+      break;
+    }
+    if (((child + 1) < end) && (strcmp(blob + offsets[child], blob + offsets[child + 1]) < 0)) {
+      child++;
+    }
+    if (strcmp(rootStr, blob + offsets[child]) >= 0) {
+      break;
+    }
+    offsets[root] = offsets[child];
+    root = child;
+  }
+  offsets[root] = rootOffset;
+}
+
+// heap sort the offsets, O(n log n) compares, no recursion or extra RAM
+void SafeStringTable::sort() {
+  if (sorted) {
+    return;
+  }
+  for (size_t i = count / 2; i > 0; i--) {
+    siftDown(i - 1, count);
+  }
+  for (size_t end = count - 1; end > 0; end--) {
+    uint16_t tmp = offsets[0];
+    offsets[0] = offsets[end];
+    offsets[end] = tmp;
+    siftDown(0, end);
+  }
+  sorted = true;
+}
+
+bool SafeStringTable::isSorted() {
+  return sorted;
+}
+
+// index of the first string >= key
+size_t SafeStringTable::lowerBound(const char *key, size_t keyLen) {
+  size_t lo = 0;
+  size_t hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (compareToKey(blob + offsets[mid], key, keyLen) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+int SafeStringTable::indexOf(const char *key) {
+  if (key == NULL) {
+    return -1;
+  }
+  return indexOf(SafeStringView(key, strlen(key)));
+}
+
+int SafeStringTable::indexOf(SafeString &key) {
+  return indexOf(SafeStringView(key));
+}
+
+int SafeStringTable::indexOf(const SafeStringView &key) {
+  if (sorted) {
+    size_t idx = lowerBound(key.data(), key.length());
+    if ((idx < count) && (compareToKey(blob + offsets[idx], key.data(), key.length()) == 0)) {
+      return (int)idx;
+    }
+    return -1;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (compareToKey(blob + offsets[i], key.data(), key.length()) == 0) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+int SafeStringTable::findPrefix(const char *prefix, size_t &prefixCount) {
+  if (prefix == NULL) {
+    prefixCount = 0;
+    return -1;
+  }
+  return findPrefix(SafeStringView(prefix, strlen(prefix)), prefixCount);
+}
+
+int SafeStringTable::findPrefix(const SafeStringView &prefix, size_t &prefixCount) {
+  prefixCount = 0;
+  if (!sorted) {
+    error(F("findPrefix() table not sorted"));
+    return -1;
+  }
+  const char *key = prefix.data();
+  size_t keyLen = prefix.length();
+  size_t first = lowerBound(key, keyLen);
+  // first string after first that does not start with prefix
+  size_t lo = first;
+  size_t hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (strncmp(blob + offsets[mid], key, keyLen) == 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == first) {
+    return -1;
+  }
+  prefixCount = lo - first;
+  return (int)first;
+}
+
+size_t SafeStringTable::printTo(Print &p) const {
+  size_t n = 0;
+  for (size_t i = 0; i < count; i++) {
+    n += p.print(blob + offsets[i]);
+    n += p.println();
+  }
+  return n;
+}
+
+bool SafeStringTable::hasError() {
+  bool rtn = errorFlag;
+  errorFlag = false;
+  return rtn;
+}
@@ -0,0 +1,175 @@
+#ifndef SAFE_STRING_TABLE_H
+#define SAFE_STRING_TABLE_H
+/*
+  SafeStringTable.h  a packed table of strings with sort and binary search
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+#ifdef __cplusplus
+#include <Arduino.h>
+#include "SafeString.h"
+#include "SafeStringView.h"
+
+// handle namespace arduino
+#include "SafeStringNameSpaceStart.h"
+
+/**
+  createSafeStringTable( )
+  params
+    name - name of this SafeStringTable variable (DO NOT use " " just use the plain name see the examples)
+    maxStrings - the maximum number of strings in the table
+    blobSize - the total number of chars available for the strings, including one '\\0' after each string, max 65535
+
+    example
+    createSafeStringTable(names, 20, 200);
+    This creates a SafeStringTable names which can hold upto 20 strings with a total length of 200 chars, including the '\\0' terminators
+*/
+#define createSafeStringTable(name, maxStrings, blobSize) \
+  char name ## _BLOB_BUFFER[(blobSize)]; \
+  uint16_t name ## _OFFSETS_BUFFER[(maxStrings)]; \
+  SafeStringTable name(name ## _BLOB_BUFFER, (blobSize), name ## _OFFSETS_BUFFER, (maxStrings), #name);
+
+/**
+  createSafeStringTableFromPacked( )
+  params
+    name - name of this SafeStringTable variable (DO NOT use " " just use the plain name see the examples)
+    maxStrings - the maximum number of strings in the table
+    packedStrings - a const char[] or string literal of strings separated by '\\0'. It is not copied and strings cannot be added to the table.
+
+    example
+    createSafeStringTableFromPacked(cmds, 4, "start\0stop\0status\0reset");
+    This creates a SafeStringTable cmds of the 4 strings. Only the offset of each string is stored in RAM
+*/
+#define createSafeStringTableFromPacked(name, maxStrings, packedStrings) \
+  uint16_t name ## _OFFSETS_BUFFER[(maxStrings)]; \
+  SafeStringTable name((packedStrings), sizeof(packedStrings), name ## _OFFSETS_BUFFER, (maxStrings), #name);
+
+/**************
+  To create a SafeStringTable use one of the macros **createSafeStringTable** or **createSafeStringTableFromPacked**  see the detailed description.
+
+  A SafeStringTable holds its strings one after the other in a single char[], each followed by '\\0', plus one uint16_t offset for each string.<br>
+  Unlike an char[][xx] array, no space is wasted padding short strings to the longest length.<br>
+
+  After <code>sort()</code> the table can be searched with a binary search,
+  so <code>indexOf(key)</code> takes about log2(size()) string compares instead of one compare per entry.<br>
+  <code>sort()</code> only moves the offsets, the strings themselves are not moved, and uses no extra memory.<br>
+  <code>findPrefix(prefix, count)</code> returns the first string, in sorted order, starting with prefix and the number of strings that start with it.<br>
+  Adding a string marks the table unsorted, indexOf( ) then falls back to a linear search until sort( ) is called again.<br>
+
+  <code>get(i)</code> returns a SafeStringView of the i'th string, so the strings can be iterated, compared and printed without copying.<br>
+  e.g.<br>
+<code>
+  createSafeStringTableFromPacked(cmds, 4, "start\\0stop\\0status\\0reset");<br>
+  cmds.sort();<br>
+  int idx = cmds.indexOf(sfToken); // -1 if not found<br>
+</code>
+****************************************************************************************/
+class SafeStringTable : public Printable {
+  public:
+    // use createSafeStringTable(name, maxStrings, blobSize); instead of calling this constructor
+    explicit SafeStringTable(char *blobBuf, size_t blobSize, uint16_t *offsetsBuf, size_t maxStrings, const char *name = NULL);
+    // use createSafeStringTableFromPacked(name, maxStrings, packedStrings); instead of calling this constructor
+    explicit SafeStringTable(const char *packedStrings, size_t packedSize, uint16_t *offsetsBuf, size_t maxStrings, const char *name = NULL);
+
+    /**
+      add a copy of str to the end of the table
+      @return false, and raises an error, if there is no space left or the table was created from packed strings
+    */
+    bool add(const char *str);
+    bool add(SafeString &str);
+    bool add(const SafeStringView &str);
+    /**
+      addList(list, delimiters)
+      adds each token in list, separated by any of the delimiters, e.g. names.addList(sfNames, ",");
+      Empty tokens are skipped.
+      @return false, and raises an error, if not all the tokens could be added
+    */
+    bool addList(SafeString &list, const char *delimiters);
+
+    /**
+      @return the number of strings in the table
+    */
+    size_t size();
+    /**
+      @return the number of blob chars used, including the '\\0' terminators
+    */
+    size_t blobUsed();
+    /**
+      removes all the strings, the strings from createSafeStringTableFromPacked are restored instead
+    */
+    void clear();
+
+    /**
+      @return a view of the idx'th string, empty if idx >= size()
+    */
+    SafeStringView get(size_t idx);
+    /**
+      @return the idx'th string, "" if idx >= size()
+    */
+    const char *c_str(size_t idx);
+
+    /**
+      sorts the offsets so that the strings are in strcmp order.  Heap sort, in place, with no recursion
+    */
+    void sort();
+    /**
+      @return true if the table is sorted
+    */
+    bool isSorted();
+
+    /**
+      indexOf(key)
+      binary search if sorted, else a linear search
+      @return the index of key in the table, -1 if not found. If there are duplicates, any one of them may be returned
+    */
+    int indexOf(const char *key);
+    int indexOf(SafeString &key);
+    int indexOf(const SafeStringView &key);
+
+    /**
+      findPrefix(prefix, count)
+      the table must be sorted, then all the strings starting with prefix are next to each other
+      @param prefix - the prefix to search for, "" matches every string
+      @param count - set to the number of strings starting with prefix
+      @return the index of the first string starting with prefix, -1 (and count 0) if none or the table is not sorted
+    */
+    int findPrefix(const char *prefix, size_t &count);
+    int findPrefix(const SafeStringView &prefix, size_t &count);
+
+    /**
+      Implements the Printable interface, prints the strings one per line
+      @param p - where to print to
+    */
+    size_t printTo(Print &p) const;
+
+    /**
+      @return true if an error was detected since the last call to hasError( ), each call clears the error flag
+    */
+    bool hasError();
+
+  private:
+    SafeStringTable(const SafeStringTable& other); // no copies
+    void indexPacked();
+    bool addChars(const char *str, size_t len);
+    size_t lowerBound(const char *key, size_t keyLen);
+    void siftDown(size_t root, size_t end);
+    void error(const __FlashStringHelper *msg);
+    const char *blob;
+    char *writableBlob; // NULL for packed strings
+    size_t blobSize;
+    size_t blobLen;
+    uint16_t *offsets;
+    size_t maxStrings;
+    size_t count;
+    const char *name;
+    bool sorted;
+    bool errorFlag;
+};
+
+#include "SafeStringNameSpaceEnd.h"
+
+#endif  // __cplusplus
+#endif // SAFE_STRING_TABLE_H
@@ -0,0 +1,295 @@
+/*
+  SafeStringView.cpp  a read only, zero copy view of part of a SafeString or char[]
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+
+#include "SafeStringView.h"
+#include <limits.h>
+
+#include "SafeStringNameSpace.h"
+
+SafeStringView::SafeStringView() {
+  ptr = "";
+  len = 0;
+}
+
+SafeStringView::SafeStringView(const char *_ptr, size_t _len) {
+  ptr = _ptr;
+  len = _len;
+  if (ptr == NULL) {
+    ptr = "";
+    len = 0;
+  }
+}
+
+SafeStringView::SafeStringView(SafeString &str, size_t fromIndex, size_t _len) {
+  size_t strLen = str.length();
+  ptr = str.c_str();
+  if (fromIndex > strLen) {
+    fromIndex = strLen;
+  }
+  ptr += fromIndex;
+  len = strLen - fromIndex;
+  if (_len < len) {
+    len = _len;
+  }
+}
+
+size_t SafeStringView::length() const {
+  return len;
+}
+
+bool SafeStringView::isEmpty() const {
+  return (len == 0);
+}
+
+const char* SafeStringView::data() const {
+  return ptr;
+}
+
+char SafeStringView::charAt(size_t index) const {
+  if (index >= len) {
+    return '\0';
+  }
+  return ptr[index];
+}
+
+char SafeStringView::operator [] (size_t index) const {
+  return charAt(index);
+}
+
+SafeStringView SafeStringView::subView(size_t beginIdx, size_t endIdx) const {
+  if (endIdx > len) {
+    endIdx = len;
+  }
+  if (beginIdx > endIdx) {
+    beginIdx = endIdx;
+  }
+  return SafeStringView(ptr + beginIdx, endIdx - beginIdx);
+}
+
+unsigned char SafeStringView::equals(const char *cstr) const {
+  if (cstr == NULL) {
+    return false;
+  }
+  return ((strncmp(ptr, cstr, len) == 0) && (cstr[len] == '\0'));
+}
+
+unsigned char SafeStringView::equals(SafeString &str) const {
+  return ((str.length() == len) && (memcmp(ptr, str.c_str(), len) == 0));
+}
+
+unsigned char SafeStringView::equals(const SafeStringView &other) const {
+  return ((other.len == len) && (memcmp(ptr, other.ptr, len) == 0));
+}
+
+unsigned char SafeStringView::equalsIgnoreCase(const char *cstr) const {
+  if (cstr == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i < len; i++) {
+    if ((cstr[i] == '\0') || (tolower(ptr[i]) != tolower(cstr[i]))) {
+      return false;
+    }
+  }
+  return (cstr[len] == '\0');
+}
+
+unsigned char SafeStringView::startsWith(const char *cstr) const {
+  if (cstr == NULL) {
+    return false;
+  }
+  size_t cLen = strlen(cstr);
+  return ((cLen <= len) && (memcmp(ptr, cstr, cLen) == 0));
+}
+
+unsigned char SafeStringView::endsWith(const char *cstr) const {
+  if (cstr == NULL) {
+    return false;
+  }
+  size_t cLen = strlen(cstr);
+  return ((cLen <= len) && (memcmp(ptr + len - cLen, cstr, cLen) == 0));
+}
+
+int SafeStringView::compareTo(const SafeStringView &other) const {
+  size_t n = (len < other.len) ? len : other.len;
+  int rtn = memcmp(ptr, other.ptr, n);
+  if (rtn != 0) {
+    return rtn;
+  }
+  if (len == other.len) {
+    return 0;
+  }
+  return ((len < other.len) ? -1 : 1);
+}
+
+int SafeStringView::indexOf(char c, size_t fromIndex) const {
+  if (fromIndex >= len) {
+    return -1;
+  }
+  const char *p = (const char*)memchr(ptr + fromIndex, c, len - fromIndex);
+  if (p == NULL) {
+    return -1;
+  }
+  return (int)(p - ptr);
+}
+
+// numbers are short so copy to a small '\0' terminated buffer and use the std conversions
+bool SafeStringView::toNumberBuffer(char *buf, size_t bufSize) const {
+  if ((len == 0) || (len >= bufSize)) {
+    return false;
+  }
+  memcpy(buf, ptr, len);
+  buf[len] = '\0';
+  return true;
+}
+
+// true if only trailing white space after the number
+static bool viewNumberEnd(const char *buf, const char *endPtr) {
+  if (endPtr == buf) {
+    return false; // no numbers found at all
+  }
+  while (*endPtr != '\0') {
+    if (!isspace(*endPtr)) {
+      return false;
+    }
+    endPtr++;
+  }
+  return true;
+}
+
+unsigned char SafeStringView::toLong(long &l) const {
+  char buf[24];
+  if (!toNumberBuffer(buf, sizeof(buf))) {
+    return false;
+  }
+  char *endPtr;
+  long result = strtol(buf, &endPtr, 10);
+  if ((result == LONG_MAX) || (result == LONG_MIN) || (!viewNumberEnd(buf, endPtr))) {
+    return false;
+  }
+  l = result;
+  return true;
+}
+
+unsigned char SafeStringView::toUnsignedLong(unsigned long &l) const {
+  char buf[24];
+  if ((!toNumberBuffer(buf, sizeof(buf))) || (buf[0] == '-')) {
+    return false;
+  }
+  char *endPtr;
+  unsigned long result = strtoul(buf, &endPtr, 10);
+  if ((result == ULONG_MAX) || (!viewNumberEnd(buf, endPtr))) {
+    return false;
+  }
+  l = result;
+  return true;
+}
+
+unsigned char SafeStringView::hexToLong(long &l) const {
+  char buf[24];
+  if (!toNumberBuffer(buf, sizeof(buf))) {
+    return false;
+  }
+  char *endPtr;
+  long result = strtol(buf, &endPtr, 16);
+  if ((result == LONG_MAX) || (result == LONG_MIN) || (!viewNumberEnd(buf, endPtr))) {
+    return false;
+  }
+  l = result;
+  return true;
+}
+
+unsigned char SafeStringView::toDouble(double &d) const {
+  char buf[32];
+  if (!toNumberBuffer(buf, sizeof(buf))) {
+    return false;
+  }
+  char *endPtr;
+  double result = strtod(buf, &endPtr);
+  if (!viewNumberEnd(buf, endPtr)) {
+    return false;
+  }
+  d = result;
+  return true;
+}
+
+unsigned char SafeStringView::toFloat(float &f) const {
+  double d = 0.0;
+  if (!toDouble(d)) {
+    return false;
+  }
+  f = (float)d;
+  return true;
+}
+
+unsigned char SafeStringView::toFixedPoint(long &l, uint8_t decimals) const {
+  size_t i = 0;
+  bool neg = false;
+  if ((i < len) && ((ptr[i] == '-') || (ptr[i] == '+'))) {
+    neg = (ptr[i] == '-');
+    i++;
+  }
+  unsigned long result = 0;
+  const unsigned long limit = ((unsigned long)LONG_MAX) / 10;
+  bool haveDigits = false;
+  bool inFraction = false;
+  uint8_t fractionDigits = 0;
+  for (; i < len; i++) {
+    char c = ptr[i];
+    if ((c == '.') && (!inFraction)) {
+      inFraction = true;
+      continue;
+    }
+    if (!isdigit(c)) {
+      break;
+    }
+    haveDigits = true;
+    if (inFraction) {
+      if (fractionDigits >= decimals) {
+        continue; // truncate extra decimals
+      }
+      fractionDigits++;
+    }
+    if (result > limit) {
+      return false;
+    }
+    result = result * 10 + (c - '0');
+  }
+  // only trailing white space allowed
+  for (; i < len; i++) {
+    if (!isspace(ptr[i])) {
+      return false;
+    }
+  }
+  if (!haveDigits) {
+    return false;
+  }
+  for (; fractionDigits < decimals; fractionDigits++) {
+    if (result > limit) {
+      return false;
+    }
+    result *= 10;
+  }
+  if (result > (unsigned long)LONG_MAX) {
+    return false;
+  }
+  l = neg ? -((long)result) : (long)result;
+  return true;
+}
+
+SafeString& SafeStringView::copyTo(SafeString &result) const {
+  result.clear();
+  if (len) {
+    result.concat(ptr, len);
+  }
+  return result;
+}
+
+size_t SafeStringView::printTo(Print& p) const {
+  return p.write((const uint8_t*)ptr, len);
+}
@@ -0,0 +1,116 @@
+#ifndef SAFE_STRING_VIEW_H
+#define SAFE_STRING_VIEW_H
+/*
+  SafeStringView.h  a read only, zero copy view of part of a SafeString or char[]
+  by Matthew Ford
+  (c)2020 Forward Computing and Control Pty. Ltd.
+  This code is not warranted to be fit for any purpose. You may only use it at your own risk.
+  This code may be freely used for both private and commercial use.
+  Provide this copyright is maintained.
+**/
+#ifdef __cplusplus
+#include <Arduino.h>
+#include "SafeString.h"
+
+// handle namespace arduino
+#include "SafeStringNameSpaceStart.h"
+
+/**************
+  A **SafeStringView** refers to a run of chars inside an existing SafeString or char[] without copying them, see the detailed description.
+
+  Unlike wrapping part of a buffer with cSFPS( ), a SafeStringView never writes a terminating '\\0' into the underlying buffer,
+  so many views can refer to the fields of one line at the same time. This makes them useful as the result of the
+  one pass field indexers, e.g. SafeStringNMEA.<br>
+  The view is only valid while the underlying SafeString or char[] is unchanged.<br>
+
+  Out of range indices are clipped to the view, so an invalid view is just empty.<br>
+  The number conversions follow the SafeString rules, the whole view must be a valid number, trailing white space is ignored.<br>
+  Use <code>copyTo(sfResult)</code> to copy the view into a SafeString.
+****************************************************************************************/
+class SafeStringView : public Printable {
+  public:
+    /*****************
+      An empty view
+    ***************/
+    SafeStringView();
+    /*****************
+      A view of len chars starting at ptr. ptr need not be '\\0' terminated.
+      @param ptr - the first char of the view, NULL gives an empty view
+      @param len - the number of chars in the view
+    ***************/
+    SafeStringView(const char *ptr, size_t len);
+    /*****************
+      A view of upto len chars of a SafeString starting at fromIndex, clipped to the SafeString's length.
+      @param str - the SafeString to view
+      @param fromIndex - index of the first char of the view
+      @param len - the number of chars in the view, default all the rest of str
+    ***************/
+    SafeStringView(SafeString &str, size_t fromIndex = 0, size_t len = ((size_t)-1));
+
+    /*****************
+      @return the number of chars in this view
+    ***************/
+    size_t length() const;
+    /*****************
+      @return true if this view has no chars
+    ***************/
+    bool isEmpty() const;
+    /*****************
+      @return a pointer to the first char of the view. This is NOT '\\0' terminated, use length()
+    ***************/
+    const char* data() const;
+    /*****************
+      @return the char at index, or '\\0' if index >= length()
+    ***************/
+    char charAt(size_t index) const;
+    char operator [] (size_t index) const;
+    /*****************
+      @return a view of the chars from beginIdx to endIdx (exclusive), clipped to this view, like SafeString::substring( )
+    ***************/
+    SafeStringView subView(size_t beginIdx, size_t endIdx = ((size_t)-1)) const;
+
+    unsigned char equals(const char *cstr) const;
+    unsigned char equals(SafeString &str) const;
+    unsigned char equals(const SafeStringView &other) const;
+    unsigned char equalsIgnoreCase(const char *cstr) const;
+    unsigned char startsWith(const char *cstr) const;
+    unsigned char endsWith(const char *cstr) const;
+    int compareTo(const SafeStringView &other) const; // as for strcmp, shorter views sort first
+    int indexOf(char c, size_t fromIndex = 0) const;
+
+    // number conversions, return false and leave the argument unchanged if the view is not a valid number
+    unsigned char toLong(long &l) const;
+    unsigned char toUnsignedLong(unsigned long &l) const;
+    unsigned char hexToLong(long &l) const;
+    unsigned char toDouble(double &d) const;
+    unsigned char toFloat(float &f) const;
+    /*****************
+      Converts a decimal number to a fixed point long without using floating point, e.g. "12.345" with decimals 2 gives 1234.
+      Extra decimal digits are truncated.
+      @param l - set to the number * 10^decimals
+      @param decimals - number of decimal places to keep
+      @return false, l unchanged, if the view is not a valid decimal number or the result overflows a long
+    ***************/
+    unsigned char toFixedPoint(long &l, uint8_t decimals) const;
+
+    /*****************
+      Clears result and copies this view into it.  result is left empty and flags an error if the view does not fit.
+    ***************/
+    SafeString& copyTo(SafeString &result) const;
+
+    /*****************
+      Implements the Printable interface
+      @param p - where to print to
+    ***************/
+    size_t printTo(Print& p) const;
+
+  private:
+    bool toNumberBuffer(char *buf, size_t bufSize) const; // copy to a '\0' terminated buf for strtol etc
+    const char *ptr;
+    size_t len;
+};
+
+#include "SafeStringNameSpaceEnd.h"
+
+#endif  // __cplusplus
+#endif // SAFE_STRING_VIEW_H
@@ -54,6 +54,7 @@ SerialComs::SerialComs(size_t sendSize, size_t receiveSize) : SafeString(1, empt
   clearToSendFlag = false;
   isController = false;
   notUsingCheckSum = false;
+  usingCRC8 = false;
   stream_io_ptr = NULL;
   receive_INPUT_BUFFER = NULL;
   receiver_TOKEN_BUFFER = NULL;
@@ -75,6 +76,12 @@ void SerialComs::noCheckSum() {
   notUsingCheckSum = true;
 }
 
+// this uses a CRC-8 instead of the MOD256 checksum, both sides must have the same setting.
+// still sent as 2 hex chars
+void SerialComs::useCRC8() {
+  usingCRC8 = true;
+}
+
 // alised to 'variable' textReceived
 SafeString& SerialComs::getTextReceived() {
   if ((outOfMemory) || (stream_io_ptr == NULL)) {
@@ -371,11 +378,17 @@ void SerialComs::calcCheckSum(SafeString& msg, SafeString& chkHexStr) {
   if ((msg.isEmpty()) || (!(!notUsingCheckSum))) {
     return;
   }
-  int chksum = 0;
-  for (size_t i = 0; i < msg.length(); i++) {
-    chksum += msg[i];
+  // work on the buffer directly, msg[i] does a cleanUp and bounds check for every char
+  const uint8_t *msgBytes = (const uint8_t*)msg.c_str();
+  size_t msgLen = msg.length();
+  uint8_t chksum = 0;
+  if (usingCRC8) {
+    chksum = SafeStringCRC8::calc(msgBytes, msgLen);
+  } else {
+    for (size_t i = 0; i < msgLen; i++) {
+      chksum += msgBytes[i]; // uint8_t keeps last 1 byte only, i.e. MOD256
+    }
   }
-  chksum = chksum % 256; // keep last 1 byte only
   if (chksum < 16) {
     chkHexStr += '0';
   }
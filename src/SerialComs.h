@@ -11,6 +11,7 @@
 // SafeStringReader.h include defines for Stream
 #include "SafeStringReader.h"
 #include "millisDelay.h"
+#include "SafeStringCRC.h"
 
 
 // This class uses the SafeString::Output for debug and error messages.
@@ -119,6 +120,10 @@ class SerialComs : public SafeString {
     // need to do the same on the other side as well.
     void noCheckSum();
 
+    // calling useCRC8() uses a CRC-8 instead of the default MOD256 checksum.
+    // It detects more errors, e.g. swapped chars, but the other side must call useCRC8() as well.
+    void useCRC8();
+
     ~SerialComs(); // frees memory
   private:
     char *receive_INPUT_BUFFER;
@@ -143,6 +148,7 @@ class SerialComs : public SafeString {
     bool clearToSendFlag;
     bool isController;
     bool notUsingCheckSum;
+    bool usingCRC8;
 
     millisDelay connectionTimeout;
     bool outOfMemory;